@@ -0,0 +1,105 @@
+/**
+ * Benchmark of the frame codec - compression ratio against raw and csv frames and throughput
+ * of encoding and decoding. Frames are a synthetic history built from the real initial.csv,
+ * every day only a small part of the cities changes its counters.
+ * Run from the ROOT folder of the app (make bench_codec).
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "../../C/simulation/simulation.h"
+#include "../../C/simulation/fileManager.h"
+#include "../../C/simulation/frameCodec.h"
+
+#define DAYS 365
+#define REPEATS 5
+/* part of the cities which counters change every day */
+#define CHANGED_CITIES 0.05
+
+/**
+ * Returns time of the monotonic clock in seconds
+ * @return seconds
+ */
+double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(void) {
+    country *ctry;
+    int **frames, *decoded;
+    unsigned char *buffer;
+    size_t encoded = 0, csv = 0, length;
+    double start, encodeTime = 0, decodeTime = 0;
+    int n, day, i, repeat;
+    char row[FRAME_CSV_MAX_ROW];
+
+    srand(42);
+    ctry = create_country_from_csv(SIMULATION_INI_CSV, 0);
+    if (!ctry) {
+        fprintf(stderr, "Error: Could not create country from %s\n", SIMULATION_INI_CSV);
+        return EXIT_FAILURE;
+    }
+
+    //frame is population of all the cities followed by infected of all the cities
+    n = ctry->numberOfCities;
+    frames = malloc(DAYS * sizeof(int *));
+    for (day = 0; day < DAYS; day++) {
+        frames[day] = malloc(2 * n * sizeof(int));
+        if (!day) snapshotCountry(ctry, frames[day], frames[day] + n);
+        else memcpy(frames[day], frames[day - 1], 2 * n * sizeof(int));
+
+        for (i = 0; i < n * CHANGED_CITIES; i++) {
+            int index = rand() % n;
+            frames[day][index] += rand() % 41 - 20;
+            frames[day][n + index] = ABS(frames[day][n + index] + rand() % 21 - 10);
+        }
+
+        for (i = 0; i < n; i++) {
+            csv += sprintf(row, "%d,%d,%d,%d\n", ctry->cities[i]->city_id, frames[day][i], frames[day][n + i], day);
+        }
+    }
+    freeCountry(&ctry);
+
+    buffer = malloc(frameEncodeMaxSize(2 * n));
+    decoded = malloc(2 * n * sizeof(int));
+
+    for (repeat = 0; repeat < REPEATS; repeat++) {
+        encoded = 0;
+        for (day = 0; day < DAYS; day++) {
+            start = now();
+            length = frameEncode(frames[day], day ? frames[day - 1] : NULL, 2 * n, buffer);
+            encodeTime += now() - start;
+            encoded += length;
+
+            start = now();
+            if (frameDecode(buffer, length, day ? frames[day - 1] : NULL, decoded, 2 * n) == EXIT_FAILURE ||
+                memcmp(decoded, frames[day], 2 * n * sizeof(int))) {
+                fprintf(stderr, "Error: frame %d was not decoded correctly\n", day);
+                return EXIT_FAILURE;
+            }
+            decodeTime += now() - start;
+        }
+    }
+
+    printf("cities %d\n", n);
+    printf("days %d\n", DAYS);
+    printf("raw_bytes_per_frame %zu\n", 2 * n * sizeof(int));
+    printf("csv_bytes_per_frame %zu\n", csv / DAYS);
+    printf("encoded_bytes_per_frame %zu\n", encoded / DAYS);
+    printf("ratio_raw %.2f\n", (double) 2 * n * sizeof(int) * DAYS / encoded);
+    printf("ratio_csv %.2f\n", (double) csv / encoded);
+    printf("encode_frames_per_sec %.0f\n", DAYS * REPEATS / encodeTime);
+    printf("decode_frames_per_sec %.0f\n", DAYS * REPEATS / decodeTime);
+    printf("encode_mb_per_sec %.1f\n", 2.0 * n * sizeof(int) * DAYS * REPEATS / encodeTime / 1e6);
+    printf("decode_mb_per_sec %.1f\n", 2.0 * n * sizeof(int) * DAYS * REPEATS / decodeTime / 1e6);
+
+    for (day = 0; day < DAYS; day++) free(frames[day]);
+    free(frames);
+    free(buffer);
+    free(decoded);
+    return EXIT_SUCCESS;
+}
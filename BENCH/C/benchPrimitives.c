@@ -0,0 +1,288 @@
+/**
+ * Microbenchmarks of the containers and the random generators of the simulation - add / iterate / churn
+ * throughput of arrayList and hashTable (churn moves the citizens between the hash tables of the cities like
+ * moveCitizens and goBackHome) and samples per second of the generators. Every benchmark runs WARMUP times
+ * without measuring and then REPEATS times, results are "<benchmark>.<key> <value>" lines with the mean,
+ * standard deviation, minimum and maximum of the operations per second over the repeats.
+ * Run from the ROOT folder of the app (make bench_primitives).
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include "../../C/simulation/simulation.h"
+
+#define WARMUP 2
+#define REPEATS 10
+/* citizens in the containers */
+#define ITEMS 1000000
+/* cities the citizens live in (hash tables) and the citizens of one bucket (arrayList churn) */
+#define CITIES 64
+#define BUCKET_ITEMS 500
+/* operations of the churn benchmarks and samples of the generators per run */
+#define CHURN 1000000
+#define SAMPLES 10000000
+/* distribution of the normal values (moving mean value and standard deviation of parameters.cfg) */
+#define NORMAL_MEAN 60
+#define NORMAL_STD_DEV 20
+
+/* results of the benchmarks are added here, so the compiler does not remove the measured loops */
+volatile double SINK;
+static citizen *CITIZENS;
+
+/**
+ * Removes the citizens from the lists of the table (they belong to CITIZENS) and frees the table
+ * @param table table to be freed
+ */
+void releaseTable(hashTable **table) {
+    int i;
+    for (i = 0; i < (*table)->size; i++) (*table)->array[i]->filledItems = 0;
+    freeHashTable(table);
+}
+
+/**
+ * Creates the hash tables of CITIES cities (sized like createCity) with all the citizens at home
+ * @param tables output array of CITIES tables
+ */
+void createCities(hashTable **tables) {
+    int i;
+    for (i = 0; i < CITIES; i++) tables[i] = createHashTable(ITEMS / CITIES / 500 + 1, sizeof(citizen *));
+    for (i = 0; i < ITEMS; i++) hashTableAddElement(&CITIZENS[i], CITIZENS[i].id, tables[CITIZENS[i].homeTown]);
+}
+
+/**
+ * Adds ITEMS pointers to an empty arrayList
+ * @return operations per second
+ */
+double benchArrayListAdd() {
+    arrayList *list = createArrayList(HASH_TABLE_LIST_SIZE, sizeof(citizen *));
+    long long start;
+    int i;
+
+    start = metricsNow();
+    for (i = 0; i < ITEMS; i++) arrayListAdd(list, &CITIZENS[i]);
+    start = metricsNow() - start;
+
+    list->filledItems = 0;
+    freeArrayList(&list);
+    return ITEMS / (start / 1e9);
+}
+
+/**
+ * Reads all the items of an arrayList with ITEMS pointers
+ * @return operations per second
+ */
+double benchArrayListIterate() {
+    arrayList *list = createArrayList(HASH_TABLE_LIST_SIZE, sizeof(citizen *));
+    long long start, sum = 0;
+    int i;
+
+    for (i = 0; i < ITEMS; i++) arrayListAdd(list, &CITIZENS[i]);
+    start = metricsNow();
+    for (i = 0; i < ITEMS; i++) sum += ((citizen *) arrayListGetPointer(list, i))->id;
+    start = metricsNow() - start;
+    SINK += sum;
+
+    list->filledItems = 0;
+    freeArrayList(&list);
+    return ITEMS / (start / 1e9);
+}
+
+/**
+ * Removes a random item of a list of BUCKET_ITEMS pointers and adds it back (one bucket of a city)
+ * @return operations (remove + add) per second
+ */
+double benchArrayListChurn() {
+    arrayList *list = createArrayList(HASH_TABLE_LIST_SIZE, sizeof(citizen *));
+    long long start;
+    int i;
+
+    for (i = 0; i < BUCKET_ITEMS; i++) arrayListAdd(list, &CITIZENS[i]);
+    start = metricsNow();
+    for (i = 0; i < CHURN; i++) arrayListAdd(list, arrayListRemoveElement(list, rand() % BUCKET_ITEMS));
+    start = metricsNow() - start;
+
+    list->filledItems = 0;
+    freeArrayList(&list);
+    return CHURN / (start / 1e9);
+}
+
+/**
+ * Adds ITEMS citizens to the hash tables of their cities
+ * @return operations per second
+ */
+double benchHashTableAdd() {
+    hashTable *tables[CITIES];
+    long long start;
+    int i;
+
+    start = metricsNow();
+    createCities(tables);
+    start = metricsNow() - start;
+
+    for (i = 0; i < CITIES; i++) releaseTable(&tables[i]);
+    return ITEMS / (start / 1e9);
+}
+
+/**
+ * Reads all the citizens of the cities bucket by bucket (like updateCitizenStatuses)
+ * @return operations per second
+ */
+double benchHashTableIterate() {
+    hashTable *tables[CITIES];
+    long long start, sum = 0;
+    int i, j, k;
+
+    createCities(tables);
+    start = metricsNow();
+    for (i = 0; i < CITIES; i++)
+        for (j = 0; j < tables[i]->size; j++)
+            for (k = 0; k < tables[i]->array[j]->filledItems; k++)
+                sum += ((citizen *) arrayListGetPointer(tables[i]->array[j], k))->status;
+    start = metricsNow() - start;
+    SINK += sum;
+
+    for (i = 0; i < CITIES; i++) releaseTable(&tables[i]);
+    return ITEMS / (start / 1e9);
+}
+
+/**
+ * Moves random citizens from random cities to other random cities (like moveCitizens and goBackHome)
+ * @return operations (remove + add) per second
+ */
+double benchHashTableChurn() {
+    hashTable *tables[CITIES];
+    citizen *theCitizen;
+    long long start;
+    int i, from, bucket;
+
+    createCities(tables);
+    start = metricsNow();
+    for (i = 0; i < CHURN; i++) {
+        from = rand() % CITIES;
+        bucket = rand() % tables[from]->size;
+        if (!tables[from]->array[bucket]->filledItems) continue;
+        theCitizen = hashTableRemoveElement(bucket, rand() % tables[from]->array[bucket]->filledItems, tables[from]);
+        hashTableAddElement(theCitizen, theCitizen->id, tables[rand() % CITIES]);
+    }
+    start = metricsNow() - start;
+
+    for (i = 0; i < CITIES; i++) releaseTable(&tables[i]);
+    return CHURN / (start / 1e9);
+}
+
+/**
+ * Generates SAMPLES uniform values
+ * @return samples per second
+ */
+double benchRandomDouble() {
+    long long start;
+    double sum = 0;
+    int i;
+
+    start = metricsNow();
+    for (i = 0; i < SAMPLES; i++) sum += randomDouble();
+    start = metricsNow() - start;
+    SINK += sum;
+    return SAMPLES / (start / 1e9);
+}
+
+/**
+ * Generates SAMPLES normally distributed values by nextNormalDistDouble or nextNormalDistDoubleFaster
+ * @param faster 1 for nextNormalDistDoubleFaster
+ * @return samples per second
+ */
+double benchNormal(int faster) {
+    GaussRandom *gauss = createRandom(NORMAL_MEAN, NORMAL_STD_DEV);
+    long long start;
+    double sum = 0, value;
+    int i;
+
+    start = metricsNow();
+    for (i = 0; i < SAMPLES; i++) {
+        if (faster) nextNormalDistDoubleFaster(gauss, &value);
+        else nextNormalDistDouble(gauss, &value);
+        sum += value;
+    }
+    start = metricsNow() - start;
+    SINK += sum;
+
+    freeRandom(&gauss);
+    return SAMPLES / (start / 1e9);
+}
+
+/**
+ * Generates SAMPLES values by nextNormalDistDouble
+ * @return samples per second
+ */
+double benchNormalDistDouble() {
+    return benchNormal(0);
+}
+
+/**
+ * Generates SAMPLES values by nextNormalDistDoubleFaster
+ * @return samples per second
+ */
+double benchNormalDistDoubleFaster() {
+    return benchNormal(1);
+}
+
+/**
+ * Runs the benchmark WARMUP + REPEATS times and prints the statistics of the measured runs
+ * @param name prefix of the keys
+ * @param benchmark benchmark returning operations per second
+ */
+void runBenchmark(const char *name, double (*benchmark)()) {
+    double results[REPEATS], mean = 0, variance = 0, min, max;
+    int i;
+
+    srand(42);
+    for (i = 0; i < WARMUP; i++) benchmark();
+    for (i = 0; i < REPEATS; i++) results[i] = benchmark();
+
+    min = max = results[0];
+    for (i = 0; i < REPEATS; i++) {
+        mean += results[i] / REPEATS;
+        if (results[i] < min) min = results[i];
+        if (results[i] > max) max = results[i];
+    }
+    for (i = 0; i < REPEATS; i++) variance += (results[i] - mean) * (results[i] - mean) / (REPEATS - 1);
+
+    printf("%s.ops_per_sec %.0f\n", name, mean);
+    printf("%s.stddev %.0f\n", name, sqrt(variance));
+    printf("%s.cv_percent %.2f\n", name, 100 * sqrt(variance) / mean);
+    printf("%s.min %.0f\n", name, min);
+    printf("%s.max %.0f\n", name, max);
+    fflush(stdout);
+}
+
+int main(void) {
+    int i;
+
+    CITIZENS = malloc(ITEMS * sizeof(citizen));
+    if (!CITIZENS) {
+        fprintf(stderr, "Error: Could not allocate %d citizens\n", ITEMS);
+        return EXIT_FAILURE;
+    }
+    for (i = 0; i < ITEMS; i++) {
+        CITIZENS[i].id = i;
+        CITIZENS[i].homeTown = i % CITIES;
+        CITIZENS[i].status = NORMAL;
+        CITIZENS[i].timeFrame = 0;
+    }
+
+    printf("warmup %d\n", WARMUP);
+    printf("repeats %d\n", REPEATS);
+    runBenchmark("arraylist_add", benchArrayListAdd);
+    runBenchmark("arraylist_iterate", benchArrayListIterate);
+    runBenchmark("arraylist_churn", benchArrayListChurn);
+    runBenchmark("hashtable_add", benchHashTableAdd);
+    runBenchmark("hashtable_iterate", benchHashTableIterate);
+    runBenchmark("hashtable_churn", benchHashTableChurn);
+    runBenchmark("random_double", benchRandomDouble);
+    runBenchmark("normal_dist_double", benchNormalDistDouble);
+    runBenchmark("normal_dist_double_faster", benchNormalDistDoubleFaster);
+
+    free(CITIZENS);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,215 @@
+/**
+ * Benchmark of the simulation - fixed-seed runs of the first days over the real initial.csv and over
+ * synthetic countries with 10 and 100 times the population of every city. Every dataset runs in its own
+ * process, so the peak RSS belongs to that dataset only. Results are "<dataset>.<key> <value>" lines
+ * (times in milliseconds), datasets which would not fit into the available memory are skipped.
+ * Run from the ROOT folder of the app (make bench), the first argument is the number of days, the second one
+ * the csv scaled instead of the real initial.csv (for quick comparisons on a smaller country).
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "../../C/simulation/simulation.h"
+#include "../../C/simulation/fileManager.h"
+
+#define DAYS 1
+#define SEED 42
+#define SCALES 3
+#define MAX_LINE 255
+
+/* population of the cities of the datasets is multiplied by these */
+static const int SCALE_FACTORS[SCALES] = {1, 10, 100};
+
+/**
+ * Writes the copy of the csv with the population and the infected of every city multiplied by scale
+ * @param source input csv
+ * @param destination output csv
+ * @param scale multiplier of the population
+ * @return total population of the output or -1 if the files could not be read / written
+ */
+long long scaleCsv(const char *source, const char *destination, int scale) {
+    FILE *in, *out;
+    char line[MAX_LINE], header[MAX_LINE], *token;
+    int column, population_index = -1, infected_index = -1;
+    long long total = 0, value;
+
+    in = fopen(source, "r");
+    if (!in) return -1;
+    out = fopen(destination, "w");
+    if (!out) {
+        fclose(in);
+        return -1;
+    }
+
+    if (fgets(line, MAX_LINE, in)) {
+        fputs(line, out);
+        strcpy(header, line);
+        header[strcspn(header, "\r\n")] = '\0';
+        for (column = 0, token = strtok(header, ","); token; column++, token = strtok(NULL, ",")) {
+            if (!strcmp(token, POPULATION_COLUMN_NAME)) population_index = column;
+            if (!strcmp(token, INFECTED_COLUMN_NAME)) infected_index = column;
+        }
+    }
+
+    while (fgets(line, MAX_LINE, in)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (!*line) continue;
+        for (column = 0, token = strtok(line, ","); token; column++, token = strtok(NULL, ",")) {
+            if (column) fputc(',', out);
+            if (column == population_index || column == infected_index) {
+                value = atoll(token) * scale;
+                if (column == population_index) total += value;
+                fprintf(out, "%lld", value);
+            }
+            else fputs(token, out);
+        }
+        fputc('\n', out);
+    }
+
+    fclose(in);
+    if (fclose(out) == EOF) return -1;
+    return total;
+}
+
+/**
+ * Runs the simulation of one dataset and prints its results
+ * @param name prefix of the keys
+ * @param filepath csv of the dataset
+ * @param days number of the simulated days
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int runDataset(const char *name, const char *filepath, int days) {
+    country *ctry;
+    GaussRandom *moveRandom, *spreadRandom;
+    int *population, *infected;
+    metricSample daySample;
+    struct rusage usage;
+    long long start, loadTime, simulationTime = 0;
+    int day, i;
+
+    if (load_parameters(PARAMETERS_FILE) == EXIT_FAILURE) {
+        fprintf(stderr, "Error: Could not load parameters from %s\n", PARAMETERS_FILE);
+        return EXIT_FAILURE;
+    }
+    srand(SEED);
+
+    start = metricsNow();
+    ctry = create_country_from_csv(filepath, 1);
+    loadTime = metricsNow() - start;
+    if (!ctry) {
+        fprintf(stderr, "Error: Could not create country from %s\n", filepath);
+        return EXIT_FAILURE;
+    }
+
+    population = malloc(ctry->numberOfCities * sizeof(int));
+    infected = malloc(ctry->numberOfCities * sizeof(int));
+    moveRandom = createRandom(ctry->params.moveMean, ctry->params.moveStdDev);
+    spreadRandom = createRandom(ctry->params.spreadMean, ctry->params.spreadStdDev);
+    if (!population || !infected || !moveRandom || !spreadRandom) {
+        fprintf(stderr, "Error: Could not allocate the simulation of %s\n", filepath);
+        return EXIT_FAILURE;
+    }
+
+    metricsReset();
+    for (day = 0; day < days; day++) {
+        metricsBegin(&daySample);
+        simulateDay(ctry, moveRandom, spreadRandom);
+        snapshotCountry(ctry, population, infected);
+        simulationTime += metricsEnd(METRIC_DAY, &daySample);
+    }
+    getrusage(RUSAGE_SELF, &usage);
+
+    printf("%s.cities %d\n", name, ctry->numberOfCities);
+    printf("%s.citizens %d\n", name, ctry->movedCitizensLength);
+    printf("%s.days %d\n", name, days);
+    printf("%s.load_ms %.3f\n", name, loadTime / 1e6);
+    for (i = 0; i < METRIC_COUNT; i++) {
+        if (!atomic_load(&METRICS[i].count)) continue;
+        printf("%s.%s_total_ms %.3f\n", name, metricsName(i), atomic_load(&METRICS[i].total) / 1e6);
+        printf("%s.%s_p50_ms %.3f\n", name, metricsName(i), metricsPercentile(i, 0.5) / 1e6);
+        printf("%s.%s_p99_ms %.3f\n", name, metricsName(i), metricsPercentile(i, 0.99) / 1e6);
+    }
+    printf("%s.citizens_per_sec %.0f\n", name, (double) ctry->movedCitizensLength * days / (simulationTime / 1e9));
+    /* kilobytes on Linux */
+    printf("%s.peak_rss_kb %ld\n", name, usage.ru_maxrss);
+
+    free(population);
+    free(infected);
+    freeRandom(&moveRandom);
+    freeRandom(&spreadRandom);
+    freeCountry(&ctry);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Returns the memory available for the next dataset
+ * @return bytes
+ */
+long long availableMemory() {
+    return (long long) sysconf(_SC_AVPHYS_PAGES) * sysconf(_SC_PAGESIZE);
+}
+
+int main(int argc, char **argv) {
+    char filepath[] = "/tmp/benchSimulationXXXXXX";
+    double bytesPerCitizen = 0;
+    long long population;
+    int days = argc > 1 ? atoi(argv[1]) : DAYS, i, fd, status, failed = 0;
+    const char *source = argc > 2 ? argv[2] : SIMULATION_INI_CSV;
+    char name[16];
+    struct rusage usage;
+    pid_t pid;
+
+    if (days <= 0) {
+        fprintf(stderr, "Usage: %s [days] [csv]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    fd = mkstemp(filepath);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Could not create a temporary file\n");
+        return EXIT_FAILURE;
+    }
+    close(fd);
+
+    printf("seed %d\n", SEED);
+    printf("source %s\n", source);
+    for (i = 0; i < SCALES; i++) {
+        sprintf(name, "x%d", SCALE_FACTORS[i]);
+        population = scaleCsv(source, filepath, SCALE_FACTORS[i]);
+        if (population < 0) {
+            fprintf(stderr, "Error: Could not scale %s\n", source);
+            failed = 1;
+            break;
+        }
+        /* memory of the previous dataset per citizen estimates the memory of this one */
+        if (bytesPerCitizen && population * bytesPerCitizen > availableMemory()) {
+            printf("%s.skipped 1\n", name);
+            fprintf(stderr, "Skipping %s: %lld citizens need about %.0f MB, %lld MB available\n", name,
+                    population, population * bytesPerCitizen / 1e6, availableMemory() / 1000000);
+            continue;
+        }
+
+        fflush(stdout);
+        pid = fork();
+        if (pid < 0) {
+            failed = 1;
+            break;
+        }
+        if (!pid) exit(runDataset(name, filepath, days));
+        if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+            fprintf(stderr, "Error: Benchmark of %s failed\n", name);
+            failed = 1;
+            break;
+        }
+
+        /* peak RSS of the largest child so far (kilobytes on Linux) */
+        getrusage(RUSAGE_CHILDREN, &usage);
+        if (population) bytesPerCitizen = usage.ru_maxrss * 1024.0 / population;
+    }
+
+    remove(filepath);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,236 @@
+/**
+ * Generator of synthetic countries in the format of initial.csv for the scale testing of the loader, the simulation
+ * and the server. Populations of the cities follow the rank-size rule (population of the r-th largest city is
+ * proportional to r^-exponent - a few big cities like Praha and many villages), the largest cities are spread over
+ * the area of the Czech republic and the rest of the cities are clustered around them. Alternatively the existing
+ * dataset is tiled - copied next to each other with new ids.
+ * Run from the ROOT folder of the app (make generate_country), switches:
+ *   -cities <n>         number of the cities (at most MAX_CITIES)
+ *   -population <n>     total population
+ *   -exponent <x>       exponent of the rank-size rule
+ *   -infected <n>       infected citizens of the largest city
+ *   -tile <n>           copies of -source instead of the synthetic cities (at most MAX_TILES)
+ *   -source <csv>       dataset which is tiled
+ *   -seed <n>           seed of the random generator
+ *   -o <csv>            output file
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include "../../C/simulation/random.h"
+#include "../../C/simulation/fileManager.h"
+
+#define MAX_CITIES 1000000
+#define MAX_LINE 255
+#define HEADER "nazev_obce," CITY_ID_COLUMN_NAME "," LATITUDE_COLUMN_NAME "," LONGITUDE_COLUMN_NAME "," \
+               CITY_AREA_COLUMN_NAME "," POPULATION_COLUMN_NAME "," INFECTED_COLUMN_NAME ",datum\n"
+/* bounding box of the Czech republic */
+#define MIN_LAT 48.55
+#define MAX_LAT 51.06
+#define MIN_LON 12.09
+#define MAX_LON 18.86
+/* standard deviation (in degrees of latitude) of the cities around the largest and around the smallest center */
+#define MAX_CLUSTER_SPREAD 0.3
+#define MIN_CLUSTER_SPREAD 0.03
+/* ids of the synthetic cities and offset of the ids of every tile (ids of the real cities have 6 digits) */
+#define ID_OFFSET 1000000
+/* tiles are in a square grid, 15 rows still have valid latitudes */
+#define MAX_TILES 225
+
+#ifndef M_PI
+#    define M_PI 3.14159265358979323846
+#endif
+
+#define radians(degrees) (degrees) * (M_PI / 180.0)
+
+typedef struct {
+    int cities;
+    long long population;
+    double exponent;
+    int infected;
+    int tile;
+    const char *source;
+    unsigned int seed;
+    const char *output;
+} generatorArgs;
+
+/**
+ * Returns normally distributed value (mean 0, standard deviation 1)
+ * @param gauss generator of the values
+ * @return value
+ */
+double nextGauss(GaussRandom *gauss) {
+    double value = 0;
+    randomGaussian(gauss, &value);
+    return value;
+}
+
+/**
+ * Keeps the value in the interval
+ * @param value value
+ * @param min lower bound
+ * @param max upper bound
+ * @return value within <min, max>
+ */
+double clamp(double value, double min, double max) {
+    return value < min ? min : value > max ? max : value;
+}
+
+/**
+ * Writes the synthetic country (header and the cities)
+ * @param args switches of the generator
+ * @param out output file
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int generateCities(generatorArgs *args, FILE *out) {
+    int *population, centers = (int) sqrt(args->cities), i, center, low, high;
+    double *lat, *lon, *weights, weightSum = 0, spread, density;
+    GaussRandom *gauss;
+
+    population = malloc(args->cities * sizeof(int));
+    lat = malloc(args->cities * sizeof(double));
+    lon = malloc(args->cities * sizeof(double));
+    /* cumulative population of the centers (the cities are clustered around the centers by their population) */
+    weights = malloc(centers * sizeof(double));
+    gauss = createRandom(0, 1);
+    if (!population || !lat || !lon || !weights || !gauss) {
+        free(population);
+        free(lat);
+        free(lon);
+        free(weights);
+        freeRandom(&gauss);
+        return EXIT_FAILURE;
+    }
+
+    fputs(HEADER, out);
+    //rank-size rule, every city has at least one citizen
+    for (i = 0; i < args->cities; i++) weightSum += pow(i + 1, -args->exponent);
+    for (i = 0; i < args->cities; i++) {
+        population[i] = (int) fmin(INT_MAX, fmax(1, llround(args->population * pow(i + 1, -args->exponent) / weightSum)));
+    }
+
+    //centers anywhere in the country
+    for (i = 0; i < centers; i++) {
+        lat[i] = MIN_LAT + (randomDouble() + 1) / 2 * (MAX_LAT - MIN_LAT);
+        lon[i] = MIN_LON + (randomDouble() + 1) / 2 * (MAX_LON - MIN_LON);
+        weights[i] = (i ? weights[i - 1] : 0) + population[i];
+    }
+
+    //smaller cities around the centers, bigger centers have wider surroundings
+    for (i = centers; i < args->cities; i++) {
+        double target = (randomDouble() + 1) / 2 * weights[centers - 1];
+        for (low = 0, high = centers - 1; low < high;) {
+            center = (low + high) / 2;
+            if (weights[center] < target) low = center + 1;
+            else high = center;
+        }
+        spread = MIN_CLUSTER_SPREAD + (MAX_CLUSTER_SPREAD - MIN_CLUSTER_SPREAD) * sqrt((double) population[low] / population[0]);
+        lat[i] = clamp(lat[low] + nextGauss(gauss) * spread, MIN_LAT, MAX_LAT);
+        lon[i] = clamp(lon[low] + nextGauss(gauss) * spread / cos(radians(lat[low])), MIN_LON, MAX_LON);
+    }
+
+    for (i = 0; i < args->cities; i++) {
+        //bigger cities are denser (villages ~60 citizens per km^2, Praha ~1500)
+        density = 10 * pow(population[i], 0.35) * exp(0.3 * nextGauss(gauss));
+        fprintf(out, "Obec %d,%d,%f,%f,%f,%d,%d,0\n", i + 1, ID_OFFSET + i, lat[i], lon[i], population[i] / density,
+                population[i], i ? 0 : (args->infected < population[0] ? args->infected : population[0]));
+    }
+
+    free(population);
+    free(lat);
+    free(lon);
+    free(weights);
+    freeRandom(&gauss);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Writes the copies of the source dataset in a grid next to each other (every copy is shifted by the size of
+ * the bounding box), ids of the i-th copy are increased by i * ID_OFFSET, the header is copied from the source
+ * @param args switches of the generator
+ * @param out output file
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int tileCities(generatorArgs *args, FILE *out) {
+    FILE *in;
+    char line[MAX_LINE], *token;
+    int columns = (int) ceil(sqrt(args->tile)), tile, column, id_index = -1, lat_index = -1, lon_index = -1;
+    long position;
+
+    in = fopen(args->source, "r");
+    if (!in || !fgets(line, MAX_LINE, in)) {
+        if (in) fclose(in);
+        return EXIT_FAILURE;
+    }
+    fputs(line, out);
+    line[strcspn(line, "\r\n")] = '\0';
+    for (column = 0, token = strtok(line, ","); token; column++, token = strtok(NULL, ",")) {
+        if (!strcmp(token, CITY_ID_COLUMN_NAME)) id_index = column;
+        if (!strcmp(token, LATITUDE_COLUMN_NAME)) lat_index = column;
+        if (!strcmp(token, LONGITUDE_COLUMN_NAME)) lon_index = column;
+    }
+    if (id_index < 0 || lat_index < 0 || lon_index < 0) {
+        fclose(in);
+        return EXIT_FAILURE;
+    }
+    position = ftell(in);
+
+    for (tile = 0; tile < args->tile; tile++) {
+        fseek(in, position, SEEK_SET);
+        while (fgets(line, MAX_LINE, in)) {
+            line[strcspn(line, "\r\n")] = '\0';
+            if (!*line) continue;
+            for (column = 0, token = strtok(line, ","); token; column++, token = strtok(NULL, ",")) {
+                if (column) fputc(',', out);
+                if (column == id_index) fprintf(out, "%d", atoi(token) + tile * ID_OFFSET);
+                else if (column == lat_index) fprintf(out, "%f", atof(token) + tile / columns * (MAX_LAT - MIN_LAT));
+                else if (column == lon_index) fprintf(out, "%f", atof(token) + tile % columns * (MAX_LON - MIN_LON));
+                else fputs(token, out);
+            }
+            fputc('\n', out);
+        }
+    }
+
+    fclose(in);
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+    generatorArgs args = {10000, 10000000, 1.0, 1, 0, SIMULATION_INI_CSV, 42, "./DATA/generated.csv"};
+    FILE *out;
+    int i, result;
+
+    for (i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "-cities")) args.cities = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "-population")) args.population = atoll(argv[i + 1]);
+        else if (!strcmp(argv[i], "-exponent")) args.exponent = atof(argv[i + 1]);
+        else if (!strcmp(argv[i], "-infected")) args.infected = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "-tile")) args.tile = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "-source")) args.source = argv[i + 1];
+        else if (!strcmp(argv[i], "-seed")) args.seed = (unsigned int) atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "-o")) args.output = argv[i + 1];
+        else break;
+    }
+    if (i < argc || args.cities <= 0 || args.cities > MAX_CITIES || args.population < args.cities ||
+        args.exponent < 0 || args.infected < 0 || args.tile < 0 || args.tile > MAX_TILES) {
+        fprintf(stderr, "Usage: %s [-cities <1..%d>] [-population <n>] [-exponent <x>] [-infected <n>] "
+                        "[-tile <1..%d> [-source <csv>]] [-seed <n>] [-o <csv>]\n", argv[0], MAX_CITIES, MAX_TILES);
+        return EXIT_FAILURE;
+    }
+
+    out = fopen(args.output, "w");
+    if (!out) {
+        fprintf(stderr, "Error: Could not open %s\n", args.output);
+        return EXIT_FAILURE;
+    }
+    srand(args.seed);
+    result = args.tile ? tileCities(&args, out) : generateCities(&args, out);
+    if (fclose(out) == EOF) result = EXIT_FAILURE;
+
+    if (result == EXIT_FAILURE) fprintf(stderr, "Error: Could not generate %s\n", args.output);
+    else printf("Generated %s\n", args.output);
+    return result;
+}
@@ -0,0 +1,384 @@
+/**
+ * Headless batch run of the simulation - simulates a fixed number of days with a given seed and
+ * parameter file as fast as possible (no server, no sockets) and prints the summary statistics
+ * as "key value" lines. Frames and checkpoints are written only every n-th day (or never) into the -out
+ * directory (never into the store and the save file of the server).
+ * With -sweep (repeatable), every combination of the values of the swept parameters is simulated from the same
+ * initial state with the same seed on a pool of -threads threads and the outcomes are written into -results.
+ * With -replicates, the replicates of the simulation (seeds seed .. seed + replicates - 1) run on a pool of
+ * -threads threads and the bands of the infected of every city over the replicates are written into -bands.
+ * Run from the ROOT folder of the app, e.g.
+ *      ./batch -days 365 -seed 42 -params ./parameters.cfg -frames 7 -out ./DATA/batch
+ *      ./batch -days 365 -seed 42 -replicates 100 -threads 16 -bands ./DATA/bands.csv
+ *      ./batch -days 100 -seed 42 -sweep MEETING_FACTOR=0.1:0.5:0.1 -sweep DEATH_THRESHOLD=0.01,0.05 -results ./DATA/sweep.csv
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include "../simulation/simulation.h"
+#include "../simulation/fileManager.h"
+#include "../simulation/ensemble.h"
+#include "../simulation/sweep.h"
+
+#define DEF_DAYS 100
+#define DEF_RESULTS "./DATA/sweep.csv"
+/* frames and checkpoints of the batch are kept apart from DATA/sim_frames of the running server */
+#define DEF_OUT "./DATA/batch"
+#define OUT_FRAMES "frames.dat"
+#define OUT_INDEX "frames.idx"
+#define OUT_SAVE "save.bin"
+#define OUT_PATH_MAX 4096
+#define ARGNUM 14
+/* all possible switches on commandline, each switch is followed by its value */
+char *available_args[ARGNUM] = {"-days", "-seed", "-params", "-csv", "-frames", "-checkpoint", "-trace", "-perf",
+                                "-replicates", "-threads", "-bands", "-sweep", "-results", "-out"};
+
+/**
+ * Finds the values of the switches in the arguments of the program
+ * @param argc number of arguments (always at least 1 - program name)
+ * @param argv the array of arguments (index 0 is the program name)
+ * @param indices output array containing the indices to the argv on which the values
+ *                of corresponding switches (as defined in available_args) reside, 0 if missing
+ */
+void find_arg_indices(int argc, char const *argv[], int indices[]) {
+    for (int i = 1; i < argc; i++)
+        for (int j = 0; j < ARGNUM; j++)
+            if (!strcmp(available_args[j], argv[i])) {
+                indices[j] = ++i;
+                break;
+            }
+}
+
+/**
+ * Returns the numeric value of the switch
+ * @param argv the array of arguments
+ * @param index index of the value (0 if the switch is missing)
+ * @param def default value
+ * @return value of the switch or def
+ */
+long value_of(char const *argv[], int index, long def) {
+    return index ? strtol(argv[index], NULL, 10) : def;
+}
+
+/**
+ * Prints the summary of the phases measured during the run and the peak resident memory of the process
+ * @param elapsed nanoseconds of the whole run
+ * @param days number of the simulated days
+ * @param citizens number of the citizens
+ */
+void print_phases(long long elapsed, int days, int citizens) {
+    struct rusage usage;
+    int i;
+    for (i = 0; i < METRIC_COUNT; i++) {
+        if (!atomic_load(&METRICS[i].count)) continue;
+        printf("%s_total_ms %.3f\n", metricsName(i), atomic_load(&METRICS[i].total) / 1e6);
+        printf("%s_p50_ms %.3f\n", metricsName(i), metricsPercentile(i, 0.5) / 1e6);
+        printf("%s_p99_ms %.3f\n", metricsName(i), metricsPercentile(i, 0.99) / 1e6);
+    }
+    printf("elapsed_sec %.3f\n", elapsed / 1e9);
+    printf("days_per_sec %.3f\n", days / (elapsed / 1e9));
+    printf("citizens_per_sec %.0f\n", (double) citizens * days / (elapsed / 1e9));
+    if (!getrusage(RUSAGE_SELF, &usage)) printf("peak_rss_mb %.1f\n", usage.ru_maxrss / 1024.0);
+}
+
+/**
+ * Runs the replicates of the simulation and writes the bands of every day
+ * @param geography loaded cities (without citizens)
+ * @param days number of the simulated days
+ * @param seed seed of the first replicate
+ * @param replicates number of the replicates
+ * @param threads number of the threads
+ * @param bands_path output csv of the bands or NULL
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int run_ensemble(country *geography, int days, unsigned int seed, int replicates, int threads,
+                 const char *bands_path) {
+    ensemble *the_ensemble;
+    FILE *bands = NULL;
+    long long start;
+    int *totals;
+    int day, replicate, i, n = geography->numberOfCities, citizens = 0, result;
+
+    if (bands_path && !(bands = fopen(bands_path, "w"))) {
+        fprintf(stderr, "Error: Could not open %s\n", bands_path);
+        return EXIT_FAILURE;
+    }
+    totals = malloc(replicates * sizeof(int));
+    the_ensemble = createEnsemble(geography, replicates, threads, seed);
+    if (!the_ensemble || !totals) {
+        fprintf(stderr, "Error: Could not create %d replicates\n", replicates);
+        if (bands) fclose(bands);
+        free(totals);
+        return EXIT_FAILURE;
+    }
+    if (bands) fputs(ENSEMBLE_BANDS_HEADER, bands);
+
+    start = metricsNow();
+    result = ensembleRun(the_ensemble, days);
+    start = metricsNow() - start;
+    if (result == EXIT_FAILURE)
+        fprintf(stderr, "Error: Some of the replicates could not be simulated\n");
+    for (day = 0; result == EXIT_SUCCESS && bands && day < days; day++)
+        if (ensembleWriteBands(the_ensemble, day, bands) == EXIT_FAILURE) {
+            fprintf(stderr, "Error: Could not write the bands of day %d\n", day);
+            result = EXIT_FAILURE;
+        }
+
+    /* infected of the last day of every replicate */
+    for (replicate = 0; replicate < replicates; replicate++) {
+        totals[replicate] = 0;
+        for (i = 0; i < n; i++) totals[replicate] += the_ensemble->infected[(size_t) replicate * n + i];
+    }
+    for (i = 0; i < n; i++) citizens += geography->cities[i]->population;
+    printf("seed %u\n", seed);
+    printf("days %d\n", days);
+    printf("replicates %d\n", replicates);
+    printf("threads %d\n", the_ensemble->threads);
+    printf("cities %d\n", n);
+    printf("citizens %d\n", citizens);
+    printf("infected_p5 %d\n", ensembleQuantile(totals, replicates, 0.05));
+    printf("infected_p50 %d\n", ensembleQuantile(totals, replicates, 0.5));
+    printf("infected_p95 %d\n", ensembleQuantile(totals, replicates, 0.95));
+    print_phases(start, days, citizens * replicates);
+
+    freeEnsemble(&the_ensemble);
+    free(totals);
+    if (bands && fclose(bands) == EOF) return EXIT_FAILURE;
+    return result;
+}
+
+/**
+ * Runs the sweep over the parameters given by all the -sweep switches and writes its results
+ * @param geography loaded cities (without citizens)
+ * @param argc number of arguments
+ * @param argv the array of arguments
+ * @param days number of the simulated days of every run
+ * @param seed seed of every run
+ * @param threads number of the threads
+ * @param results_path output csv of the results
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int run_sweep(country *geography, int argc, char const *argv[], int days, unsigned int seed, int threads,
+              const char *results_path) {
+    sweep *the_sweep;
+    FILE *results;
+    long long start, setup = 0, run = 0;
+    int i, failed = 0, citizens = 0;
+
+    the_sweep = createSweep(geography, days, seed);
+    if (!the_sweep) {
+        fprintf(stderr, "Error: Could not create the sweep\n");
+        return EXIT_FAILURE;
+    }
+    for (i = 1; i < argc - 1; i++)
+        if (!strcmp(argv[i], "-sweep") && sweepAddDimension(the_sweep, argv[++i]) == EXIT_FAILURE) {
+            fprintf(stderr, "Error: Invalid sweep %s (NAME=from:to:step or NAME=v1,v2,..., at most %d runs)\n",
+                    argv[i], SWEEP_MAX_POINTS);
+            freeSweep(&the_sweep);
+            return EXIT_FAILURE;
+        }
+    if (!(results = fopen(results_path, "w"))) {
+        fprintf(stderr, "Error: Could not open %s\n", results_path);
+        freeSweep(&the_sweep);
+        return EXIT_FAILURE;
+    }
+
+    start = metricsNow();
+    sweepRun(the_sweep, threads);
+    start = metricsNow() - start;
+    for (i = 0; i < the_sweep->points; i++) {
+        if (the_sweep->results[i].infected < 0) failed++;
+        setup += the_sweep->results[i].setupTime;
+        run += the_sweep->results[i].runTime;
+    }
+    for (i = 0; i < geography->numberOfCities; i++) citizens += geography->cities[i]->population;
+    if (sweepWriteResults(the_sweep, results) == EXIT_FAILURE) failed++;
+
+    printf("seed %u\n", seed);
+    printf("days %d\n", days);
+    printf("points %d\n", the_sweep->points);
+    printf("failed_points %d\n", failed);
+    printf("threads %d\n", threads < the_sweep->points ? threads : the_sweep->points);
+    printf("cities %d\n", geography->numberOfCities);
+    /* copy of the citizens and their hash tables from the geography, paid by every point */
+    printf("setup_seconds_per_point %f\n", setup / 1e9 / the_sweep->points);
+    printf("setup_share %f\n", setup + run ? (double) setup / (setup + run) : 0.0);
+    print_phases(start, days * the_sweep->points, citizens);
+
+    freeSweep(&the_sweep);
+    if (fclose(results) == EOF) return EXIT_FAILURE;
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ * Creates the output directory (if it doesn't exist yet) and the path of the file in it
+ * @param out output directory
+ * @param name name of the file
+ * @param path output buffer of OUT_PATH_MAX chars
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the directory can't be created or the path is too long
+ */
+int out_path(const char *out, const char *name, char *path) {
+    if (mkdir(out, 0755) && errno != EEXIST) return EXIT_FAILURE;
+    if (snprintf(path, OUT_PATH_MAX, "%s/%s", out, name) >= OUT_PATH_MAX) return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char const *argv[]) {
+    int args_indices[ARGNUM] = {0};
+    int days, frames, checkpoint, replicates, threads, day, i, peak_day = 0, *population, *infected, result;
+    unsigned int seed;
+    const char *params, *csv, *out;
+    char frames_path[OUT_PATH_MAX], index_path[OUT_PATH_MAX], save_path[OUT_PATH_MAX];
+    long long total_population, total_infected, peak_infected = -1, new_infected = 0, recovered = 0, deaths = 0;
+    long long start;
+    frameStore *store = NULL;
+    GaussRandom *move_random, *spread_random;
+    metricSample day_sample, sample;
+    country *ctry;
+
+    find_arg_indices(argc, argv, args_indices);
+    days = (int) value_of(argv, args_indices[0], DEF_DAYS);
+    seed = (unsigned int) value_of(argv, args_indices[1], time(NULL));
+    params = args_indices[2] ? argv[args_indices[2]] : PARAMETERS_FILE;
+    csv = args_indices[3] ? argv[args_indices[3]] : SIMULATION_INI_CSV;
+    /* every n-th day is written, 0 - never */
+    frames = (int) value_of(argv, args_indices[4], 0);
+    checkpoint = (int) value_of(argv, args_indices[5], 0);
+    out = args_indices[13] ? argv[args_indices[13]] : DEF_OUT;
+    replicates = (int) value_of(argv, args_indices[8], 1);
+    threads = (int) value_of(argv, args_indices[9], sysconf(_SC_NPROCESSORS_ONLN));
+    if (days <= 0 || frames < 0 || checkpoint < 0 || replicates <= 0 || threads <= 0 ||
+        (args_indices[11] && replicates > 1)) {
+        fprintf(stderr, "Usage: %s [-days <n>] [-seed <n>] [-params <cfg>] [-csv <csv>] [-frames <every n days>] "
+                        "[-checkpoint <every n days>] [-out <dir>] [-trace <json>] [-perf 1] "
+                        "[-replicates <n> [-threads <n>] [-bands <csv>]] "
+                        "[-sweep <NAME=from:to:step|NAME=v1,v2,...> ... [-threads <n>] [-results <csv>]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (args_indices[6] && traceOpen(argv[args_indices[6]]) == EXIT_FAILURE)
+        fprintf(stderr, "Warning: trace file %s can't be created, tracing is disabled.\n", argv[args_indices[6]]);
+    if (value_of(argv, args_indices[7], 0)) {
+        PERF_COUNTERS_ENABLED = 1;
+        if (!perfCountersOpen())
+            fprintf(stderr, "Warning: hardware counters are not available (perf_event_open failed).\n");
+    }
+
+    if (load_parameters(params) == EXIT_FAILURE) {
+        fprintf(stderr, "Error: Could not load parameters from %s\n", params);
+        return EXIT_FAILURE;
+    }
+    /* replicates and runs of the sweep create their citizens from the cities */
+    ctry = create_country_from_csv(csv, replicates == 1 && !args_indices[11]);
+    if (!ctry) {
+        fprintf(stderr, "Error: Could not create country from %s\n", csv);
+        return EXIT_FAILURE;
+    }
+    if (args_indices[11]) {
+        if (frames || checkpoint)
+            fprintf(stderr, "Warning: frames and checkpoints are not written for the sweep.\n");
+        result = run_sweep(ctry, argc, argv, days, seed, threads,
+                           args_indices[12] ? argv[args_indices[12]] : DEF_RESULTS);
+        if (TRACE_ENABLED) traceClose();
+        freeCountry(&ctry);
+        return result;
+    }
+    if (replicates > 1) {
+        if (frames || checkpoint)
+            fprintf(stderr, "Warning: frames and checkpoints are not written for the replicates.\n");
+        result = run_ensemble(ctry, days, seed, replicates, threads, args_indices[10] ? argv[args_indices[10]] : NULL);
+        if (TRACE_ENABLED) traceClose();
+        freeCountry(&ctry);
+        return result;
+    }
+    if ((frames || checkpoint) && (out_path(out, OUT_FRAMES, frames_path) == EXIT_FAILURE ||
+                                   out_path(out, OUT_INDEX, index_path) == EXIT_FAILURE ||
+                                   out_path(out, OUT_SAVE, save_path) == EXIT_FAILURE)) {
+        fprintf(stderr, "Error: Could not create output directory %s\n", out);
+        return EXIT_FAILURE;
+    }
+    if (frames && !(store = create_frame_store_from_country(ctry, frames_path, index_path, 0))) {
+        fprintf(stderr, "Error: Could not create frame store %s\n", frames_path);
+        return EXIT_FAILURE;
+    }
+    population = malloc(ctry->numberOfCities * sizeof(int));
+    infected = malloc(ctry->numberOfCities * sizeof(int));
+    move_random = createRandom(ctry->params.moveMean, ctry->params.moveStdDev);
+    spread_random = createRandom(ctry->params.spreadMean, ctry->params.spreadStdDev);
+    if (!population || !infected || !move_random || !spread_random) {
+        fprintf(stderr, "Error: Could not allocate the simulation\n");
+        return EXIT_FAILURE;
+    }
+
+    srand(seed);
+    start = metricsNow();
+    for (day = 0; day < days; day++) {
+        TRACE_BEGIN_VALUE("day", day);
+        metricsBegin(&day_sample);
+        simulateDay(ctry, move_random, spread_random);
+
+        TRACE_BEGIN("frame_write");
+        metricsBegin(&sample);
+        snapshotCountry(ctry, population, infected);
+        if (frames && day % frames == 0) frameStoreAppend(store, day, population, infected);
+        metricsEnd(METRIC_FRAME_WRITE, &sample);
+        TRACE_END("frame_write");
+
+        if (checkpoint && (day + 1) % checkpoint == 0) {
+            TRACE_BEGIN("checkpoint");
+            metricsBegin(&sample);
+            if (!save_state(ctry, day, save_path))
+                fprintf(stderr, "Warning: state of the day %d could not be saved into %s\n", day, save_path);
+            metricsEnd(METRIC_CHECKPOINT, &sample);
+            TRACE_END("checkpoint");
+        }
+        metricsEnd(METRIC_DAY, &day_sample);
+        TRACE_END("day");
+        if (TRACE_ENABLED) traceFlush();
+
+        total_infected = 0;
+        for (i = 0; i < ctry->numberOfCities; i++) total_infected += infected[i];
+        if (total_infected > peak_infected) {
+            peak_infected = total_infected;
+            peak_day = day;
+        }
+        new_infected += ctry->newInfected;
+        recovered += ctry->recovered;
+        deaths += ctry->deaths;
+    }
+    start = metricsNow() - start;
+
+    total_population = 0;
+    total_infected = 0;
+    for (i = 0; i < ctry->numberOfCities; i++) {
+        total_population += population[i];
+        total_infected += infected[i];
+    }
+    printf("seed %u\n", seed);
+    printf("days %d\n", days);
+    printf("cities %d\n", ctry->numberOfCities);
+    printf("citizens %d\n", ctry->movedCitizensLength);
+    printf("population %lld\n", total_population);
+    printf("infected %lld\n", total_infected);
+    printf("peak_infected %lld\n", peak_infected);
+    printf("peak_day %d\n", peak_day);
+    printf("new_infected %lld\n", new_infected);
+    printf("recovered %lld\n", recovered);
+    printf("deaths %lld\n", deaths);
+    print_phases(start, days, ctry->movedCitizensLength);
+
+    if (TRACE_ENABLED) traceClose();
+    freeFrameStore(&store);
+    freeRandom(&move_random);
+    freeRandom(&spread_random);
+    free(population);
+    free(infected);
+    freeCountry(&ctry);
+    return EXIT_SUCCESS;
+}
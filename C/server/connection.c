@@ -0,0 +1,325 @@
+/* ------- INCLUDES */
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+
+#include "connection.h"
+
+#define INPUT_MASK (INPUT_BUFFER_SIZE - 1)
+/* minimal size of the data of the output chunk, small responses are appended into one chunk */
+#define OUTPUT_CHUNK_SIZE 4096
+
+/**
+ * @brief Creates the state of the connection with empty input buffer
+ *
+ * @param fd connection file descriptor
+ * @return pointer to the state or NULL if it is not possible to allocate memory
+ */
+connection *create_connection_state(int fd) {
+    connection *conn = calloc(1, sizeof(connection));
+    if (!conn) return NULL;
+
+    conn->fd = fd;
+    conn->last_active = time(NULL);
+    conn->pushed_frame = -1;
+    return conn;
+}
+
+/**
+ * @brief Deallocates the state of the connection (the connection is not closed)
+ *
+ * @param conn pointer to pointer to the state
+ */
+void free_connection_state(connection **conn) {
+    output_chunk *chunk, *next;
+    if (!conn || !*conn) return;
+
+    for (chunk = (*conn)->output_head; chunk; chunk = next) {
+        next = chunk->next;
+        if (chunk->fd >= 0) close(chunk->fd);
+        free(chunk);
+    }
+    free(*conn);
+    *conn = NULL;
+}
+
+/**
+ * @brief Reads as much as fits into the free part of the input ring buffer with one syscall
+ *
+ * @param conn state of the connection
+ * @return same as read() - number of read bytes, 0 if the connection was closed, -1 on error
+ *         (and 0 bytes are read if the buffer is full)
+ */
+ssize_t fill_input(connection *conn) {
+    struct iovec parts[2];
+    size_t tail, free_space;
+    ssize_t n;
+
+    free_space = INPUT_BUFFER_SIZE - conn->length;
+    if (!free_space) return 0;
+
+    /* free space of the ring may wrap around the end of the array */
+    tail = (conn->head + conn->length) & INPUT_MASK;
+    parts[0].iov_base = conn->input + tail;
+    parts[0].iov_len = tail + free_space > INPUT_BUFFER_SIZE ? INPUT_BUFFER_SIZE - tail : free_space;
+    parts[1].iov_base = conn->input;
+    parts[1].iov_len = free_space - parts[0].iov_len;
+
+    n = readv(conn->fd, parts, parts[1].iov_len ? 2 : 1);
+    if (n > 0) {
+        conn->length += n;
+        conn->last_active = time(NULL);
+    }
+    return n;
+}
+
+/**
+ * @brief Finds the END OF MESSAGE in the unread part of the input
+ *
+ * @param conn state of the connection
+ * @return distance of the END OF MESSAGE from the head or -1 if it is not in the buffer
+ */
+static long find_end_of_message(connection *conn) {
+    size_t first_len = conn->head + conn->length > INPUT_BUFFER_SIZE ? INPUT_BUFFER_SIZE - conn->head : conn->length;
+    char *found;
+
+    found = memchr(conn->input + conn->head, END_OF_MESSAGE, first_len);
+    if (found) return found - (conn->input + conn->head);
+
+    found = memchr(conn->input, END_OF_MESSAGE, conn->length - first_len);
+    if (found) return first_len + (found - conn->input);
+
+    return -1;
+}
+
+/**
+ * @brief Drops bytes from the head of the input
+ *
+ * @param conn state of the connection
+ * @param count number of bytes to drop
+ */
+static void consume_input(connection *conn, size_t count) {
+    conn->head = (conn->head + count) & INPUT_MASK;
+    conn->length -= count;
+}
+
+/**
+ * @brief Extracts next complete message (ended with END OF MESSAGE) from the input buffer, no syscall is made
+ *
+ * @param conn        state of the connection
+ * @param message     the buffer to save the message into (null terminated, without END OF MESSAGE)
+ * @param message_len length of the buffer
+ * @return 0 if there is no complete message in the input,
+ *         length of the message + 1 (same as the old read_socket),
+ *         message_len + 1 if the message doesn't fit into the buffer (the message is dropped)
+ */
+size_t next_message(connection *conn, char *message, size_t message_len) {
+    long end;
+    size_t first_len;
+
+    for (;;) {
+        end = find_end_of_message(conn);
+
+        if (end < 0) {
+            if (conn->length < INPUT_BUFFER_SIZE) return 0;
+            /* whole buffer without END OF MESSAGE, drop it and the rest of the message */
+            consume_input(conn, conn->length);
+            if (conn->discarding) return 0;
+            conn->discarding = 1;
+            return message_len + 1;
+        }
+
+        if (conn->discarding) {
+            /* end of the message which was already reported as too long */
+            consume_input(conn, end + 1);
+            conn->discarding = 0;
+            continue;
+        }
+
+        if (end >= message_len) {
+            consume_input(conn, end + 1);
+            return message_len + 1;
+        }
+
+        first_len = conn->head + end > INPUT_BUFFER_SIZE ? INPUT_BUFFER_SIZE - conn->head : end;
+        memcpy(message, conn->input + conn->head, first_len);
+        memcpy(message + first_len, conn->input, end - first_len);
+        message[end] = '\0';
+        consume_input(conn, end + 1);
+        return end + 1;
+    }
+}
+
+/**
+ * @brief Appends the chunk at the end of the output queue
+ *
+ * @param conn  state of the connection
+ * @param chunk the chunk
+ */
+static void append_chunk(connection *conn, output_chunk *chunk) {
+    chunk->next = NULL;
+    if (conn->output_tail)
+        conn->output_tail->next = chunk;
+    else
+        conn->output_head = chunk;
+    conn->output_tail = chunk;
+    conn->output_length += chunk->length;
+}
+
+/**
+ * @brief Copies the data at the end of the output queue
+ *        (into the last chunk if there is enough space in it)
+ *
+ * @param conn   state of the connection
+ * @param data   data to queue
+ * @param length number of bytes
+ * @return 0 on success, -1 if it's not possible to allocate memory
+ */
+static int queue_data(connection *conn, const char *data, size_t length) {
+    output_chunk *tail = conn->output_tail;
+    output_chunk *chunk;
+    size_t capacity;
+
+    if (tail && tail->fd < 0 && tail->offset + tail->length + length <= tail->capacity) {
+        memcpy(tail->data + tail->offset + tail->length, data, length);
+        tail->length += length;
+        conn->output_length += length;
+        return 0;
+    }
+
+    capacity = length > OUTPUT_CHUNK_SIZE ? length : OUTPUT_CHUNK_SIZE;
+    chunk = malloc(sizeof(output_chunk) + capacity);
+    if (!chunk) return -1;
+    chunk->fd = -1;
+    chunk->offset = 0;
+    chunk->length = length;
+    chunk->capacity = capacity;
+    memcpy(chunk->data, data, length);
+    append_chunk(conn, chunk);
+    return 0;
+}
+
+/**
+ * @brief Sends the data to the client without blocking, the part which can't be sent now
+ *        is queued and sent by flush_output when the socket is writable
+ *
+ * @param conn   state of the connection
+ * @param data   data to send
+ * @param length number of bytes
+ * @return 0 if the data was sent or queued, -1 if the connection failed
+ */
+int conn_send(connection *conn, const char *data, size_t length) {
+    ssize_t n;
+    if (conn->failed) return -1;
+
+    /* nothing is waiting before the data, try to send it directly without copying */
+    while (!conn->output_head && length > 0) {
+        n = send(conn->fd, data, length, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            conn->failed = 1;
+            return -1;
+        }
+        data += n;
+        length -= n;
+    }
+    if (!length) return 0;
+
+    if (queue_data(conn, data, length)) {
+        conn->failed = 1;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Sends part of the file to the client without copying it into user space and without blocking,
+ *        the part which can't be sent now is queued (with duplicated fd, so the range stays valid)
+ *
+ * @param conn   state of the connection
+ * @param fd     file descriptor of the file
+ * @param offset offset of the data in the file
+ * @param length number of bytes to send
+ * @return 0 if the data was sent or queued, -1 if the connection failed
+ */
+int conn_sendfile(connection *conn, int fd, off_t offset, size_t length) {
+    output_chunk *chunk;
+    ssize_t n;
+    if (conn->failed) return -1;
+
+    while (!conn->output_head && length > 0) {
+        n = sendfile(conn->fd, fd, &offset, length);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            conn->failed = 1;
+            return -1;
+        }
+        if (n == 0) {
+            /* the file is shorter than expected */
+            conn->failed = 1;
+            return -1;
+        }
+        length -= n;
+    }
+    if (!length) return 0;
+
+    chunk = malloc(sizeof(output_chunk));
+    if (!chunk || (fd = fcntl(fd, F_DUPFD_CLOEXEC, 0)) < 0) {
+        free(chunk);
+        conn->failed = 1;
+        return -1;
+    }
+    chunk->fd = fd;
+    chunk->offset = offset;
+    chunk->length = length;
+    chunk->capacity = 0;
+    append_chunk(conn, chunk);
+    return 0;
+}
+
+/**
+ * @brief Sends as much of the output queue as the socket accepts without blocking
+ *
+ * @param conn state of the connection
+ * @return 0 if the queue was sent or the socket is full, -1 if the connection failed
+ */
+int flush_output(connection *conn) {
+    output_chunk *chunk;
+    ssize_t n;
+
+    while ((chunk = conn->output_head)) {
+        if (chunk->fd < 0)
+            n = send(conn->fd, chunk->data + chunk->offset, chunk->length, MSG_NOSIGNAL);
+        else
+            n = sendfile(conn->fd, chunk->fd, &chunk->offset, chunk->length);
+
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+            conn->failed = 1;
+            return -1;
+        }
+        if (n == 0) {
+            conn->failed = 1;
+            return -1;
+        }
+
+        if (chunk->fd < 0) chunk->offset += n;
+        chunk->length -= n;
+        conn->output_length -= n;
+        if (chunk->length) continue;
+
+        conn->output_head = chunk->next;
+        if (!conn->output_head) conn->output_tail = NULL;
+        if (chunk->fd >= 0) close(chunk->fd);
+        free(chunk);
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+#ifndef ___C_CONNECTION___
+#define ___C_CONNECTION___
+
+#include <stddef.h>
+#include <time.h>
+#include <sys/types.h>
+
+#define END_OF_MESSAGE '\x04'
+/* size of the input ring buffer, must be a power of two */
+#define INPUT_BUFFER_SIZE 16384
+/* when more bytes wait in the output queue, no more commands of the client are processed
+   until the client reads them (slow client can't make the server buffer unlimited data) */
+#define OUTPUT_HIGH_WATER (4 * 1024 * 1024)
+
+/**
+ * One chunk of the output waiting to be sent
+ * fd < 0  - bytes stored in data (offset is the position of the first unsent byte)
+ * fd >= 0 - part of the file sent by sendfile (fd is a duplicate owned by the chunk)
+ */
+typedef struct output_chunk {
+    struct output_chunk *next;
+    int fd;
+    off_t offset;
+    size_t length;
+    size_t capacity;
+    char data[];
+} output_chunk;
+
+/**
+ * State of one client connection
+ * input is a ring buffer of received bytes, which were not processed yet
+ * output is a queue of the responses which didn't fit into the socket yet
+ */
+typedef struct connection {
+    int fd;
+    char input[INPUT_BUFFER_SIZE];
+    size_t head;
+    size_t length;
+    /* the current message is too long, bytes are dropped until the END OF MESSAGE */
+    char discarding;
+
+    output_chunk *output_head;
+    output_chunk *output_tail;
+    size_t output_length;
+
+    /* time of the last received data, used for the idle timeout */
+    time_t last_active;
+    /* the client asked to disconnect, the connection is closed once the output is sent */
+    char closing;
+    /* sending failed, the connection is closed */
+    char failed;
+    /* responses are sent as binary messages (binary command) instead of text */
+    char binary;
+
+    /* new frames are pushed to the client (subscribe command), as CSV or encoded against the pushed frame */
+    char subscribed;
+    char subscribe_delta;
+    /* a new frame was published while the client was reading the previous output,
+       only the latest frame is pushed once the output is sent */
+    char push_pending;
+    int pushed_frame;
+    /* frames of this scenario are sent (scenario command), 0 is the main simulation */
+    int scenario;
+
+    /* send_range in progress - frames are queued only while the output is under OUTPUT_HIGH_WATER,
+       the rest is queued once the client reads them, no other command is processed meanwhile */
+    char range_active;
+    char range_delta;
+    int range_next;
+    int range_to;
+    int range_stride;
+    /* frame the next delta frame is encoded against, -1 for key frame */
+    int range_base;
+    int range_sent;
+
+    /* the connection is registered in the epoll for the events */
+    char registered;
+    unsigned int events;
+
+    /* list of all the connections of the server */
+    struct connection *prev;
+    struct connection *next;
+} connection;
+
+connection *create_connection_state(int fd);
+void free_connection_state(connection **conn);
+ssize_t fill_input(connection *conn);
+size_t next_message(connection *conn, char *message, size_t message_len);
+int conn_send(connection *conn, const char *data, size_t length);
+int conn_sendfile(connection *conn, int fd, off_t offset, size_t length);
+int flush_output(connection *conn);
+
+#endif
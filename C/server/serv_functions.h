@@ -5,15 +5,250 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <string.h>
+#include "connection.h"
 #include "../simulation/simulation.h"
+#include "../simulation/frameStore.h"
+#include "../simulation/frameCodec.h"
+#include "../simulation/citySeries.h"
+#include "../simulation/scenario.h"
 
-#define SEND_MAX_SIZE 4194304
-#define NO_DATA_MESSAGE "no data\x04"
+/* text responses, followed by the end of transmission char (or sent as MSG_TYPE_TEXT in binary mode) */
+#define NO_DATA_MESSAGE "no data"
+#define SUBSCRIBED_MESSAGE "subscribed"
+/* response to fork_scenario and scenario, followed by the id of the scenario */
+#define SCENARIO_MESSAGE_FORMAT "scenario %d"
+/* override of fork_scenario with the number of the days of the scenario */
+#define SCENARIO_DAYS_ARGUMENT "DAYS"
+#define UNSUBSCRIBED_MESSAGE "unsubscribed"
+#define EXIT_MESSAGE "exit"
+#define BINARY_MESSAGE "binary"
+#define DELTA_ARGUMENT "delta"
+/* header of the encoded frame: number of frame, base frame (-1 for key frame) and length of the data */
+#define FRAME_HEADER_FORMAT "frame %d %d %d\n"
+/* header of the frame formatted as CSV in the range response: number of frame and length of the CSV */
+#define FRAME_CSV_HEADER_FORMAT "csv %d %d\n"
+#define FRAME_HEADER_MAX_LEN 48
+#define DISTRICTS_ARGUMENT "districts"
+#define STATS_HEADER "datum,pocet_obyvatel,pocet_nakazenych,novych_nakazenych,uzdravenych,zemrelych\n"
+#define DISTRICTS_HEADER "kod_okres,pocet_obyvatel,pocet_nakazenych\n"
+#define TOPK_HEADER "kod_obce,pocet_obyvatel,pocet_nakazenych\n"
+#define SERIES_HEADER "datum,pocet_obyvatel,pocet_nakazenych\n"
+#define SCENARIOS_HEADER "id,name,fork_day,latest_day,failed,end_day\n"
+#define BBOX_CELLS_HEADER "latitude,longitude,pocet_obci,pocet_obyvatel,pocet_nakazenych\n"
+/* longest row of the cell - two coordinates, three numbers, four commas and a new line */
+#define BBOX_CELL_MAX_ROW 80
+/* maximal number of frames sent as response to one send_range */
+#define RANGE_MAX_FRAMES 4096
+
+/* BINARY MODE (negotiated by the binary command)
+   every response is a message - type (1 byte) and length of the payload (4 bytes, little-endian),
+   followed by the payload, all the numbers in the payloads are little-endian int32 */
+#define MSG_HEADER_SIZE 5
+/* text response (same as in text mode, without the end of transmission char) */
+#define MSG_TYPE_TEXT 1
+/* frame: number of frame, number of cities n, population of n cities, infected of n cities */
+#define MSG_TYPE_FRAME 2
+/* frame encoded by frameCodec: number of frame, base frame (-1 for key frame), encoded data */
+#define MSG_TYPE_ENCODED_FRAME 3
+/* ids of the cities in the order of the frames: number of cities n, n ids */
+#define MSG_TYPE_CITIES 4
+/* end of the response with more messages (send_range), empty payload */
+#define MSG_TYPE_END 5
 
 char SIM_STARTED = 0;
+/* read only view of the frames written by the simulation thread, opened on first request */
+frameStore *FRAME_STORE = NULL;
+
+/* read only view of the city-major copy of the frames, opened on first request */
+citySeries *CITY_SERIES = NULL;
+
+/* read only views of the frame stores of the scenarios (index is the id of the scenario), opened on first request */
+frameStore *SCENARIO_STORES[SCENARIO_MAX + 1] = {NULL};
 
-void *out(int connfd, void *arg) {
-    write(connfd, "exit\x04", strlen("exit\x04"));
+/* buffers for the responses, allocated together with FRAME_STORE and reused by all the requests */
+int *FRAME_VALUES = NULL;
+int *FRAME_BASE_VALUES = NULL;
+unsigned char *FRAME_BLOCK = NULL;
+char *FRAME_CSV = NULL;
+
+/**
+ * @brief Returns the frame store of the simulation, opens it if it's not opened yet
+ *        (together with the buffers for the responses)
+ *
+ * @return pointer to the frame store or NULL if the simulation didn't create it yet
+ */
+frameStore *get_frame_store() {
+    int n;
+    if (FRAME_STORE) return FRAME_STORE;
+
+    FRAME_STORE = openFrameStore(FRAME_STORE_FILEPATH, FRAME_INDEX_FILEPATH, 0);
+    if (!FRAME_STORE) return NULL;
+
+    n = FRAME_STORE->numberOfCities;
+    FRAME_VALUES = malloc(2 * n * sizeof(int));
+    FRAME_BASE_VALUES = malloc(2 * n * sizeof(int));
+    FRAME_BLOCK = malloc(frameStoreBlockMaxSize(FRAME_STORE));
+    FRAME_CSV = malloc(frameStoreCsvSize(FRAME_STORE) + 1);
+    if (!FRAME_VALUES || !FRAME_BASE_VALUES || !FRAME_BLOCK || !FRAME_CSV) {
+        free(FRAME_VALUES);
+        free(FRAME_BASE_VALUES);
+        free(FRAME_BLOCK);
+        free(FRAME_CSV);
+        freeFrameStore(&FRAME_STORE);
+    }
+    return FRAME_STORE;
+}
+
+/**
+ * @brief Returns the scenario selected by the connection (scenario command)
+ *
+ * @param conn state of the connection
+ * @return pointer to the forked scenario or NULL for the main simulation
+ */
+scenario *get_scenario(connection *conn) {
+    scenario *branch = scenarioGet(conn->scenario);
+    return branch && atomic_load(&branch->forkDay) >= 0 ? branch : NULL;
+}
+
+/**
+ * @brief Returns the frame store of the scenario selected by the connection (opens it if it's not opened yet),
+ *        the frame store of the main simulation if no scenario is selected
+ *
+ * @param conn state of the connection
+ * @return pointer to the frame store or NULL if the simulation (or the scenario) didn't create it yet
+ */
+frameStore *get_connection_store(connection *conn) {
+    frameStore *store = get_frame_store();
+    char data_path[SCENARIO_PATH_LENGTH], index_path[SCENARIO_PATH_LENGTH];
+
+    if (!store || !conn->scenario) return store;
+    if (SCENARIO_STORES[conn->scenario]) return SCENARIO_STORES[conn->scenario];
+    if (!get_scenario(conn)) return NULL;
+
+    sprintf(data_path, SCENARIO_STORE_FORMAT, conn->scenario);
+    sprintf(index_path, SCENARIO_INDEX_FORMAT, conn->scenario);
+    SCENARIO_STORES[conn->scenario] = openFrameStore(data_path, index_path, 0);
+    if (SCENARIO_STORES[conn->scenario] && SCENARIO_STORES[conn->scenario]->numberOfCities != store->numberOfCities)
+        freeFrameStore(&SCENARIO_STORES[conn->scenario]);
+    return SCENARIO_STORES[conn->scenario];
+}
+
+/**
+ * @brief Copies the frame from the ring of the running simulation (FRAME_RING) or of the selected scenario,
+ *        no file is touched
+ *
+ * @param conn       state of the connection
+ * @param store      frame store (the ring must contain the same cities)
+ * @param frame      number of the frame
+ * @param population output array
+ * @param infected   output array
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the frame is not in the ring
+ */
+int read_ring_frame(connection *conn, frameStore *store, int frame, int *population, int *infected) {
+    scenario *branch = get_scenario(conn);
+    frameRing *ring = branch ? branch->ring : atomic_load(&FRAME_RING);
+    if (!ring || ring->numberOfCities != store->numberOfCities) return EXIT_FAILURE;
+    return frameRingRead(ring, frame, population, infected);
+}
+
+/**
+ * @brief Reads the frame from the memory of the simulation, older frames from the frame store
+ *        (days of the selected scenario before its fork are the days of the main simulation)
+ *
+ * @param conn       state of the connection
+ * @param store      frame store
+ * @param frame      number of the frame
+ * @param population output array
+ * @param infected   output array
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the frame doesn't exist
+ */
+int read_frame(connection *conn, frameStore *store, int frame, int *population, int *infected) {
+    scenario *branch = get_scenario(conn);
+    frameRing *ring;
+
+    if (branch && frame <= atomic_load(&branch->forkDay)) {
+        ring = atomic_load(&FRAME_RING);
+        if (ring && ring->numberOfCities == store->numberOfCities &&
+            frameRingRead(ring, frame, population, infected) == EXIT_SUCCESS)
+            return EXIT_SUCCESS;
+        return frameStoreReadFrame(get_frame_store(), frame, population, infected);
+    }
+    if (read_ring_frame(conn, store, frame, population, infected) == EXIT_SUCCESS) return EXIT_SUCCESS;
+    return frameStoreReadFrame(store, frame, population, infected);
+}
+
+/**
+ * @brief Converts the ints to little-endian (the byte order of the binary mode) in place
+ *
+ * @param values ints to convert
+ * @param count  number of the ints
+ */
+void to_little_endian(int *values, size_t count) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    size_t i;
+    for (i = 0; i < count; i++)
+        values[i] = (int) __builtin_bswap32((unsigned int) values[i]);
+#endif
+}
+
+/**
+ * @brief Queues the header of the message of the binary mode followed by the ints of the payload
+ *
+ * @param conn    state of the connection
+ * @param type    type of the message (MSG_TYPE_*)
+ * @param length  length of the whole payload in bytes
+ * @param ints    ints at the start of the payload (converted to little-endian in place)
+ * @param count   number of the ints (at most 2)
+ */
+void queue_message_header(connection *conn, int type, size_t length, int *ints, int count) {
+    unsigned char header[MSG_HEADER_SIZE + 2 * sizeof(int)];
+
+    header[0] = (unsigned char) type;
+    header[1] = length & 0xFF;
+    header[2] = (length >> 8) & 0xFF;
+    header[3] = (length >> 16) & 0xFF;
+    header[4] = (length >> 24) & 0xFF;
+    if (count) {
+        to_little_endian(ints, count);
+        memcpy(header + MSG_HEADER_SIZE, ints, count * sizeof(int));
+    }
+    conn_send(conn, (const char *) header, MSG_HEADER_SIZE + count * sizeof(int));
+}
+
+/**
+ * @brief Sends the text response - followed by the end of transmission char in text mode,
+ *        as MSG_TYPE_TEXT message in binary mode
+ *
+ * @param conn    state of the connection
+ * @param message the text
+ */
+void send_message(connection *conn, const char *message) {
+    size_t length = strlen(message);
+
+    if (conn->binary) {
+        queue_message_header(conn, MSG_TYPE_TEXT, length, NULL, 0);
+        conn_send(conn, message, length);
+        return;
+    }
+    conn_send(conn, message, length);
+    conn_send(conn, "\x04", 1);
+}
+
+/**
+ * @brief Ends the response with one frame (send_data, pushed frame),
+ *        the end of transmission char in text mode, nothing in binary mode (the message has its length)
+ *
+ * @param conn    state of the connection
+ */
+void end_frame_response(connection *conn) {
+    if (!conn->binary)
+        conn_send(conn, "\x04", 1);
+}
+
+void *out(connection *conn, void *arg) {
+    send_message(conn, EXIT_MESSAGE);
+    if (TRACE_ENABLED) traceClose();
     exit(0);
 }
 
@@ -21,11 +256,11 @@ void *out(int connfd, void *arg) {
  * @brief Starts the simulation in another thread. The simulaition can be started only once!
  *        for more info, read description of the start_and_loop function in simulation.c
  * 
- * @param connfd the connection file descriptor (unused)
+ * @param conn   the connection (unused)
  * @param arg    unused
  * @return void* pointer to the thread id of the constructed thread or NULL if the simulation already running
  */
-void *start_simulation(int connfd, void *arg) {
+void *start_simulation(connection *conn, void *arg) {
     if (SIM_STARTED) {
         printf("Simulation already running\n");
         return NULL;
@@ -41,71 +276,730 @@ void *start_simulation(int connfd, void *arg) {
 
 }
 
+/**
+ * @brief Queues the frame encoded by frameCodec against the base frame (without the end of transmission).
+ * If the stored block is already encoded against the base, it is sent directly from the
+ * data file of the store (sendfile, no copy into user space), otherwise the frame is re-encoded.
+ * Frame is sent as FRAME_HEADER_FORMAT followed by the encoded data (MSG_TYPE_ENCODED_FRAME in binary mode).
+ *
+ * @param conn   state of the connection
+ * @param store  frame store
+ * @param frame  number of frame to send
+ * @param base   number of frame the client already has, -1 for key frame
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the frame (or the base) is not in the store (nothing is sent)
+ */
+int queue_encoded_frame(connection *conn, frameStore *store, int frame, int base) {
+    frameIndexEntry entry;
+    char header[FRAME_HEADER_MAX_LEN];
+    int n = store->numberOfCities;
+    char stored = 0;
+
+    if (base < 0) base = -1;
+
+    /* recent frames are encoded from the memory of the simulation, the store is not touched */
+    if (read_ring_frame(conn, store, frame, FRAME_VALUES, FRAME_VALUES + n) == EXIT_FAILURE ||
+        (base >= 0 && read_ring_frame(conn, store, base, FRAME_BASE_VALUES, FRAME_BASE_VALUES + n) == EXIT_FAILURE)) {
+        /* shared days of a scenario are not in its store, they are read by read_frame */
+        if (frameStoreReadEntry(store, frame, &entry) == EXIT_FAILURE) entry.encoding = FRAME_ENCODING_NONE;
+
+        stored = (entry.encoding == FRAME_ENCODING_DELTA && base == frame - 1) ||
+                 (entry.encoding == FRAME_ENCODING_KEY && base == -1);
+        if (!stored && ((base >= 0 && read_frame(conn, store, base, FRAME_BASE_VALUES, FRAME_BASE_VALUES + n) == EXIT_FAILURE) ||
+                        read_frame(conn, store, frame, FRAME_VALUES, FRAME_VALUES + n) == EXIT_FAILURE))
+            return EXIT_FAILURE;
+    }
+    if (!stored)
+        entry.length = (int) frameEncode(FRAME_VALUES, base >= 0 ? FRAME_BASE_VALUES : NULL, 2 * n, FRAME_BLOCK);
+
+    if (conn->binary) {
+        int numbers[2] = {frame, base};
+        queue_message_header(conn, MSG_TYPE_ENCODED_FRAME, 2 * sizeof(int) + entry.length, numbers, 2);
+    } else {
+        sprintf(header, FRAME_HEADER_FORMAT, frame, base, entry.length);
+        conn_send(conn, header, strlen(header));
+    }
+    if (stored)
+        conn_sendfile(conn, fileno(store->data), (off_t) entry.offset, entry.length);
+    else
+        conn_send(conn, (const char *) FRAME_BLOCK, entry.length);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Queues the frame formatted as CSV with FRAME_CSV_HEADER_FORMAT before it (without the end of transmission),
+ * in binary mode as MSG_TYPE_FRAME message (the counters are sent as they are, no formatting)
+ *
+ * @param conn   state of the connection
+ * @param store  frame store
+ * @param frame  number of frame to send
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the frame is not in the store (nothing is sent)
+ */
+int queue_frame(connection *conn, frameStore *store, int frame) {
+    char header[FRAME_HEADER_MAX_LEN];
+    int n = store->numberOfCities;
+    size_t length;
+
+    if (read_frame(conn, store, frame, FRAME_VALUES, FRAME_VALUES + n) == EXIT_FAILURE)
+        return EXIT_FAILURE;
+
+    if (conn->binary) {
+        int numbers[2] = {frame, n};
+        queue_message_header(conn, MSG_TYPE_FRAME, (2 + 2 * (size_t) n) * sizeof(int), numbers, 2);
+        to_little_endian(FRAME_VALUES, 2 * n);
+        conn_send(conn, (const char *) FRAME_VALUES, 2 * n * sizeof(int));
+        return EXIT_SUCCESS;
+    }
+
+    length = frameStoreFormatCsv(store, frame, FRAME_VALUES, FRAME_VALUES + n, FRAME_CSV);
+    sprintf(header, FRAME_CSV_HEADER_FORMAT, frame, (int) length);
+    conn_send(conn, header, strlen(header));
+    conn_send(conn, FRAME_CSV, length);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Sends the frame encoded by frameCodec against the base frame (see queue_encoded_frame)
+ * Response is FRAME_HEADER_FORMAT, encoded data and the end of transmission char.
+ *
+ * @param conn   state of the connection
+ * @param store  frame store
+ * @param frame  number of frame to send
+ * @param base   number of frame the client already has, -1 for key frame
+ */
+void send_encoded_frame(connection *conn, frameStore *store, int frame, int base) {
+    if (queue_encoded_frame(conn, store, frame, base) == EXIT_FAILURE) {
+        send_message(conn, NO_DATA_MESSAGE);
+        return;
+    }
+    end_frame_response(conn);
+}
+
 /**
  * @brief Sends the CSV data from the simulation. 
- * The CSV is on a path specified by the CSV_NAME_FORMAT constant defined in simulation.h
- * The first argument of this command is taken as the number of frame and sprintf'd into the format.
- * The CSV is sent as 4 MB* chunks of text until the end of the file - so the client might recieve more messages (if the csv is more than 4 MB)
- * After the CSV is completely sent, server will send a string with only a char with the value 4 ('\x04' - ascii character for end of transmission)
- * and then, the command is done
+ * The frame is read from the frame store (FRAME_STORE_FILEPATH defined in frameStore.h) and formatted
+ * as CSV (kod_obce,pocet_obyvatel,pocet_nakazenych,datum).
+ * The first argument of this command is taken as the number of frame.
+ * The CSV is sent followed by a char with the value 4 ('\x04' - ascii character for end of transmission)
+ * and then, the command is done. If the frame doesn't exist (yet), "no data" is sent instead.
+ *
+ * If the second argument is "delta", the frame is sent encoded (see send_encoded_frame) against the frame
+ * given by the third argument (default is the previous frame, negative number means key frame).
+ * Values are population of all the cities followed by infected of all the cities, in the order of the CSV.
+ * In binary mode, the frame is sent as MSG_TYPE_FRAME (or MSG_TYPE_ENCODED_FRAME with "delta") message.
  * 
- * *4 MB = 4194304 B
- * 
- * @param connfd connection descriptor
- * @param arg    pointer to the arguments string as if passed in command line - "<command_name> <arg1>",
- *               <arg1> being the number of frame to send
+ * @param conn   state of the connection
+ * @param arg    pointer to the arguments string as if passed in command line -
+ *               "<command_name> <arg1> [delta [<arg3>]]", <arg1> being the number of frame to send
  * @return NULL
  */
-void *send_data_from_simulation(int connfd, void *arg) {
-    char *bff = malloc(SEND_MAX_SIZE * sizeof(char));
+void *send_data_from_simulation(connection *conn, void *arg) {
+    frameStore *store;
+    char mode[16] = {0};
+    size_t length;
+    int args, base;
 
     int frame = 0;
-    sscanf((const char *) arg, "%*s %d", &frame);
+    args = sscanf((const char *) arg, "%*s %d %15s %d", &frame, mode, &base);
 
-    /* debug
-    printf((const char *)arg);
-    printf("\n");
-    printf("frame: %i\n", frame);
-    return;*/
+    store = get_connection_store(conn);
+    if (store && args >= 2 && !strcmp(mode, DELTA_ARGUMENT)) {
+        send_encoded_frame(conn, store, frame, args == 3 ? base : frame - 1);
+        return NULL;
+    }
 
-    char fname[40] = {0};
-    sprintf(fname, CSV_NAME_FORMAT, frame);
+    if (store && conn->binary) {
+        if (queue_frame(conn, store, frame) == EXIT_FAILURE)
+            send_message(conn, NO_DATA_MESSAGE);
+        return NULL;
+    }
 
-    printf("Sending data from %s\n", fname);
+    if (!store || read_frame(conn, store, frame, FRAME_VALUES, FRAME_VALUES + store->numberOfCities) == EXIT_FAILURE) {
+        send_message(conn, NO_DATA_MESSAGE);
+        return NULL;
+    }
+
+    /* the csv and the end of transmission are sent at once */
+    length = frameStoreFormatCsv(store, frame, FRAME_VALUES, FRAME_VALUES + store->numberOfCities, FRAME_CSV);
+    FRAME_CSV[length++] = '\x04';
+    conn_send(conn, FRAME_CSV, length);
+    return NULL;
+}
+
+/**
+ * @brief Queues the next frames of the send_range in progress while the output of the client is under
+ * OUTPUT_HIGH_WATER, the end of the response is queued after the last frame of the range.
+ *
+ * @param conn   state of the connection
+ */
+void continue_range(connection *conn) {
+    frameStore *store = get_connection_store(conn);
+    int frame;
 
-    FILE *csv;
-    if (!(csv = fopen((const char *) fname, "r"))) {
-        write(connfd, NO_DATA_MESSAGE, strlen(NO_DATA_MESSAGE));
+    while (conn->range_active && conn->output_length < OUTPUT_HIGH_WATER) {
+        frame = conn->range_next;
+        if (!store || frame < 0 || conn->range_sent >= RANGE_MAX_FRAMES ||
+            (conn->range_delta ? queue_encoded_frame(conn, store, frame, conn->range_base)
+                               : queue_frame(conn, store, frame))) {
+            conn->range_active = 0;
+            break;
+        }
+        conn->range_base = frame;
+        conn->range_sent++;
+        /* -1 ends the range after the frame <to> (without overflow of the next frame) */
+        conn->range_next = conn->range_to - frame < conn->range_stride ? -1 : frame + conn->range_stride;
+    }
+    if (conn->range_active)
+        return;
+
+    if (!conn->range_sent)
+        send_message(conn, NO_DATA_MESSAGE);
+    else if (conn->binary)
+        queue_message_header(conn, MSG_TYPE_END, 0, NULL, 0);
+    else
+        conn_send(conn, "\x04", 1);
+}
+
+/**
+ * @brief Sends more frames in one response - frames <from>, <from> + <stride>, ... up to <to> (inclusive).
+ * Every frame is sent with its own header - FRAME_CSV_HEADER_FORMAT followed by the CSV, or with "delta"
+ * FRAME_HEADER_FORMAT followed by the frame encoded against the previous frame of the response
+ * (the first one against <base>, default is key frame). Frames follow each other without any separator
+ * and the response ends with the end of transmission char (MSG_TYPE_END message in binary mode,
+ * frames are sent as MSG_TYPE_FRAME or MSG_TYPE_ENCODED_FRAME messages). The range ends before the first frame,
+ * which is not in the store, at most RANGE_MAX_FRAMES frames are sent.
+ * If there is no frame to send, "no data" is sent instead.
+ * Frames are queued only while the output of the client is under OUTPUT_HIGH_WATER, the rest of the range
+ * is queued by continue_range once the client reads them.
+ *
+ * @param conn   state of the connection
+ * @param arg    pointer to the arguments string - "<command_name> <from> <to> [<stride> [delta [<base>]]]"
+ * @return NULL
+ */
+void *send_range(connection *conn, void *arg) {
+    char mode[16] = {0};
+    int from = 0, to = 0, stride = 1, base = -1;
+    int args;
+
+    args = sscanf((const char *) arg, "%*s %d %d %d %15s %d", &from, &to, &stride, mode, &base);
+    if (!get_connection_store(conn) || from < 0 || from > to) {
+        send_message(conn, NO_DATA_MESSAGE);
         return NULL;
     }
 
+    conn->range_active = 1;
+    conn->range_delta = args >= 4 && !strcmp(mode, DELTA_ARGUMENT);
+    conn->range_next = from;
+    conn->range_to = to;
+    conn->range_stride = stride < 1 ? 1 : stride;
+    conn->range_base = base;
+    conn->range_sent = 0;
+    continue_range(conn);
+    return NULL;
+}
+
+/**
+ * @brief Pushes the latest frame of the simulation to the subscribed client (as CSV or encoded against
+ * the previously pushed frame, the first one as key frame), in the same format as the frames of send_range
+ * followed by the end of transmission char (one message in binary mode).
+ * If the client didn't read the previous output yet, the push is postponed until it's sent - the days
+ * published in between are skipped (coalesced), the client gets only the latest state.
+ *
+ * @param conn   state of the subscribed connection
+ */
+void push_latest_frame(connection *conn) {
+    frameStore *store;
+    scenario *branch = get_scenario(conn);
+    int latest = frameRingLatest(branch ? branch->ring : atomic_load(&FRAME_RING));
+
+    if (!conn->subscribed || latest <= conn->pushed_frame) {
+        conn->push_pending = 0;
+        return;
+    }
+    if (conn->output_head || conn->range_active) {
+        conn->push_pending = 1;
+        return;
+    }
+
+    conn->push_pending = 0;
+    store = get_connection_store(conn);
+    if (!store)
+        return;
+    if (conn->subscribe_delta ? queue_encoded_frame(conn, store, latest, conn->pushed_frame)
+                              : queue_frame(conn, store, latest))
+        return;
+    end_frame_response(conn);
+    conn->pushed_frame = latest;
+}
+
+/**
+ * @brief Subscribes the client to the new frames - every finished day of the simulation is pushed without
+ * any request (see push_latest_frame), starting with the latest frame. Server responds with "subscribed".
+ * The connection is not closed as idle while subscribed.
+ *
+ * @param conn   state of the connection
+ * @param arg    pointer to the arguments string - "<command_name> [csv|delta]", default is csv
+ * @return NULL
+ */
+void *subscribe(connection *conn, void *arg) {
+    char mode[16] = {0};
+    sscanf((const char *) arg, "%*s %15s", mode);
+
+    conn->subscribed = 1;
+    conn->subscribe_delta = !strcmp(mode, DELTA_ARGUMENT);
+    conn->pushed_frame = -1;
+    send_message(conn, SUBSCRIBED_MESSAGE);
+    push_latest_frame(conn);
+    return NULL;
+}
 
-    int i = 0, next;
+/**
+ * @brief Stops pushing of the new frames to the client, server responds with "unsubscribed"
+ *
+ * @param conn   state of the connection
+ * @param arg    unused
+ * @return NULL
+ */
+void *unsubscribe(connection *conn, void *arg) {
+    conn->subscribed = 0;
+    conn->push_pending = 0;
+    send_message(conn, UNSUBSCRIBED_MESSAGE);
+    return NULL;
+}
 
-    /* go through all characters of the csv, filling the buffer
-       if buffer is full, send all its data, free it and continue from begining
-     */
-    while ((next = fgetc(csv)) != EOF) {
-        bff[i] = (char) next;
+/**
+ * @brief Switches the connection into binary mode (see MSG_TYPE_*), all the following responses are messages
+ * with type and length instead of text ended by the end of transmission char. Server responds with "binary"
+ * (the last text response).
+ *
+ * @param conn   state of the connection
+ * @param arg    unused
+ * @return NULL
+ */
+void *binary_mode(connection *conn, void *arg) {
+    send_message(conn, BINARY_MESSAGE);
+    conn->binary = 1;
+    return NULL;
+}
 
-        if (i == SEND_MAX_SIZE) {
-            write(connfd, bff, SEND_MAX_SIZE);
-            bzero(bff, SEND_MAX_SIZE);
-            i = -1; /* next line of code will set this to 0 */
+/**
+ * @brief Sends the ids of the cities (kod_obce) in the order of the frames - one id per line after the header
+ * "kod_obce" in text mode, MSG_TYPE_CITIES message in binary mode. If the simulation didn't create the frame store
+ * yet, "no data" is sent instead.
+ *
+ * @param conn   state of the connection
+ * @param arg    unused
+ * @return NULL
+ */
+void *send_cities(connection *conn, void *arg) {
+    frameStore *store = get_frame_store();
+    char *position;
+    int i, n;
+
+    if (!store) {
+        send_message(conn, NO_DATA_MESSAGE);
+        return NULL;
+    }
+    n = store->numberOfCities;
+
+    if (conn->binary) {
+        memcpy(FRAME_VALUES, store->cityIds, n * sizeof(int));
+        queue_message_header(conn, MSG_TYPE_CITIES, (1 + (size_t) n) * sizeof(int), &n, 1);
+        to_little_endian(FRAME_VALUES, n);
+        conn_send(conn, (const char *) FRAME_VALUES, n * sizeof(int));
+        return NULL;
+    }
+
+    /* FRAME_CSV fits a row with four numbers for each city */
+    position = FRAME_CSV + sprintf(FRAME_CSV, "kod_obce\n");
+    for (i = 0; i < n; i++)
+        position += sprintf(position, "%d\n", store->cityIds[i]);
+    *position++ = '\x04';
+    conn_send(conn, FRAME_CSV, position - FRAME_CSV);
+    return NULL;
+}
+
+/**
+ * @brief Returns the aggregates of the day computed by the simulation (or by the selected scenario)
+ *
+ * @param conn state of the connection
+ * @param date number of the day
+ * @return pointer to the aggregates or NULL if the day was not simulated yet (or the frame store isn't open)
+ */
+const dayStatistics *get_day_statistics(connection *conn, int date) {
+    scenario *branch = get_scenario(conn);
+
+    if (!get_connection_store(conn)) return NULL;
+    if (branch && date > atomic_load(&branch->forkDay)) return statisticsGet(branch->stats, date);
+    return statisticsGet(atomic_load(&STATISTICS), date);
+}
+
+/**
+ * @brief Sends the aggregates of the day as CSV (STATS_HEADER and one row, unknown counters are -1),
+ * with "districts" sums over the districts (DISTRICTS_HEADER and one row per district) instead.
+ * No frame is read - the aggregates are computed by the simulation. If the day doesn't exist (yet),
+ * "no data" is sent instead.
+ *
+ * @param conn   state of the connection
+ * @param arg    pointer to the arguments string - "<command_name> <day> [districts]"
+ * @return NULL
+ */
+void *send_stats(connection *conn, void *arg) {
+    const dayStatistics *day;
+    statistics *stats;
+    char mode[16] = {0};
+    char *position;
+    int date = 0, i;
+
+    sscanf((const char *) arg, "%*s %d %15s", &date, mode);
+    day = get_day_statistics(conn, date);
+    if (!day) {
+        send_message(conn, NO_DATA_MESSAGE);
+        return NULL;
+    }
+
+    if (!strcmp(mode, DISTRICTS_ARGUMENT)) {
+        stats = atomic_load(&STATISTICS);
+        position = FRAME_CSV + sprintf(FRAME_CSV, DISTRICTS_HEADER);
+        for (i = 0; i < stats->numberOfDistricts; i++)
+            position += sprintf(position, "%s,%d,%d\n", stats->districtCodes[i],
+                                day->districtPopulation[i], day->districtInfected[i]);
+    } else
+        sprintf(FRAME_CSV, STATS_HEADER "%d,%lld,%lld,%d,%d,%d\n", day->date, day->population, day->infected,
+                day->newInfected, day->recovered, day->deaths);
+
+    send_message(conn, FRAME_CSV);
+    return NULL;
+}
+
+/**
+ * @brief Sends k cities with the most infected in the day as CSV (TOPK_HEADER and one row per city,
+ * sorted from the most infected), k is at most STATISTICS_TOP_K (default). No frame is read - the cities
+ * are found by the simulation. If the day doesn't exist (yet), "no data" is sent instead.
+ *
+ * @param conn   state of the connection
+ * @param arg    pointer to the arguments string - "<command_name> <day> [<k>]"
+ * @return NULL
+ */
+void *send_topk(connection *conn, void *arg) {
+    const dayStatistics *day;
+    char *position;
+    int date = 0, k = STATISTICS_TOP_K, i;
+
+    sscanf((const char *) arg, "%*s %d %d", &date, &k);
+    day = get_day_statistics(conn, date);
+    if (!day) {
+        send_message(conn, NO_DATA_MESSAGE);
+        return NULL;
+    }
+    if (k > day->topCount) k = day->topCount;
+
+    position = FRAME_CSV + sprintf(FRAME_CSV, TOPK_HEADER);
+    for (i = 0; i < k; i++)
+        position += sprintf(position, "%d,%d,%d\n", FRAME_STORE->cityIds[day->topCities[i]],
+                            day->topPopulation[i], day->topInfected[i]);
+
+    send_message(conn, FRAME_CSV);
+    return NULL;
+}
+
+/**
+ * @brief Returns the city series of the simulation, opens it if it's not opened yet
+ *
+ * @param store frame store (the series must contain the same cities)
+ * @return pointer to the city series or NULL if the simulation didn't create it yet
+ */
+citySeries *get_city_series(frameStore *store) {
+    if (!CITY_SERIES) CITY_SERIES = openCitySeries(CITY_SERIES_FILEPATH, 0);
+    if (!CITY_SERIES || CITY_SERIES->numberOfCities != store->numberOfCities) return NULL;
+    return CITY_SERIES;
+}
+
+/**
+ * @brief Sends the history of one city as CSV (SERIES_HEADER and one row per day). Days already
+ * transposed by the simulation are read from the city series by one read, only the last days
+ * (not written into the series yet) are read from the frames. Days missing in the frame store are skipped.
+ * If the city or the days don't exist, "no data" is sent instead.
+ *
+ * @param conn   state of the connection
+ * @param arg    pointer to the arguments string - "<command_name> <kod_obce> [<from> <to>]",
+ *               default is the whole history
+ * @return NULL
+ */
+void *send_series(connection *conn, void *arg) {
+    frameStore *store;
+    citySeries *series;
+    int *values;
+    char *text, *position;
+    int id = 0, from = 0, to = -1, latest, written, city, n, date, *day;
+    /* the last day shared with the main simulation (-1 without a scenario) */
+    int fork = get_scenario(conn) ? atomic_load(&get_scenario(conn)->forkDay) : -1;
+
+    store = get_connection_store(conn);
+    if (sscanf((const char *) arg, "%*s %d %d %d", &id, &from, &to) < 1 || !store) {
+        send_message(conn, NO_DATA_MESSAGE);
+        return NULL;
+    }
+
+    n = store->numberOfCities;
+    for (city = 0; city < n && store->cityIds[city] != id; city++);
+    latest = frameStoreFrames(store) - 1;
+    if (latest < fork) latest = fork;
+    if (to < 0 || to > latest) to = latest;
+    if (city == n || from < 0 || from > to) {
+        send_message(conn, NO_DATA_MESSAGE);
+        return NULL;
+    }
+
+    values = malloc(2 * (size_t) (to - from + 1) * sizeof(int));
+    text = malloc(strlen(SERIES_HEADER) + (size_t) (to - from + 1) * FRAME_CSV_MAX_ROW + 1);
+    if (!values || !text) {
+        free(values);
+        free(text);
+        send_message(conn, NO_DATA_MESSAGE);
+        return NULL;
+    }
+
+    series = get_city_series(get_frame_store());
+    written = series ? citySeriesDays(series) : 0;
+    /* the city series is written by the main simulation, days of a scenario after its fork are read from frames */
+    if (fork >= 0 && written > fork + 1) written = fork + 1;
+    if (written > to + 1) written = to + 1;
+    if (written <= from || citySeriesRead(series, city, from, written - 1, values) == EXIT_FAILURE)
+        written = from;
+
+    for (date = written; date <= to; date++) {
+        day = values + 2 * (date - from);
+        if (read_frame(conn, store, date, FRAME_VALUES, FRAME_VALUES + n) == EXIT_SUCCESS) {
+            day[0] = FRAME_VALUES[city];
+            day[1] = FRAME_VALUES[n + city];
+        } else
+            day[0] = day[1] = CITY_SERIES_MISSING;
+    }
+
+    position = text + sprintf(text, SERIES_HEADER);
+    for (date = from; date <= to; date++) {
+        day = values + 2 * (date - from);
+        if (day[0] == CITY_SERIES_MISSING) continue;
+        position += sprintf(position, "%d,%d,%d\n", date, day[0], day[1]);
+    }
+
+    send_message(conn, text);
+    free(values);
+    free(text);
+    return NULL;
+}
+
+/**
+ * @brief Sends the cities of the day in the bounding box as CSV (TOPK_HEADER and one row per city),
+ * at level of detail lod > 0 the cities aggregated into the cells of the grid (BBOX_CELLS_HEADER
+ * and one row per cell which intersects the box, coordinates of the cell are the mean of its cities).
+ * Only the cities of the visible cells are touched. If the day doesn't exist (yet), "no data" is sent instead.
+ *
+ * @param conn   state of the connection
+ * @param arg    pointer to the arguments string - "<command_name> <day> <lat1> <lon1> <lat2> <lon2> [<lod>]",
+ *               lod is 0 (cities, default) .. SPATIAL_GRID_LEVELS (one cell)
+ * @return NULL
+ */
+void *send_bbox(connection *conn, void *arg) {
+    frameStore *store;
+    spatialGrid *grid;
+    spatialCell *cells = NULL;
+    int *cities = NULL;
+    char *text = NULL, *position;
+    double lat1, lon1, lat2, lon2;
+    int date, lod = 0, n, count, i;
+
+    store = get_connection_store(conn);
+    grid = atomic_load(&SPATIAL_GRID);
+    if (sscanf((const char *) arg, "%*s %d %lf %lf %lf %lf %d", &date, &lat1, &lon1, &lat2, &lon2, &lod) < 5 ||
+        !store || !grid || grid->numberOfCities != store->numberOfCities || lod < 0 || lod > SPATIAL_GRID_LEVELS) {
+        send_message(conn, NO_DATA_MESSAGE);
+        return NULL;
+    }
+
+    n = store->numberOfCities;
+    if (lod)
+        cells = malloc(n * sizeof(spatialCell));
+    else
+        cities = malloc(n * sizeof(int));
+    text = malloc(strlen(BBOX_CELLS_HEADER) + (size_t) n * BBOX_CELL_MAX_ROW + 1);
+    if ((!cells && !cities) || !text || read_frame(conn, store, date, FRAME_VALUES, FRAME_VALUES + n) == EXIT_FAILURE) {
+        send_message(conn, NO_DATA_MESSAGE);
+        free(cells);
+        free(cities);
+        free(text);
+        return NULL;
+    }
+
+    if (lod) {
+        count = spatialGridCells(grid, lat1, lon1, lat2, lon2, lod, FRAME_VALUES, FRAME_VALUES + n, cells);
+        position = text + sprintf(text, BBOX_CELLS_HEADER);
+        for (i = 0; i < count; i++)
+            position += sprintf(position, "%.6f,%.6f,%d,%lld,%lld\n", cells[i].lat, cells[i].lon, cells[i].cities,
+                                cells[i].population, cells[i].infected);
+    } else {
+        count = spatialGridCities(grid, lat1, lon1, lat2, lon2, cities);
+        position = text + sprintf(text, TOPK_HEADER);
+        for (i = 0; i < count; i++)
+            position += sprintf(position, "%d,%d,%d\n", store->cityIds[cities[i]], FRAME_VALUES[cities[i]],
+                                FRAME_VALUES[n + cities[i]]);
+    }
+
+    send_message(conn, text);
+    free(cells);
+    free(cities);
+    free(text);
+    return NULL;
+}
+
+/**
+ * @brief Sends the durations of the phases of the simulation and of the commands of the server as CSV
+ * (METRICS_HEADER and one row per phase - number of samples, total, mean, p50, p99 and max in milliseconds)
+ *
+ * @param conn   state of the connection
+ * @param arg    unused
+ * @return NULL
+ */
+void *send_metrics(connection *conn, void *arg) {
+    char text[sizeof(METRICS_HEADER) + METRIC_COUNT * METRICS_MAX_ROW];
+
+    metricsFormat(text);
+    send_message(conn, text);
+    return NULL;
+}
+
+/**
+ * @brief Requests a what-if scenario of the running simulation - at the end of the current day, the state
+ * of the simulation is copied and the copy continues in its own thread with the parameters of the simulation
+ * changed by the overrides (names of the parameters as in parameters.c, e.g. MEETING_FACTOR=0.05).
+ * The scenario simulates DAYS=<n> days after the fork (SCENARIO_DEF_DAYS by default) and then stops.
+ * Server responds with SCENARIO_MESSAGE_FORMAT (the id of the scenario, frames of the scenario are requested
+ * after the scenario command) or with "no data" if the simulation is not running yet, an override is invalid
+ * or there are already SCENARIO_MAX scenarios.
+ *
+ * @param conn   state of the connection
+ * @param arg    pointer to the arguments string - "<command_name> <name> [<NAME>=<value> ...] [DAYS=<n>]"
+ * @return NULL
+ */
+void *fork_scenario(connection *conn, void *arg) {
+    char name[SCENARIO_NAME_LENGTH] = {0}, message[FRAME_HEADER_MAX_LEN];
+    char *overrides, *override, *value, *rest = NULL;
+    parameters params = PARAMETERS;
+    int consumed = 0, id, days = SCENARIO_DEF_DAYS;
+
+    /* the parameters of the simulation are loaded before the ring is published */
+    if (!atomic_load(&FRAME_RING) || sscanf((const char *) arg, "%*s %31s%n", name, &consumed) < 1 ||
+        !(overrides = strdup((const char *) arg + consumed))) {
+        send_message(conn, NO_DATA_MESSAGE);
+        return NULL;
+    }
+
+    for (override = strtok_r(overrides, " \t\r\n", &rest); override; override = strtok_r(NULL, " \t\r\n", &rest)) {
+        value = strchr(override, '=');
+        if (value) *value++ = '\0';
+        if (value && !strcmp(override, SCENARIO_DAYS_ARGUMENT)) {
+            days = (int) strtol(value, NULL, 10);
+            continue;
+        }
+        if (!value || parametersSet(&params, parameterIndex(override), strtod(value, NULL)) == EXIT_FAILURE) {
+            free(overrides);
+            send_message(conn, NO_DATA_MESSAGE);
+            return NULL;
         }
-        i++;
     }
-    fclose(csv);
-    /* write the final part and then the end of transmission */
-    write(connfd, bff, strlen(bff));
-    write(connfd, "\x04", 1);
+    free(overrides);
+
+    id = scenarioRequest(name, &params, days);
+    if (id < 0) {
+        send_message(conn, NO_DATA_MESSAGE);
+        return NULL;
+    }
+    printf("Requested scenario %d (%s)\n", id, name);
+    sprintf(message, SCENARIO_MESSAGE_FORMAT, id);
+    send_message(conn, message);
+    return NULL;
+}
+
+/**
+ * @brief Selects the scenario whose frames (and statistics) are sent to the client by the following commands
+ * (send_data, send_range, subscribe, stats, topk, series, send_bbox, export_csv), 0 selects the main simulation.
+ * Days before the fork of the scenario are the days of the main simulation. Server responds with
+ * SCENARIO_MESSAGE_FORMAT or with "no data" if there is no such scenario (the selection is not changed).
+ *
+ * @param conn   state of the connection
+ * @param arg    pointer to the arguments string - "<command_name> <id>"
+ * @return NULL
+ */
+void *select_scenario(connection *conn, void *arg) {
+    char message[FRAME_HEADER_MAX_LEN];
+    int id = -1;
+
+    sscanf((const char *) arg, "%*s %d", &id);
+    if (id != 0 && !scenarioGet(id)) {
+        send_message(conn, NO_DATA_MESSAGE);
+        return NULL;
+    }
+
+    conn->scenario = id;
+    /* the subscriber gets the latest frame of the scenario first */
+    conn->pushed_frame = -1;
+    sprintf(message, SCENARIO_MESSAGE_FORMAT, id);
+    send_message(conn, message);
+    return NULL;
+}
+
+/**
+ * @brief Sends the requested scenarios as CSV (SCENARIOS_HEADER and one row per scenario - id, name, the day
+ * of the main simulation it continues from, its last simulated day and the day it stops at, -1 if it wasn't
+ * forked yet)
+ *
+ * @param conn   state of the connection
+ * @param arg    unused
+ * @return NULL
+ */
+void *send_scenarios(connection *conn, void *arg) {
+    char text[sizeof(SCENARIOS_HEADER) + SCENARIO_MAX * (SCENARIO_NAME_LENGTH + FRAME_HEADER_MAX_LEN)];
+    char *position = text + sprintf(text, SCENARIOS_HEADER);
+    scenario *branch;
+    int id, count = scenarioCount(), fork;
+
+    for (id = 1; id <= count; id++) {
+        branch = scenarioGet(id);
+        fork = atomic_load(&branch->forkDay);
+        position += sprintf(position, "%d,%s,%d,%d,%d,%d\n", id, branch->name, fork,
+                            fork >= 0 ? frameRingLatest(branch->ring) : -1, atomic_load(&branch->failed),
+                            fork >= 0 ? fork + branch->days : -1);
+    }
+    send_message(conn, text);
+    return NULL;
+}
+
+/**
+ * @brief Exports the frame from the frame store into CSV file (CSV_NAME_FORMAT defined in simulation.h)
+ * Server responds with the path of the created file or with "no data" if the frame doesn't exist
+ *
+ * @param conn   state of the connection
+ * @param arg    pointer to the arguments string - "<command_name> <arg1>", <arg1> being the number of frame
+ * @return NULL
+ */
+void *export_csv(connection *conn, void *arg) {
+    frameStore *store;
+    char fname[40] = {0};
 
+    int frame = 0;
+    sscanf((const char *) arg, "%*s %d", &frame);
+    sprintf(fname, CSV_NAME_FORMAT, frame);
 
-    //FILE *dbg = fopen("c_dbg.log","w");
-    //fprintf(dbg,"%s",bff);
-    //fclose(dbg);
+    store = get_connection_store(conn);
+    /* days of a scenario before its fork are in the frame store of the main simulation */
+    if (store && get_scenario(conn) && frame <= atomic_load(&get_scenario(conn)->forkDay)) store = get_frame_store();
+    if (!store || frameStoreExportCsv(store, frame, fname) == EXIT_FAILURE) {
+        send_message(conn, NO_DATA_MESSAGE);
+        return NULL;
+    }
 
-    free(bff);
+    printf("Exported frame %d to %s\n", frame, fname);
+    send_message(conn, fname);
     return NULL;
 }
 
@@ -1,10 +1,17 @@
 /* ------- INCLUDES, GENERAL CONSTANTS  */
+/* accept4 */
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <netdb.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -13,35 +20,54 @@
 #include "D:\_skola\ZSWI\PRJ\fem-like-spreading-modelling\C\server\serv_functions.h"
 */
 #include "serv_functions.h"
+#include "connection.h"
 
 #define DEF_IP NULL
 #define DEF_PORT 4242
 #define MSG_MAX_LEN 2048
 #define CMD_MAX_LEN 14
-#define END_OF_MESSAGE '\x04'
 
 #define CLIENT_EXIT_CMD "I'LL BE BACK"
 
+/* number of events handled by one epoll_wait */
+#define MAX_EVENTS 64
+/* client which doesn't send anything for IDLE_TIMEOUT seconds is disconnected */
+#define IDLE_TIMEOUT 300
+/* how often (seconds) the idle connections are looked for */
+#define IDLE_CHECK_INTERVAL 5
+
+/* list of all the connected clients */
+connection *CONNECTIONS = NULL;
+int CONNECTION_COUNT = 0;
+/* some subscriber has to be closed, it's closed after the batch of the epoll events (it may have an event in it) */
+char CLOSE_PENDING = 0;
+
 /*-------- PROGRAM ARGUMENTS */
 
 #define REQ_ARGNUM 2
-#define ARGNUM 2
+#define ARGNUM 4
 #define MIN_ARGNUM 1 + 2*REQ_ARGNUM
 /* all possible switches on commandline */
-char *available_args[ARGNUM] = {"-port", "-ip4"};
+char *available_args[ARGNUM] = {"-port", "-ip4", "-trace", "-perf"};
 
 /* -------- COMMANDS TO THE PROGRAM */
 
-#define CMDNUM 3
+#define CMDNUM 17
 /* The array of commands */
-char *cmds[CMDNUM] = {"send_data", "start", "out"};
+char *cmds[CMDNUM] = {"send_data", "start", "out", "export_csv", "send_range", "subscribe", "unsubscribe",
+                      "binary", "cities", "stats", "topk", "series", "send_bbox", "metrics",
+                      "fork_scenario", "scenario", "scenarios"};
 
 /* The array of functions invoked by commands
     The functions return void * if they return anything and accept 
-    the connfd and additional args stored as void * 
+    the state of the connection and additional args stored as void * 
     functions are defined in a separate file 
     (serv_function.h in this case) */
-void *(*cmd_fns[CMDNUM])(int, void *) = {&send_data_from_simulation, &start_simulation, &out};
+void *(*cmd_fns[CMDNUM])(connection *, void *) = {&send_data_from_simulation, &start_simulation, &out, &export_csv,
+                                                    &send_range, &subscribe, &unsubscribe,
+                                                    &binary_mode, &send_cities, &send_stats, &send_topk, &send_series,
+                                                    &send_bbox, &send_metrics, &fork_scenario, &select_scenario,
+                                                    &send_scenarios};
 
 /* -------- CODE SECTION */
 
@@ -50,8 +76,8 @@ void *(*cmd_fns[CMDNUM])(int, void *) = {&send_data_from_simulation, &start_simu
  * 
  * @param IP The IP address to listen on. If null, INADDR_ANY is used.
  * @param port The port to listen on
- * @return The sockfd (int) of the listening socket, ready to accept a client
- * The queue of pending connections is of length 5, but only 1 client should request communication at a time
+ * @return The sockfd (int) of the listening socket, ready to accept clients
+ * The socket is non-blocking, clients are accepted by the event loop (any number of clients at a time)
  */
 int create_listen_socket(const char *IP, int port) {
     /* Code by Yogesh Shukla et al. on GeeksforGeeks.org */
@@ -63,7 +89,7 @@ int create_listen_socket(const char *IP, int port) {
 
     /* very WET code 🥵*/
     /* socket create and verification */
-    sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    sockfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (sockfd == -1) {
         printf("Socket creation failed...\n");
         exit(1);
@@ -84,7 +110,7 @@ int create_listen_socket(const char *IP, int port) {
         printf("Socket successfully binded...\n");
 
     /* Now server is ready to listen and verification */
-    if ((listen(sockfd, 5)) != 0) {
+    if ((listen(sockfd, SOMAXCONN)) != 0) {
         printf("Listen failed...\n");
         exit(1);
     } else
@@ -94,94 +120,134 @@ int create_listen_socket(const char *IP, int port) {
 }
 
 /**
- * @brief Establishes connection between the server and incomming client request
- * 
- * @param sockfd The sockfd of a listening socket (the server)
- * @return The sockfd of the connection, through which the server and the client communicate
- * After this function, the server can read() from and write() to the client (using the returned sockfd)
+ * @brief Registers the connection in the epoll for the given events (or changes them)
+ *
+ * @param epfd   the epoll file descriptor
+ * @param conn   state of the connection
+ * @param events EPOLLIN and/or EPOLLOUT
+ * @return 0 on success, -1 on error
  */
-int create_connection(int sockfd) {
-    int connfd, len;
-    struct sockaddr_in cli;
-    len = sizeof(cli);
-
-    /* Accept the data packet from client and verification
-       This will halt the program until an outside client tries to connect */
-    connfd = accept(sockfd, (struct sockaddr *) &cli, &len);
-    if (connfd < 0) {
-        printf("Server failed to accept the client...\n");
-        return -1;
-    } else
-        printf("Server accept the client...\n");
+int watch_connection(int epfd, connection *conn, unsigned int events) {
+    struct epoll_event ev;
+    int op = conn->registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    if (conn->registered && conn->events == events) return 0;
+
+    ev.events = events;
+    ev.data.ptr = conn;
+    if (epoll_ctl(epfd, op, conn->fd, &ev)) return -1;
+    conn->events = events;
+    conn->registered = 1;
+    return 0;
+}
+
+/**
+ * @brief Closes the connection, removes it from the list of connections and frees its state
+ *
+ * @param conn pointer to pointer to the state of the connection
+ */
+void close_connection(connection **conn) {
+    connection *c = *conn;
+
+    /* closing the fd removes it from the epoll */
+    close(c->fd);
+    if (c->prev)
+        c->prev->next = c->next;
+    else
+        CONNECTIONS = c->next;
+    if (c->next) c->next->prev = c->prev;
+    CONNECTION_COUNT--;
 
-    return connfd;
+    free_connection_state(conn);
 }
 
 /**
- * @brief Reads a message from the client byte by byte until the END OF MESSAGE character is found
- * 
- * @param connfd connection file descriptor
- * @param buffer the buffer to save data into
- * @param buffer_len length of the buffer
- * @return same as read() BUT if EOM is not found until the end of the buffer, returns buffer_len+1
+ * @brief Accepts all the pending clients of the listening socket, their sockets are non-blocking
+ *        and registered in the epoll
+ *
+ * @param sockfd The sockfd of a listening socket (the server)
+ * @param epfd   the epoll file descriptor
  */
- 
-int read_socket(int connfd, char *buffer, size_t buffer_len) {
-    int n;
-    for(size_t i = 0; i < buffer_len; i++) {
-        n = read(connfd, buffer + i, 1);
-        if(n <= 0) return n;
-
-        if(buffer[i] == END_OF_MESSAGE) {
-            buffer[i] = '\0';
-            return i+1;
+void accept_clients(int sockfd, int epfd) {
+    int connfd;
+    struct sockaddr_in cli;
+    socklen_t len;
+    connection *conn;
+
+    for (;;) {
+        len = sizeof(cli);
+        connfd = accept4(sockfd, (struct sockaddr *) &cli, &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (connfd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                printf("Server failed to accept the client...\n");
+            return;
+        }
+
+        conn = create_connection_state(connfd);
+        if (!conn) {
+            close(connfd);
+            continue;
+        }
+        conn->next = CONNECTIONS;
+        if (CONNECTIONS) CONNECTIONS->prev = conn;
+        CONNECTIONS = conn;
+        CONNECTION_COUNT++;
+
+        if (watch_connection(epfd, conn, EPOLLIN)) {
+            close_connection(&conn);
+            continue;
         }
+        printf("Server accept the client (%d connected)...\n", CONNECTION_COUNT);
     }
-    return buffer_len+1;
 }
 
 /**
- * @brief The infinite loop for communication with the client
+ * @brief Processes the complete messages in the input of the client
  *        Client sends command and arguments, server does the command
- * 
- * @param connfd the connection's file descriptor
+ *        Client may send more commands at once (pipelining), they are processed in order
+ *        Processing stops while the output of the client is over OUTPUT_HIGH_WATER
+ *        or while the frames of send_range are still being queued
+ *
+ * @param conn state of the connection
  */
-void comm_loop(int connfd) {
+void process_messages(connection *conn) {
     char bf[MSG_MAX_LEN] = {0};
     char cmd[CMD_MAX_LEN] = {0};
-    int n;
-    //printf("Entering comm loop");
-    for (;;) {
-        bzero(bf, MSG_MAX_LEN);
+    size_t n;
+    metricSample sample;
+
+    while (!conn->closing && !conn->failed && !conn->range_active && conn->output_length < OUTPUT_HIGH_WATER) {
         bzero(cmd, CMD_MAX_LEN);
-        n = read_socket(connfd, bf, MSG_MAX_LEN);
+        n = next_message(conn, bf, MSG_MAX_LEN);
 
-        if (!n) {
-            printf("Connection lost\n");
+        if (!n)
             return;
-        }
         if (n == MSG_MAX_LEN+1) {
             printf("Message too long\n");
             continue;
         }
         if (!strncmp(bf, CLIENT_EXIT_CMD, strlen(CLIENT_EXIT_CMD))) {
-            /* close the connection when the client wants to disconnect */
-            close(connfd);
+            /* close the connection when the client wants to disconnect (after the pending output is sent) */
+            conn->closing = 1;
             printf("Client disconnected\n");
             return;
         }
 
-        sscanf(bf, "%s", cmd);
-        /* now: bf contains the recieved line, cmd the first word 
+        sscanf(bf, "%13s", cmd);
+        /* now: bf contains the recieved line, cmd the first word
            (should be a name of a command from cmds array) */
 
         //printf("recieved (whole, command): (%s, %s)\n", bf, cmd);
         size_t i;
         for (i = 0; i < CMDNUM; i++)
-            /* find command and call it with the connection file descriptor and the recieved line as its arguments */
+            /* find command and call it with the connection and the recieved line as its arguments */
             if (!strcmp(cmds[i], cmd)) {
                 printf("Calling command: %s\n", cmd);
-                cmd_fns[i](connfd, (void *) bf);
+                TRACE_BEGIN(cmds[i]);
+                metricsBegin(&sample);
+                cmd_fns[i](conn, (void *) bf);
+                metricsEnd(METRIC_COMMAND, &sample);
+                TRACE_END(cmds[i]);
                 i = -1;
                 break;
             }
@@ -193,6 +259,202 @@ void comm_loop(int connfd) {
     }
 }
 
+/**
+ * @brief Returns the events the connection waits for - writable socket if there is output left,
+ *        readable socket unless the output is over the limit, the range is sent or the client is leaving
+ *
+ * @param conn state of the connection
+ * @return EPOLLIN and/or EPOLLOUT
+ */
+unsigned int connection_events(connection *conn) {
+    return (conn->output_head ? EPOLLOUT : 0) |
+           (conn->closing || conn->range_active || conn->output_length >= OUTPUT_HIGH_WATER ? 0 : EPOLLIN);
+}
+
+/**
+ * @brief Closes the connection if it failed or if the client left and everything was sent,
+ *        otherwise updates the events the connection waits for
+ *
+ * @param epfd   the epoll file descriptor
+ * @param conn   pointer to pointer to the state of the connection
+ */
+void update_connection(int epfd, connection **conn) {
+    connection *c = *conn;
+
+    if (c->failed || (c->closing && !c->output_head)) {
+        close_connection(conn);
+        return;
+    }
+
+    if (watch_connection(epfd, c, connection_events(c)))
+        close_connection(conn);
+}
+
+/**
+ * @brief Pushes the new frame to all the subscribed clients, called when the simulation publishes a day
+ *
+ * @param epfd     the epoll file descriptor
+ * @param notifyfd the eventfd written by the simulation
+ */
+void notify_subscribers(int epfd, int notifyfd) {
+    connection *conn, *next;
+    uint64_t days;
+
+    /* reset the counter, the latest day is read from the ring */
+    if (read(notifyfd, &days, sizeof(days)) < 0)
+        return;
+
+    for (conn = CONNECTIONS; conn; conn = next) {
+        next = conn->next;
+        if (!conn->subscribed)
+            continue;
+        push_latest_frame(conn);
+        /* the subscriber is not closed here, the rest of the batch of the epoll events may refer to it */
+        if (conn->failed || (conn->closing && !conn->output_head))
+            CLOSE_PENDING = 1;
+        else if (watch_connection(epfd, conn, connection_events(conn))) {
+            conn->failed = 1;
+            CLOSE_PENDING = 1;
+        }
+    }
+}
+
+/**
+ * @brief Closes the connections, which failed or were left by the client and everything was sent,
+ *        called after the batch of the epoll events (no event refers to them any more)
+ */
+void close_pending_connections() {
+    connection *conn, *next;
+
+    CLOSE_PENDING = 0;
+    for (conn = CONNECTIONS; conn; conn = next) {
+        next = conn->next;
+        if (conn->failed || (conn->closing && !conn->output_head))
+            close_connection(&conn);
+    }
+}
+
+/**
+ * @brief Handles the events of one client - reads its input, processes the commands and sends the output
+ *        The connection is closed if it was lost, if the client disconnected or if sending failed
+ *
+ * @param epfd   the epoll file descriptor
+ * @param conn   pointer to pointer to the state of the connection
+ * @param events events reported by the epoll
+ */
+void handle_client(int epfd, connection **conn, unsigned int events) {
+    connection *c = *conn;
+    ssize_t n;
+
+    if (events & EPOLLOUT)
+        flush_output(c);
+    /* the client read a part of the output, the next frames of its send_range are queued */
+    if (c->range_active && !c->failed)
+        continue_range(c);
+
+    if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+        n = fill_input(c);
+        /* 0 is returned also when the input buffer is full */
+        if ((n == 0 && c->length < INPUT_BUFFER_SIZE) ||
+            (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            printf("Connection lost\n");
+            close_connection(conn);
+            return;
+        }
+    }
+
+    /* also the messages left in the input when the output was over the limit */
+    process_messages(c);
+
+    /* the output of the subscriber was sent, it gets the frame published meanwhile */
+    if (c->push_pending && !c->output_head)
+        push_latest_frame(c);
+
+    update_connection(epfd, conn);
+}
+
+/**
+ * @brief Closes the connections of the clients, which didn't send anything for IDLE_TIMEOUT seconds
+ *        and are not waiting for any output (subscribers are waiting for the frames)
+ */
+void close_idle_connections() {
+    connection *conn, *next;
+    time_t now = time(NULL);
+
+    for (conn = CONNECTIONS; conn; conn = next) {
+        next = conn->next;
+        if (!conn->subscribed && !conn->output_head && now - conn->last_active >= IDLE_TIMEOUT) {
+            printf("Closing idle connection\n");
+            close_connection(&conn);
+        }
+    }
+}
+
+/**
+ * @brief The infinite event loop of the server - all the clients are served at once, none of them is waited for
+ *        (the simulation runs in its own thread)
+ *
+ * @param sockfd   The sockfd of a listening socket (the server)
+ * @param notifyfd eventfd written by the simulation after every day (-1 if there is none)
+ */
+void event_loop(int sockfd, int notifyfd) {
+    struct epoll_event events[MAX_EVENTS], ev;
+    connection *conn;
+    time_t last_check = time(NULL);
+    int epfd, n, i;
+
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        printf("Epoll creation failed...\n");
+        exit(1);
+    }
+    /* the listening socket is registered with NULL pointer */
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, sockfd, &ev)) {
+        printf("Epoll registration failed...\n");
+        exit(1);
+    }
+    /* the notifications of the simulation are registered with pointer to FRAME_NOTIFY_FD */
+    ev.data.ptr = &FRAME_NOTIFY_FD;
+    if (notifyfd >= 0 && epoll_ctl(epfd, EPOLL_CTL_ADD, notifyfd, &ev)) {
+        printf("Epoll registration failed...\n");
+        exit(1);
+    }
+
+    for (;;) {
+        n = epoll_wait(epfd, events, MAX_EVENTS, IDLE_CHECK_INTERVAL * 1000);
+        if (n < 0 && errno != EINTR) {
+            printf("Epoll wait failed...\n");
+            exit(1);
+        }
+
+        for (i = 0; i < n; i++) {
+            if (!events[i].data.ptr) {
+                accept_clients(sockfd, epfd);
+                continue;
+            }
+            if (events[i].data.ptr == &FRAME_NOTIFY_FD) {
+                TRACE_BEGIN("push");
+                notify_subscribers(epfd, notifyfd);
+                TRACE_END("push");
+                continue;
+            }
+            conn = events[i].data.ptr;
+            /* failed subscriber waits for close_pending_connections */
+            if (!conn->failed)
+                handle_client(epfd, &conn, events[i].events);
+        }
+        if (CLOSE_PENDING) close_pending_connections();
+        if (TRACE_ENABLED) traceFlush();
+
+        if (time(NULL) - last_check >= IDLE_CHECK_INTERVAL) {
+            close_idle_connections();
+            last_check = time(NULL);
+        }
+    }
+}
+
 /**
  * @brief Finds indices for command line switch values in the argv argument. 
  *        Indices are stored in indices in the order corresponding to the ordering in the
@@ -226,7 +488,7 @@ void find_arg_indices(int argc, char const *argv[], int indices[]) {
 }
 
 int main(int argc, char const *argv[]) {
-    int sockfd, connfd;
+    int sockfd;
     int port = -1;
     const char *ip = NULL;
 
@@ -253,19 +515,33 @@ int main(int argc, char const *argv[]) {
     else
         printf("Warning: IP not specified. Using default: INADDR_ANY.\n"), ip = DEF_IP;
 
+    /* optional trace of the simulation and of the commands (Chrome trace-event JSON) */
+    if (args_indices[2] && traceOpen(argv[args_indices[2]]) == EXIT_FAILURE)
+        printf("Warning: trace file %s can't be created, tracing is disabled.\n", argv[args_indices[2]]);
+
+    /* optional hardware counters of the phases (-perf 1), reported by the metrics command */
+    if (args_indices[3] && strtol(argv[args_indices[3]], NULL, 10)) {
+        PERF_COUNTERS_ENABLED = 1;
+        if (!perfCountersOpen())
+            printf("Warning: hardware counters are not available (perf_event_open failed).\n");
+    }
+
     //printf("%s %i", ip, port);
 
     /* STARTING SERVER */
 
     sockfd = create_listen_socket(ip, port);
 
-    /* Indefinitely, accept a connection and then enter a communication loop with the client
-       in the communication, the client gives commands to the server */
-    for (;;) {
-        connfd = create_connection(sockfd);
-        if(connfd > 0)
-            comm_loop(connfd);
-    }
+    /* writing to the client which already left must not kill the server */
+    signal(SIGPIPE, SIG_IGN);
+
+    /* the simulation wakes up the event loop after every day (for the subscribers) */
+    FRAME_NOTIFY_FD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (FRAME_NOTIFY_FD < 0)
+        printf("Warning: eventfd creation failed, frames will not be pushed to the subscribers.\n");
+
+    /* Indefinitely, accept the clients and serve their commands */
+    event_loop(sockfd, FRAME_NOTIFY_FD);
 
 
     return 0;
@@ -121,6 +121,29 @@ void *arrayListRemoveElement(arrayList *list, int index) {
     return pointer;
 }
 
+/**
+ * Removes all the NULL pointers from the list in one pass (order of the other items is kept), many items are
+ * removed at once instead of moving the rest of the list by arrayListRemoveElement for each of them
+ * @param list not null pointer to list
+ * @return number of removed items
+ */
+int arrayListCompact(arrayList *list) {
+    int i;
+    int filled = 0;
+    int removed;
+
+    if (!list) return 0;
+
+    for (i = 0; i < list->filledItems; i++) {
+        if (list->data[i]) list->data[filled++] = list->data[i];
+    }
+
+    removed = list->filledItems - filled;
+    memset(&list->data[filled], 0, removed * sizeof(void *));
+    list->filledItems = filled;
+    return removed;
+}
+
 /**
  * Deallocates memory used by arrayList, memory leaks can occur if elements of
  *  arrayList use some allocating of the memory, then you should use your own
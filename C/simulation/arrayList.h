@@ -17,6 +17,7 @@ int arrayListAdd(arrayList *list, void *pointer);
 int arrayListExpand(arrayList *list);
 void *arrayListGetPointer(arrayList *list, int index);
 void *arrayListRemoveElement(arrayList *list, int index);
+int arrayListCompact(arrayList *list);
 void freeArrayList(arrayList **list);
 
 
@@ -0,0 +1,227 @@
+/**
+ * This module contains functions to work with citySeries struct. CitySeries is a transposed copy
+ * of the frame store - the frames are kept in memory for CITY_SERIES_FLUSH_DAYS days and then
+ * written city by city, so the history of one city is contiguous in the file and can be read
+ * without decoding the frames of all the days. The simulation thread appends the days,
+ * readers (with their own read only view) see only the days already written.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "citySeries.h"
+
+/* offset of the number of written days in the header */
+#define DAYS_OFFSET (4 + 2 * sizeof(int))
+
+/**
+ * Returns position of the day of the city in the file
+ * @param series series
+ * @param city index of the city
+ * @param date number of the day
+ * @return offset from the start of the file
+ */
+static off_t dayPosition(citySeries *series, int city, int date) {
+    off_t segment = date / CITY_SERIES_SEGMENT_DAYS;
+    off_t day = (off_t) city * CITY_SERIES_SEGMENT_DAYS + date % CITY_SERIES_SEGMENT_DAYS;
+    return CITY_SERIES_HEADER_SIZE + (segment * series->numberOfCities * CITY_SERIES_SEGMENT_DAYS + day) * 2 * sizeof(int);
+}
+
+/**
+ * Allocates the series struct and the buffer for the days which are not written yet
+ * @param numberOfCities number of cities
+ * @param writable 1 if days will be appended
+ * @return pointer to the series or NULL if it is not possible to allocate memory
+ */
+static citySeries *allocateCitySeries(int numberOfCities, char writable) {
+    citySeries *series = calloc(1, sizeof(citySeries));
+    if (!series) return NULL;
+
+    series->numberOfCities = numberOfCities;
+    series->writable = writable;
+    if (writable) {
+        series->buffer = malloc((size_t) numberOfCities * CITY_SERIES_FLUSH_DAYS * 2 * sizeof(int));
+        if (!series->buffer) {
+            free(series);
+            return NULL;
+        }
+    }
+    return series;
+}
+
+/**
+ * Creates new (empty) series, existing file on the path is truncated
+ * @param filepath path to the file
+ * @param numberOfCities must be greater than zero
+ * @return pointer to citySeries struct or NULL if parameters are invalid, file can't be
+ *         created or it is not possible to allocate memory
+ */
+citySeries *createCitySeries(const char *filepath, int numberOfCities) {
+    citySeries *series;
+    int header[3] = {CITY_SERIES_VERSION, numberOfCities, 0};
+
+    if (!filepath || numberOfCities <= 0) return NULL;
+
+    series = allocateCitySeries(numberOfCities, 1);
+    if (!series) return NULL;
+
+    series->file = fopen(filepath, "w+b");
+    if (!series->file ||
+        pwrite(fileno(series->file), CITY_SERIES_MAGIC, 4, 0) != 4 ||
+        pwrite(fileno(series->file), header, sizeof(header), 4) != sizeof(header)) {
+        freeCitySeries(&series);
+        return NULL;
+    }
+    return series;
+}
+
+/**
+ * Opens already existing series
+ * @param filepath path to the file
+ * @param writable 1 if days will be appended (after the written days), 0 for read only access
+ * @return pointer to citySeries struct or NULL if the file doesn't exist, is corrupted or it
+ *         is not possible to allocate memory
+ */
+citySeries *openCitySeries(const char *filepath, char writable) {
+    citySeries *series;
+    FILE *file;
+    char magic[4];
+    int header[3];
+
+    if (!filepath) return NULL;
+
+    file = fopen(filepath, writable ? "r+b" : "rb");
+    if (!file) return NULL;
+
+    if (pread(fileno(file), magic, 4, 0) != 4 || memcmp(magic, CITY_SERIES_MAGIC, 4) != 0 ||
+        pread(fileno(file), header, sizeof(header), 4) != sizeof(header) ||
+        header[0] != CITY_SERIES_VERSION || header[1] <= 0 || header[2] < 0) {
+        fclose(file);
+        return NULL;
+    }
+
+    series = allocateCitySeries(header[1], writable);
+    if (!series) {
+        fclose(file);
+        return NULL;
+    }
+    series->file = file;
+    series->days = header[2];
+    return series;
+}
+
+/**
+ * Returns number of the days written into the file (read from the header, so the days written
+ * by another view of the same file are seen)
+ * @param series series
+ * @return number of the days (days 0 .. number - 1 can be read) or -1 if series is invalid
+ */
+int citySeriesDays(citySeries *series) {
+    int days;
+    if (!series) return -1;
+    if (series->writable) return series->days;
+
+    if (pread(fileno(series->file), &days, sizeof(int), DAYS_OFFSET) != sizeof(int)) return -1;
+    series->days = days;
+    return days;
+}
+
+/**
+ * Writes the buffered days into the file (one write per city) and publishes them in the header
+ * @param series writable series with CITY_SERIES_FLUSH_DAYS days in the buffer
+ * @return EXIT_SUCCESS or EXIT_FAILURE if it is not possible to write into the file
+ */
+static int flushDays(citySeries *series) {
+    size_t length = CITY_SERIES_FLUSH_DAYS * 2 * sizeof(int);
+    int i, days;
+
+    for (i = 0; i < series->numberOfCities; i++)
+        if (pwrite(fileno(series->file), series->buffer + (size_t) i * CITY_SERIES_FLUSH_DAYS * 2, length,
+                   dayPosition(series, i, series->days)) != length)
+            return EXIT_FAILURE;
+
+    /* readers see the days only after all the cities are written */
+    days = series->days + CITY_SERIES_FLUSH_DAYS;
+    if (pwrite(fileno(series->file), &days, sizeof(int), DAYS_OFFSET) != sizeof(int)) return EXIT_FAILURE;
+    series->days = days;
+    series->bufferedDays = 0;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Appends the frame of the day, every CITY_SERIES_FLUSH_DAYS days the buffered days are written
+ * Days skipped since the last appended day are appended as CITY_SERIES_MISSING
+ * @param series writable series
+ * @param date number of the day, must be after the last appended day
+ * @param population population of all the cities
+ * @param infected infected of all the cities
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the day was already appended or it is not possible
+ *         to write into the file
+ */
+int citySeriesAdd(citySeries *series, int date, const int *population, const int *infected) {
+    int *day;
+    int i;
+
+    if (!series || !series->writable || !population || !infected) return EXIT_FAILURE;
+    if (date < series->days + series->bufferedDays) return EXIT_FAILURE;
+
+    while (series->days + series->bufferedDays <= date) {
+        for (i = 0; i < series->numberOfCities; i++) {
+            day = series->buffer + ((size_t) i * CITY_SERIES_FLUSH_DAYS + series->bufferedDays) * 2;
+            if (series->days + series->bufferedDays == date) {
+                day[0] = population[i];
+                day[1] = infected[i];
+            } else
+                day[0] = day[1] = CITY_SERIES_MISSING;
+        }
+        if (++series->bufferedDays == CITY_SERIES_FLUSH_DAYS && flushDays(series) == EXIT_FAILURE) {
+            series->bufferedDays--;
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Reads the history of the city, only the days written into the file can be read
+ * (one read for every CITY_SERIES_SEGMENT_DAYS days)
+ * @param series series
+ * @param city index of the city
+ * @param from first day
+ * @param to last day, must be written already (less than citySeriesDays)
+ * @param values output array, population and infected of every day (2 * (to - from + 1) ints)
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the arguments are invalid or the days are not written
+ */
+int citySeriesRead(citySeries *series, int city, int from, int to, int *values) {
+    size_t length;
+    int days;
+
+    if (!series || !values || city < 0 || city >= series->numberOfCities || from < 0 || to < from)
+        return EXIT_FAILURE;
+    if (to >= series->days && to >= citySeriesDays(series)) return EXIT_FAILURE;
+
+    while (from <= to) {
+        days = CITY_SERIES_SEGMENT_DAYS - from % CITY_SERIES_SEGMENT_DAYS;
+        if (days > to - from + 1) days = to - from + 1;
+
+        length = (size_t) days * 2 * sizeof(int);
+        if (pread(fileno(series->file), values, length, dayPosition(series, city, from)) != length)
+            return EXIT_FAILURE;
+        values += 2 * days;
+        from += days;
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Frees the series, buffered days which are not written yet are lost (they are in the frame store)
+ * @param series pointer to pointer to the series
+ */
+void freeCitySeries(citySeries **series) {
+    if (!series || !*series) return;
+
+    if ((*series)->file) fclose((*series)->file);
+    free((*series)->buffer);
+    free(*series);
+    *series = NULL;
+}
@@ -0,0 +1,43 @@
+#ifndef FEM_LIKE_SPREADING_MODELLING_CITYSERIES_H
+#define FEM_LIKE_SPREADING_MODELLING_CITYSERIES_H
+
+#include <stdio.h>
+
+#define CITY_SERIES_FILEPATH "./DATA/sim_frames/series.dat"
+#define CITY_SERIES_MAGIC "CSER"
+#define CITY_SERIES_VERSION 1
+/* magic, version, number of cities, number of written days */
+#define CITY_SERIES_HEADER_SIZE (4 + 3 * sizeof(int))
+/* days of one city are contiguous in the file within a segment, so history of up to
+   CITY_SERIES_SEGMENT_DAYS days is read by one read */
+#define CITY_SERIES_SEGMENT_DAYS 1024
+/* days are transposed in memory and written every CITY_SERIES_FLUSH_DAYS days (the days which
+   are not written yet are still in the frame ring), must divide CITY_SERIES_SEGMENT_DAYS */
+#define CITY_SERIES_FLUSH_DAYS 32
+/* value of the day which is not in the frame store */
+#define CITY_SERIES_MISSING -1
+
+/**
+ * City-major copy of the frames of the simulation
+ * File contains header followed by segments of CITY_SERIES_SEGMENT_DAYS days, every segment
+ * contains days of the first city, then days of the second city, ... (population and infected for every day)
+ */
+typedef struct {
+    FILE *file;
+    int numberOfCities;
+    char writable;
+    /* days written into the file */
+    int days;
+    /* transposed days which are not written yet (numberOfCities x CITY_SERIES_FLUSH_DAYS x 2 ints) */
+    int *buffer;
+    int bufferedDays;
+} citySeries;
+
+citySeries *createCitySeries(const char *filepath, int numberOfCities);
+citySeries *openCitySeries(const char *filepath, char writable);
+int citySeriesDays(citySeries *series);
+int citySeriesAdd(citySeries *series, int date, const int *population, const int *infected);
+int citySeriesRead(citySeries *series, int city, int from, int to, int *values);
+void freeCitySeries(citySeries **series);
+
+#endif //FEM_LIKE_SPREADING_MODELLING_CITYSERIES_H
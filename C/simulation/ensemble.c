@@ -0,0 +1,264 @@
+/**
+ * This module contains functions to run many replicates (different random seeds) of the simulation of one
+ * country. The cities are loaded once, every replicate gets its own citizens, GaussRandoms and random generator
+ * (randomUseState), so the results do not depend on the number of the threads or on the order in which
+ * the threads take the replicates. Every thread keeps only the replicate it simulates in memory, the infected
+ * of every day are streamed into a temporary file and summarized into quantile bands (p5, p50, p95) over
+ * the replicates after the run.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ensemble.h"
+#include "fileManager.h"
+
+static const double BAND_QUANTILES[ENSEMBLE_BANDS] = {0.05, 0.5, 0.95};
+
+/**
+ * Returns the position of the infected of the day of the replicate in the history
+ * @param theEnsemble ensemble
+ * @param replicate index of the replicate
+ * @param day simulated day
+ * @return offset in bytes
+ */
+static off_t historyOffset(ensemble *theEnsemble, int replicate, int day) {
+    return ((off_t) replicate * theEnsemble->days + day) * theEnsemble->numberOfCities * sizeof(int);
+}
+
+/**
+ * Simulates all the days of the replicate on the calling thread, its citizens are created from the geography
+ * and freed after the last day
+ * @param theEnsemble ensemble
+ * @param replicate index of the replicate
+ * @param population buffer for the population of every city
+ * @param infected buffer for the infected of every city
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+static int simulateReplicate(ensemble *theEnsemble, int replicate, int *population, int *infected) {
+    size_t n = theEnsemble->numberOfCities;
+    country *theCountry;
+    GaussRandom *moveRandom, *spreadRandom;
+    unsigned long long state;
+    int day, result = EXIT_SUCCESS;
+
+    theCountry = copyCountry(theEnsemble->geography);
+    moveRandom = createRandom(theEnsemble->geography->params.moveMean, theEnsemble->geography->params.moveStdDev);
+    spreadRandom = createRandom(theEnsemble->geography->params.spreadMean,
+                                theEnsemble->geography->params.spreadStdDev);
+    if (!theCountry || !moveRandom || !spreadRandom) result = EXIT_FAILURE;
+
+    randomSeed(&state, theEnsemble->seed + replicate);
+    randomUseState(&state);
+    for (day = 0; result == EXIT_SUCCESS && day < theEnsemble->days; day++) {
+        simulateDay(theCountry, moveRandom, spreadRandom);
+        snapshotCountry(theCountry, population, infected);
+        if (pwrite(fileno(theEnsemble->history), infected, n * sizeof(int),
+                   historyOffset(theEnsemble, replicate, day)) != (ssize_t) (n * sizeof(int)))
+            result = EXIT_FAILURE;
+    }
+    randomUseState(NULL);
+
+    if (result == EXIT_SUCCESS) {
+        memcpy(theEnsemble->population + replicate * n, population, n * sizeof(int));
+        memcpy(theEnsemble->infected + replicate * n, infected, n * sizeof(int));
+    }
+    freeCountry(&theCountry);
+    freeRandom(&moveRandom);
+    freeRandom(&spreadRandom);
+    return result;
+}
+
+/**
+ * Loop of one thread of the pool - simulates the replicates it takes until there are none left
+ * @param args ensemble
+ * @return NULL
+ */
+static void *ensembleWorker(void *args) {
+    ensemble *theEnsemble = args;
+    int *population, *infected, replicate;
+
+    population = malloc(theEnsemble->numberOfCities * sizeof(int));
+    infected = malloc(theEnsemble->numberOfCities * sizeof(int));
+    if (!population || !infected) atomic_store(&theEnsemble->failed, 1);
+    else
+        while ((replicate = atomic_fetch_add(&theEnsemble->next, 1)) < theEnsemble->replicates) {
+            if (simulateReplicate(theEnsemble, replicate, population, infected) == EXIT_FAILURE)
+                atomic_store(&theEnsemble->failed, 1);
+            if (TRACE_ENABLED) traceFlush();
+        }
+
+    free(population);
+    free(infected);
+    return NULL;
+}
+
+/**
+ * Creates the ensemble, the replicates are created and simulated by ensembleRun
+ * @param geography loaded cities, the ensemble does not take the ownership (must outlive the ensemble)
+ * @param replicates number of the replicates, must be greater than zero
+ * @param threads number of the threads of the pool (and of the replicates in memory at once), must be greater
+ *                than zero (fewer are used if there are fewer replicates or the system does not allow to start
+ *                all of them)
+ * @param seed seed of the generator of the first replicate (replicate r has seed + r)
+ * @return pointer to ensemble struct or NULL
+ */
+ensemble *createEnsemble(country *geography, int replicates, int threads, unsigned long long seed) {
+    ensemble *theEnsemble;
+
+    if (!geography || replicates <= 0 || threads <= 0) return NULL;
+
+    theEnsemble = calloc(1, sizeof(ensemble));
+    if (!theEnsemble) return NULL;
+
+    theEnsemble->geography = geography;
+    theEnsemble->replicates = replicates;
+    theEnsemble->numberOfCities = geography->numberOfCities;
+    theEnsemble->seed = seed;
+    theEnsemble->threads = threads < replicates ? threads : replicates;
+    theEnsemble->population = malloc((size_t) replicates * geography->numberOfCities * sizeof(int));
+    theEnsemble->infected = malloc((size_t) replicates * geography->numberOfCities * sizeof(int));
+    theEnsemble->history = tmpfile();
+    if (!theEnsemble->population || !theEnsemble->infected || !theEnsemble->history) {
+        freeEnsemble(&theEnsemble);
+        return NULL;
+    }
+
+    return theEnsemble;
+}
+
+/**
+ * Simulates the days of all the replicates (blocks until all of them are done)
+ * @param theEnsemble ensemble which did not run yet
+ * @param days number of the days, must be greater than zero
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the ensemble can't run or some replicate failed
+ */
+int ensembleRun(ensemble *theEnsemble, int days) {
+    pthread_t *workers;
+    int i, started = 0;
+
+    if (!theEnsemble || days <= 0 || theEnsemble->days) return EXIT_FAILURE;
+    theEnsemble->days = days;
+    atomic_store(&theEnsemble->next, 0);
+    atomic_store(&theEnsemble->failed, 0);
+
+    workers = malloc(theEnsemble->threads * sizeof(pthread_t));
+    for (i = 0; workers && i < theEnsemble->threads; i++) {
+        if (pthread_create(&workers[i], NULL, ensembleWorker, theEnsemble)) break;
+        started++;
+    }
+    /* without any thread, the replicates are simulated by the caller */
+    if (!started) ensembleWorker(theEnsemble);
+    for (i = 0; i < started; i++) pthread_join(workers[i], NULL);
+    if (started) theEnsemble->threads = started;
+
+    free(workers);
+    return atomic_load(&theEnsemble->failed) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ * Compares two ints (qsort)
+ */
+static int compareInts(const void *a, const void *b) {
+    int first = *(const int *) a, second = *(const int *) b;
+    return (first > second) - (first < second);
+}
+
+/**
+ * Returns the quantile of the values (nearest rank), sorts the values
+ * @param values values, must not be empty
+ * @param count number of the values
+ * @param quantile from interval <0, 1>
+ * @return value of the quantile
+ */
+int ensembleQuantile(int *values, int count, double quantile) {
+    int rank;
+
+    qsort(values, count, sizeof(int), compareInts);
+    rank = (int) (quantile * count + 0.999999999) - 1;
+    if (rank < 0) rank = 0;
+    if (rank >= count) rank = count - 1;
+    return values[rank];
+}
+
+/**
+ * Computes the bands of the infected of every city over the replicates for the simulated day
+ * @param theEnsemble ensemble which already ran
+ * @param day simulated day (from 0 to days - 1)
+ * @param bands output array, ENSEMBLE_BANDS values (p5, p50, p95) for every city
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int ensembleBands(ensemble *theEnsemble, int day, int *bands) {
+    int *day_infected, *values, city, replicate, band, n;
+
+    if (!theEnsemble || !bands || day < 0 || day >= theEnsemble->days) return EXIT_FAILURE;
+
+    n = theEnsemble->numberOfCities;
+    day_infected = malloc((size_t) theEnsemble->replicates * n * sizeof(int));
+    values = malloc(theEnsemble->replicates * sizeof(int));
+    if (!day_infected || !values) {
+        free(day_infected);
+        free(values);
+        return EXIT_FAILURE;
+    }
+    for (replicate = 0; replicate < theEnsemble->replicates; replicate++)
+        if (pread(fileno(theEnsemble->history), day_infected + (size_t) replicate * n, n * sizeof(int),
+                  historyOffset(theEnsemble, replicate, day)) != (ssize_t) (n * sizeof(int))) {
+            free(day_infected);
+            free(values);
+            return EXIT_FAILURE;
+        }
+
+    for (city = 0; city < n; city++) {
+        for (replicate = 0; replicate < theEnsemble->replicates; replicate++)
+            values[replicate] = day_infected[(size_t) replicate * n + city];
+        for (band = 0; band < ENSEMBLE_BANDS; band++)
+            bands[city * ENSEMBLE_BANDS + band] = ensembleQuantile(values, theEnsemble->replicates,
+                                                                   BAND_QUANTILES[band]);
+    }
+
+    free(day_infected);
+    free(values);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Appends the bands of the simulated day as csv rows (ENSEMBLE_BANDS_HEADER without the header)
+ * @param theEnsemble ensemble which already ran
+ * @param day simulated day (from 0 to days - 1)
+ * @param file output file
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int ensembleWriteBands(ensemble *theEnsemble, int day, FILE *file) {
+    int *bands, city;
+
+    if (!theEnsemble || !file) return EXIT_FAILURE;
+
+    bands = malloc(theEnsemble->numberOfCities * ENSEMBLE_BANDS * sizeof(int));
+    if (!bands || ensembleBands(theEnsemble, day, bands) == EXIT_FAILURE) {
+        free(bands);
+        return EXIT_FAILURE;
+    }
+
+    for (city = 0; city < theEnsemble->numberOfCities; city++)
+        fprintf(file, "%d,%d,%d,%d,%d\n", theEnsemble->geography->cities[city]->city_id,
+                bands[city * ENSEMBLE_BANDS], bands[city * ENSEMBLE_BANDS + 1], bands[city * ENSEMBLE_BANDS + 2],
+                day);
+
+    free(bands);
+    return ferror(file) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ * Deallocates the ensemble and removes its history (the geography is not freed)
+ * @param theEnsemble pointer to pointer to ensemble
+ */
+void freeEnsemble(ensemble **theEnsemble) {
+    if (!theEnsemble || !*theEnsemble) return;
+
+    if ((*theEnsemble)->history) fclose((*theEnsemble)->history);
+    free((*theEnsemble)->population);
+    free((*theEnsemble)->infected);
+    free(*theEnsemble);
+    *theEnsemble = NULL;
+}
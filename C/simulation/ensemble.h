@@ -0,0 +1,46 @@
+#ifndef FEM_LIKE_SPREADING_MODELLING_ENSEMBLE_H
+#define FEM_LIKE_SPREADING_MODELLING_ENSEMBLE_H
+
+#include <stdio.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "simulation.h"
+
+/* quantiles of the infected of every city over the replicates */
+#define ENSEMBLE_BANDS 3
+#define ENSEMBLE_BANDS_HEADER "kod_obce,p5_nakazenych,p50_nakazenych,p95_nakazenych,datum\n"
+
+/**
+ * Replicates of the simulation of one country, every replicate has its own citizens and its own
+ * random generator, the cities are loaded only once (geography is read only)
+ * Replicates are taken by a pool of threads, every thread simulates all the days of one replicate before it
+ * takes the next one, so only threads replicates (their citizens) are in memory at once. The infected of every
+ * day of every replicate are streamed into the history (temporary file), the bands of the days are read from it
+ */
+typedef struct {
+    country *geography;
+    int replicates;
+    int numberOfCities;
+    unsigned long long seed;
+    /* number of the simulated days, 0 before the run */
+    int days;
+    /* population and infected of the last simulated day, replicates x cities */
+    int *population;
+    int *infected;
+    /* infected of every day of every replicate, replicate-major (days x cities per replicate) */
+    FILE *history;
+
+    /* number of the threads of the pool (replicates in memory at once), they take the replicates from next */
+    int threads;
+    atomic_int next;
+    atomic_int failed;
+} ensemble;
+
+ensemble *createEnsemble(country *geography, int replicates, int threads, unsigned long long seed);
+int ensembleRun(ensemble *theEnsemble, int days);
+int ensembleQuantile(int *values, int count, double quantile);
+int ensembleBands(ensemble *theEnsemble, int day, int *bands);
+int ensembleWriteBands(ensemble *theEnsemble, int day, FILE *file);
+void freeEnsemble(ensemble **theEnsemble);
+
+#endif //FEM_LIKE_SPREADING_MODELLING_ENSEMBLE_H
@@ -22,10 +22,9 @@ int number_of_cities_from_csv(const char *filepath) {
     // Skipping first line
     fgets(buffer, 255, fp);
 
-    // Reading the rest and counting the total population
-    while (!feof(fp)) {
-        fgets(buffer, 255, fp);
-        cities++;
+    // Reading the rest and counting the non-empty lines (last line may or may not end with a new line)
+    while (fgets(buffer, 255, fp)) {
+        if (*buffer != '\n' && *buffer != '\r') cities++;
     }
 
     // Closing csv file
@@ -47,7 +46,8 @@ int process_csv(country **the_country, const char *filepath, int create_citizens
     double lon, lat, area;
     int i = 0, citizen_index = 0, population_index = -1, lat_index = -1, lon_index = -1, city_id_index = -1,
             infected_index = -1, area_index = -1, population, city_id, infected;
-    short city_index = 0;
+    /* generated countries have up to millions of cities */
+    int city_index = 0;
     char buffer[255];
     char *token;
     city *theCity;
@@ -72,12 +72,17 @@ int process_csv(country **the_country, const char *filepath, int create_citizens
         i++;
     }
     if (population_index == -1 || lat_index == -1 || lon_index == -1 || city_id_index == -1 ||
-        area_index == -1 || infected_index == -1)
+        area_index == -1 || infected_index == -1) {
+        fclose(fp);
         return 0;
+    }
 
     // Reading the rest and creating structs
-    while (!feof(fp)) {
-        fgets(buffer, 255, fp);
+    while (city_index < (*the_country)->numberOfCities && fgets(buffer, 255, fp)) {
+        if (*buffer == '\n' || *buffer == '\r') continue;
+        // row with a missing population is rejected by createCity
+        population = infected = city_id = 0;
+        lat = lon = area = 0;
         token = strtok(buffer, ",");
         i = 0;
         while (1) {
@@ -93,6 +98,10 @@ int process_csv(country **the_country, const char *filepath, int create_citizens
         }
         (*the_country)->cities[city_index] = createCity(city_id, area, population, infected, lat, lon);
         theCity = (*the_country)->cities[city_index];
+        if (!theCity) {
+            fclose(fp);
+            return 0;
+        }
 
         if (!create_citizens) {
             city_index++;
@@ -143,7 +152,8 @@ country *create_country_from_csv(const char *filepath, int create_citizens) {
     if (number_of_cities < 0) return NULL;
 
     country *temp = createCountry(number_of_cities);
-    process_csv(&temp, filepath, create_citizens);
+    if (!temp) return NULL;
+    if (!process_csv(&temp, filepath, create_citizens)) freeCountry(&temp);
 
     return temp;
 }
@@ -183,19 +193,199 @@ int create_csv_from_country(country *the_country, const char *filepath, int date
     return 1;
 }
 
+/**
+ * Opens the frame store for the frames of the country, city ids are taken from the country
+ * @param the_country Input country struct
+ * @param data_path path to the data file of the store (FRAME_STORE_FILEPATH for the server)
+ * @param index_path path to the index file of the store (FRAME_INDEX_FILEPATH for the server)
+ * @param resume 1 if the simulation continues from saved state (frames are appended to the existing
+ *               store if it matches the country), 0 if the store should be created from scratch
+ * @return Pointer to frameStore struct opened for writing or NULL
+ */
+frameStore *create_frame_store_from_country(country *the_country, const char *data_path, const char *index_path,
+                                            int resume) {
+    frameStore *store = NULL;
+    int *city_ids;
+    int i;
+
+    // Sanity check
+    if (!the_country) return NULL;
+
+    if (resume) {
+        store = openFrameStore(data_path, index_path, 1);
+        if (store && store->numberOfCities == the_country->numberOfCities) return store;
+        freeFrameStore(&store);
+    }
+
+    city_ids = malloc(the_country->numberOfCities * sizeof(int));
+    if (!city_ids) return NULL;
+
+    for (i = 0; i < the_country->numberOfCities; i++) {
+        city_ids[i] = the_country->cities[i]->city_id;
+    }
+    store = createFrameStore(data_path, index_path, city_ids, the_country->numberOfCities);
+
+    free(city_ids);
+    return store;
+}
+
+/**
+ * Opens the city series for the frames of the country (cities are in the order of the frame store)
+ * @param the_country Input country struct
+ * @param resume 1 if the simulation continues from saved state (days are appended to the existing
+ *               series if it matches the country), 0 if the series should be created from scratch
+ * @return Pointer to citySeries struct opened for writing or NULL
+ */
+citySeries *create_city_series_from_country(country *the_country, int resume) {
+    citySeries *series = NULL;
+
+    // Sanity check
+    if (!the_country) return NULL;
+
+    if (resume) {
+        series = openCitySeries(CITY_SERIES_FILEPATH, 1);
+        if (series && series->numberOfCities == the_country->numberOfCities) return series;
+        freeCitySeries(&series);
+    }
+
+    return createCitySeries(CITY_SERIES_FILEPATH, the_country->numberOfCities);
+}
+
+/**
+ * Creates the grid over the coordinates of the cities of the country (cities are in the order of the frame store)
+ * @param the_country Input country struct
+ * @return Pointer to spatialGrid struct or NULL
+ */
+spatialGrid *create_spatial_grid_from_country(country *the_country) {
+    spatialGrid *grid;
+    double *lat, *lon;
+    int i;
+
+    // Sanity check
+    if (!the_country) return NULL;
+
+    lat = malloc(the_country->numberOfCities * sizeof(double));
+    lon = malloc(the_country->numberOfCities * sizeof(double));
+    if (!lat || !lon) {
+        free(lat);
+        free(lon);
+        return NULL;
+    }
+
+    for (i = 0; i < the_country->numberOfCities; i++) {
+        lat[i] = the_country->cities[i]->lat;
+        lon[i] = the_country->cities[i]->lon;
+    }
+    grid = createSpatialGrid(the_country->numberOfCities, lat, lon);
+
+    free(lat);
+    free(lon);
+    return grid;
+}
+
+/**
+ * Compares two pairs (city id, city index) by the city id
+ * @param a first pair
+ * @param b second pair
+ * @return negative, zero or positive number as strcmp
+ */
+int compare_city_ids(const void *a, const void *b) {
+    int first = *(const int *) a, second = *(const int *) b;
+    return (first > second) - (first < second);
+}
+
+/**
+ * Creates the statistics for the country, districts of the cities (kod_okres) are read
+ * from DISTRICTS_FILEPATH (kod_okres,kod_obec,...), statistics are created without districts if the file doesn't exist
+ * @param the_country Country struct
+ * @return Pointer to empty statistics struct or NULL
+ */
+statistics *create_statistics_from_country(country *the_country) {
+    FILE *fp = NULL;
+    statistics *stats = NULL;
+    char buffer[255];
+    char *code, *id, (*codes)[DISTRICT_CODE_LENGTH] = NULL, (*bigger)[DISTRICT_CODE_LENGTH];
+    int *city_district, *ids, *found, key[2];
+    int i, n, district = -1, districts = 0, capacity = 0;
+
+    // Sanity check
+    if (!the_country) return NULL;
+    n = the_country->numberOfCities;
+
+    city_district = malloc(n * sizeof(int));
+    // pairs (city id, city index) sorted by the id
+    ids = malloc(2 * n * sizeof(int));
+    if (!city_district || !ids) {
+        free(city_district);
+        free(ids);
+        return NULL;
+    }
+    for (i = 0; i < n; i++) {
+        city_district[i] = -1;
+        ids[2 * i] = the_country->cities[i] ? the_country->cities[i]->city_id : -1;
+        ids[2 * i + 1] = i;
+    }
+    qsort(ids, n, 2 * sizeof(int), compare_city_ids);
+
+    fp = fopen(DISTRICTS_FILEPATH, "r");
+    if (fp) {
+        // Skipping first line
+        fgets(buffer, 255, fp);
+
+        while (fgets(buffer, 255, fp)) {
+            code = strtok(buffer, ",");
+            id = strtok(NULL, ",");
+            if (!code || !id) continue;
+
+            key[0] = (int) strtol(id, NULL, 10);
+            found = bsearch(key, ids, n, 2 * sizeof(int), compare_city_ids);
+            if (!found) continue;
+
+            // rows are grouped by the districts, so the last district is checked first
+            if (district < 0 || strncmp(codes[district], code, DISTRICT_CODE_LENGTH - 1) != 0) {
+                for (district = 0; district < districts; district++)
+                    if (!strncmp(codes[district], code, DISTRICT_CODE_LENGTH - 1)) break;
+
+                if (district == districts) {
+                    if (districts == capacity) {
+                        capacity = capacity ? 2 * capacity : 64;
+                        bigger = realloc(codes, capacity * DISTRICT_CODE_LENGTH);
+                        if (!bigger) break;
+                        codes = bigger;
+                    }
+                    strncpy(codes[districts], code, DISTRICT_CODE_LENGTH - 1);
+                    codes[districts][DISTRICT_CODE_LENGTH - 1] = '\0';
+                    districts++;
+                }
+            }
+            city_district[found[1]] = district;
+        }
+        fclose(fp);
+    }
+
+    stats = createStatistics(n, city_district, (const char (*)[DISTRICT_CODE_LENGTH]) codes, districts);
+
+    free(codes);
+    free(ids);
+    free(city_district);
+    return stats;
+}
+
 /**
  * Saves the state of the country into binary file
  * @param date current frame number
+ * @param filepath path to the save file (SAVE_FILEPATH for the server)
  * @return 1 if save was successful, 0 otherwise
  */
-int save_state(country *the_country, int date) {
+int save_state(country *the_country, int date, const char *filepath) {
     int i, j, k;
+    char status = NORMAL, time_frame = 0;
     city *the_city;
     arrayList *the_list;
     citizen *the_citizen;
     FILE *fp = NULL;
 
-    fp = fopen(SAVE_FILEPATH, "wb");
+    fp = fopen(filepath, "wb");
     if (!fp) return 0;
 
     fwrite(&(date), sizeof(date), 1, fp);
@@ -214,6 +404,14 @@ int save_state(country *the_country, int date) {
                 fwrite(&(the_city->city_id), sizeof(int), 1, fp);
             }
         }
+
+        // residents kept only as counts are healthy and at home
+        for (j = 0; j < the_city->dormantCount; j++) {
+            fwrite(&i, sizeof(int), 1, fp);
+            fwrite(&status, sizeof(char), 1, fp);
+            fwrite(&time_frame, sizeof(char), 1, fp);
+            fwrite(&(the_city->city_id), sizeof(int), 1, fp);
+        }
     }
 
     if (fclose(fp) == EOF) return 0;
@@ -239,6 +437,9 @@ int load_state(country **the_country) {
         the_city = (*the_country)->cities[i];
         the_city->population = 0;
         the_city->infected = 0;
+        the_city->recovered = 0;
+        // days without infected are not saved, residents are kept as counts again after dormantDays days
+        the_city->quietDays = 0;
     }
 
     fp = fopen(SAVE_FILEPATH, "rb");
@@ -263,6 +464,7 @@ int load_state(country **the_country) {
                     hashTableAddElement(the_citizen, the_citizen->id, the_city->citizens);
                     the_city->population++;
                     if (the_citizen->status == INFECTED) the_city->infected++;
+                    if (the_citizen->status == RECOVERED) the_city->recovered++;
                     break;
                 }
             }
@@ -276,16 +478,18 @@ int load_state(country **the_country) {
 }
 
 /**
- * Loads all needed parameters for the simulation
+ * Loads all needed parameters for the simulation into PARAMETERS (copied into every new country)
  * @param filepath path to configuration file containing all the parameters
- * @return EXIT_SUCCESS or EXIT_FAILURE in case of corrupted configuration file
+ * Optional parameters (after PARAMETER_REQUIRED_COUNT, missing in the older files) keep their default values
+ * @return EXIT_SUCCESS or EXIT_FAILURE in case of corrupted configuration file (PARAMETERS are not changed)
  */
 int load_parameters(const char *filepath) {
     int counter;
+    int corrupted = 0;
     char *string;
     char *parseable_string;
     FILE *config;
-    char should_continue;
+    parameters params;
 
     if (!filepath) return EXIT_FAILURE;
 
@@ -293,91 +497,39 @@ int load_parameters(const char *filepath) {
     if (!config) return EXIT_FAILURE;
 
     string = malloc(MAXLENGTH);
-    should_continue = 1;
 
     if (!string) {
         fclose(config);
         return EXIT_FAILURE;
     }
 
+    params.dormantDays = DORMANT_DAYS_DEFAULT;
     counter = 0;
-    while (should_continue && !feof(config)) {
-        fgets(string, MAXLENGTH, config);
+    while (counter < PARAMETER_COUNT && fgets(string, MAXLENGTH, config)) {
         //this line is a comment, so continue
-        if (string[0] == '#') continue;
+        if (string[0] == '#' || string[0] == '\n' || string[0] == '\r') continue;
 
         //we only need the part which is after colon
         parseable_string = strchr(string, ':');
         //line doesn't contain a colon, the file is corrupted
-        if (!parseable_string) break;
+        if (!parseable_string) {
+            corrupted = 1;
+            break;
+        }
 
         //pointer points to place where colon is, after colon is whitespace and then the parameter
-        parseable_string = parseable_string + 2;
-        switch (counter) {
-            case 0:
-                MOVE_STD_DEV = strtod(parseable_string, NULL);
-                if (MOVE_STD_DEV <= 0) should_continue = 0;
-                break;
-            case 1:
-                MOVE_MEAN = strtod(parseable_string, NULL);
-                if (MOVE_MEAN <= 0) should_continue = 0;
-                break;
-            case 2:
-                MEETING_FACTOR = strtod(parseable_string, NULL);
-                if (MEETING_FACTOR <= 0 || MEETING_FACTOR > 1) should_continue = 0;
-                break;
-            case 3:
-                INFECTION_TIME_MEAN = strtol(parseable_string, NULL, 10);
-                if (INFECTION_TIME_MEAN <= 0) should_continue = 0;
-                break;
-            case 4:
-                INFECTION_TIME_STD_DEV = strtol(parseable_string, NULL, 10);
-                if (INFECTION_TIME_STD_DEV <= 0) should_continue = 0;
-                break;
-            case 5:
-                IMMUNITY_TIME_MEAN = strtol(parseable_string, NULL, 10);
-                if (IMMUNITY_TIME_MEAN < 0) should_continue = 0;
-                break;
-            case 6:
-                IMMUNITY_TIME_STD_DEV = strtol(parseable_string, NULL, 10);
-                if (IMMUNITY_TIME_STD_DEV <= 0) should_continue = 0;
-                break;
-            case 7:
-                MOVING_CITIZENS = strtod(parseable_string, NULL);
-                if (MOVING_CITIZENS <= 0 || MOVING_CITIZENS > 1) should_continue = 0;
-                break;
-            case 8:
-                SPREAD_MEAN = strtod(parseable_string, NULL);
-                if (SPREAD_MEAN <= 0 || SPREAD_MEAN > 1) should_continue = 0;
-                break;
-            case 9:
-                SPREAD_STD_DEV = strtod(parseable_string, NULL);
-                if (SPREAD_STD_DEV <= 0 || SPREAD_STD_DEV > 1) should_continue = 0;
-                break;
-            case 10:
-                DEATH_THRESHOLD = strtod(parseable_string, NULL);
-                if (DEATH_THRESHOLD < 0 || DEATH_THRESHOLD > 1) should_continue = 0;
-                break;
-            case 11:
-                GO_BACK_THRESHOLD_HIGH = strtod(parseable_string, NULL);
-                if (GO_BACK_THRESHOLD_HIGH < 0 || GO_BACK_THRESHOLD_HIGH > 1) should_continue = 0;
-                break;
-            case 12:
-                GO_BACK_THRESHOLD_LOW = strtod(parseable_string, NULL);
-                if (GO_BACK_THRESHOLD_LOW < 0 || GO_BACK_THRESHOLD_LOW > 1) {
-                    counter--;
-                }
-                should_continue = 0;
-                break;
-            default:
-                should_continue = 0;
+        if (parametersSet(&params, counter, strtod(parseable_string + 2, NULL)) == EXIT_FAILURE) {
+            corrupted = 1;
+            break;
         }
         counter++;
     }
 
     fclose(config);
     free(string);
-    //were all the parameters loaded?
-    return counter == 13 ? EXIT_SUCCESS : EXIT_FAILURE;
+    //were all the required parameters loaded?
+    if (corrupted || counter < PARAMETER_REQUIRED_COUNT) return EXIT_FAILURE;
+    PARAMETERS = params;
+    return EXIT_SUCCESS;
 }
 
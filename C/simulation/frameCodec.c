@@ -0,0 +1,132 @@
+/**
+ * This module contains compact encoding of the frames. Every value is stored as a difference
+ * from the previous day (zigzag encoded, so small negative differences stay small), packed into
+ * varint (7 bits per byte) and runs of unchanged values are stored as ZERO_RUN_TOKEN followed
+ * by the length of the run. Non-zero difference never starts with ZERO_RUN_TOKEN byte.
+ */
+
+#include <stdlib.h>
+#include "frameCodec.h"
+
+/**
+ * Writes value as varint (lowest 7 bits first, highest bit of the byte means "more bytes follow")
+ * @param value value to be written
+ * @param buffer where the value will be written
+ * @return number of written bytes
+ */
+static size_t writeVarint(unsigned int value, unsigned char *buffer) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        buffer[length++] = (unsigned char) (value | 0x80);
+        value >>= 7;
+    }
+    buffer[length++] = (unsigned char) value;
+    return length;
+}
+
+/**
+ * Reads varint from the buffer
+ * @param buffer encoded data
+ * @param length length of the buffer
+ * @param position position of the varint, moved behind the varint
+ * @param value where the value will be stored
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the buffer ends in the middle of the varint
+ */
+static int readVarint(const unsigned char *buffer, size_t length, size_t *position, unsigned int *value) {
+    unsigned int result = 0;
+    int shift;
+
+    for (shift = 0; shift < 7 * VARINT_MAX_BYTES && *position < length; shift += 7) {
+        result |= (unsigned int) (buffer[*position] & 0x7F) << shift;
+        if (!(buffer[(*position)++] & 0x80)) {
+            *value = result;
+            return EXIT_SUCCESS;
+        }
+    }
+
+    return EXIT_FAILURE;
+}
+
+/**
+ * Returns size of the buffer which is always big enough for frameEncode
+ * @param count number of encoded values
+ * @return size in bytes
+ */
+size_t frameEncodeMaxSize(int count) {
+    return count > 0 ? (size_t) count * VARINT_MAX_BYTES : 0;
+}
+
+/**
+ * Encodes values as zigzag deltas against previous values
+ * @param values values to be encoded
+ * @param previous values of the previous frame or NULL (values are encoded against zeros - key frame)
+ * @param count number of values
+ * @param buffer buffer of at least frameEncodeMaxSize(count) bytes
+ * @return number of bytes written into the buffer
+ */
+size_t frameEncode(const int *values, const int *previous, int count, unsigned char *buffer) {
+    size_t length = 0;
+    unsigned int delta;
+    int i, run = 0;
+
+    if (!values || !buffer || count <= 0) return 0;
+
+    for (i = 0; i < count; i++) {
+        delta = (unsigned int) values[i] - (unsigned int) (previous ? previous[i] : 0);
+
+        if (!delta) {
+            run++;
+            continue;
+        }
+
+        if (run) {
+            buffer[length++] = ZERO_RUN_TOKEN;
+            length += writeVarint(run, buffer + length);
+            run = 0;
+        }
+        length += writeVarint((delta << 1) ^ (unsigned int) ((int) delta >> 31), buffer + length);
+    }
+
+    if (run) {
+        buffer[length++] = ZERO_RUN_TOKEN;
+        length += writeVarint(run, buffer + length);
+    }
+
+    return length;
+}
+
+/**
+ * Decodes values encoded by frameEncode
+ * @param buffer encoded data
+ * @param length length of the encoded data
+ * @param previous values of the previous frame or NULL (key frame)
+ * @param values where decoded values will be stored, can be the same array as previous
+ * @param count number of values
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the data are corrupted or don't contain exactly count values
+ */
+int frameDecode(const unsigned char *buffer, size_t length, const int *previous, int *values, int count) {
+    size_t position = 0;
+    unsigned int token, run;
+    int i = 0;
+
+    if (!buffer || !values || count <= 0) return EXIT_FAILURE;
+
+    while (position < length) {
+        if (buffer[position] == ZERO_RUN_TOKEN) {
+            position++;
+            if (readVarint(buffer, length, &position, &run) == EXIT_FAILURE) return EXIT_FAILURE;
+            if (run > (unsigned int) (count - i)) return EXIT_FAILURE;
+
+            for (; run > 0; run--, i++) {
+                values[i] = previous ? previous[i] : 0;
+            }
+            continue;
+        }
+
+        if (readVarint(buffer, length, &position, &token) == EXIT_FAILURE || i >= count) return EXIT_FAILURE;
+        values[i] = (int) ((unsigned int) (previous ? previous[i] : 0) + ((token >> 1) ^ (0U - (token & 1))));
+        i++;
+    }
+
+    return i == count ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,15 @@
+#ifndef FEM_LIKE_SPREADING_MODELLING_FRAMECODEC_H
+#define FEM_LIKE_SPREADING_MODELLING_FRAMECODEC_H
+
+#include <stddef.h>
+
+/* varint of 32 bit value takes at most 5 bytes */
+#define VARINT_MAX_BYTES 5
+/* token which starts run of unchanged values */
+#define ZERO_RUN_TOKEN 0x00
+
+size_t frameEncodeMaxSize(int count);
+size_t frameEncode(const int *values, const int *previous, int count, unsigned char *buffer);
+int frameDecode(const unsigned char *buffer, size_t length, const int *previous, int *values, int count);
+
+#endif //FEM_LIKE_SPREADING_MODELLING_FRAMECODEC_H
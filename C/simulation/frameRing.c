@@ -0,0 +1,127 @@
+/**
+ * This module contains functions to work with frameRing struct. FrameRing keeps the last
+ * FRAME_RING_CAPACITY frames of the simulation in memory, so the recent days can be served
+ * without touching the frame store. The simulation thread publishes every finished day,
+ * readers copy the frames without any lock (every slot is protected by a sequence lock).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "frameRing.h"
+
+#define FRAME_RING_MASK (FRAME_RING_CAPACITY - 1)
+
+/**
+ * Creates empty ring for the frames of the country
+ * @param numberOfCities number of cities in every frame
+ * @return pointer to the ring or NULL if it is not possible to allocate memory
+ */
+frameRing *createFrameRing(int numberOfCities) {
+    frameRing *ring;
+    int i;
+
+    if (numberOfCities <= 0) return NULL;
+
+    ring = malloc(sizeof(frameRing));
+    if (!ring) return NULL;
+
+    ring->values = malloc((size_t) FRAME_RING_CAPACITY * 2 * numberOfCities * sizeof(int));
+    if (!ring->values) {
+        free(ring);
+        return NULL;
+    }
+
+    ring->numberOfCities = numberOfCities;
+    for (i = 0; i < FRAME_RING_CAPACITY; i++) {
+        atomic_init(&ring->slots[i].sequence, 0);
+        atomic_init(&ring->slots[i].date, -1);
+        ring->slots[i].values = ring->values + (size_t) i * 2 * numberOfCities;
+    }
+    atomic_init(&ring->latestDate, -1);
+    return ring;
+}
+
+/**
+ * Publishes the frame of the finished day, the oldest day in the ring is overwritten
+ * Must be called only by one thread (the simulation)
+ * @param ring ring
+ * @param date number of the day
+ * @param population population of all the cities
+ * @param infected infected of all the cities
+ */
+void frameRingPublish(frameRing *ring, int date, const int *population, const int *infected) {
+    frameRingSlot *slot;
+    unsigned int sequence;
+
+    if (!ring || date < 0) return;
+
+    slot = &ring->slots[date & FRAME_RING_MASK];
+    sequence = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+
+    /* odd sequence - readers copying the slot now will retry or give up */
+    atomic_store_explicit(&slot->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    atomic_store_explicit(&slot->date, date, memory_order_relaxed);
+    memcpy(slot->values, population, ring->numberOfCities * sizeof(int));
+    memcpy(slot->values + ring->numberOfCities, infected, ring->numberOfCities * sizeof(int));
+
+    atomic_store_explicit(&slot->sequence, sequence + 2, memory_order_release);
+    atomic_store_explicit(&ring->latestDate, date, memory_order_release);
+}
+
+/**
+ * Returns the last published day
+ * @param ring ring
+ * @return number of the day or -1 if nothing was published yet
+ */
+int frameRingLatest(frameRing *ring) {
+    if (!ring) return -1;
+    return atomic_load_explicit(&ring->latestDate, memory_order_acquire);
+}
+
+/**
+ * Copies the frame of the day from the ring
+ * @param ring ring
+ * @param date number of the day
+ * @param population output array (numberOfCities values)
+ * @param infected output array (numberOfCities values)
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the day is not in the ring (too old, not published yet
+ *         or overwritten while copying) - the frame has to be read from the frame store then
+ */
+int frameRingRead(frameRing *ring, int date, int *population, int *infected) {
+    frameRingSlot *slot;
+    unsigned int before, after;
+    int latest, slotDate, i;
+
+    latest = frameRingLatest(ring);
+    if (date < 0 || date > latest || date <= latest - FRAME_RING_CAPACITY) return EXIT_FAILURE;
+
+    slot = &ring->slots[date & FRAME_RING_MASK];
+    for (i = 0; i < FRAME_RING_READ_RETRIES; i++) {
+        before = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        if (before & 1) continue;
+
+        slotDate = atomic_load_explicit(&slot->date, memory_order_relaxed);
+        if (slotDate != date) return EXIT_FAILURE;
+        memcpy(population, slot->values, ring->numberOfCities * sizeof(int));
+        memcpy(infected, slot->values + ring->numberOfCities, ring->numberOfCities * sizeof(int));
+
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+        if (before == after) return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
+
+/**
+ * Frees the ring, no reader may use it anymore
+ * @param ring pointer to pointer to the ring
+ */
+void freeFrameRing(frameRing **ring) {
+    if (!ring || !*ring) return;
+
+    free((*ring)->values);
+    free(*ring);
+    *ring = NULL;
+}
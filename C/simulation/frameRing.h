@@ -0,0 +1,40 @@
+#ifndef FEM_LIKE_SPREADING_MODELLING_FRAMERING_H
+#define FEM_LIKE_SPREADING_MODELLING_FRAMERING_H
+
+#include <stdatomic.h>
+
+/* number of the most recent days kept in memory, must be a power of two */
+#define FRAME_RING_CAPACITY 64
+/* how many times the reader tries to copy the slot which is being rewritten */
+#define FRAME_RING_READ_RETRIES 4
+
+/**
+ * One day in the ring, protected by a sequence lock
+ * sequence is odd while the writer rewrites the slot, readers copy the values
+ * and then check that the sequence didn't change
+ */
+typedef struct {
+    atomic_uint sequence;
+    atomic_int date;
+    int *values;
+} frameRingSlot;
+
+/**
+ * Bounded ring of the last FRAME_RING_CAPACITY frames (population of all the cities followed by infected)
+ * Single writer (the simulation thread) never waits for the readers, readers never block the writer
+ */
+typedef struct {
+    int numberOfCities;
+    frameRingSlot slots[FRAME_RING_CAPACITY];
+    int *values;
+    /* the last published day, -1 if there is none */
+    atomic_int latestDate;
+} frameRing;
+
+frameRing *createFrameRing(int numberOfCities);
+void frameRingPublish(frameRing *ring, int date, const int *population, const int *infected);
+int frameRingLatest(frameRing *ring);
+int frameRingRead(frameRing *ring, int date, int *population, int *infected);
+void freeFrameRing(frameRing **ring);
+
+#endif //FEM_LIKE_SPREADING_MODELLING_FRAMERING_H
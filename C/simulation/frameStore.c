@@ -0,0 +1,414 @@
+/**
+ * This module contains functions to work with frameStore struct. FrameStore is a single
+ * append-only file with all the frames of the simulation (static columns are written only
+ * once in the header) and an index file which allows seeking to any day in O(1).
+ * Frames are encoded by frameCodec, mostly against the previous day.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "frameStore.h"
+#include "frameCodec.h"
+
+/**
+ * Allocates buffers used for encoding and decoding of the frames
+ * @param store store with known number of cities
+ * @return EXIT_SUCCESS or EXIT_FAILURE if it is not possible to allocate memory
+ */
+static int allocateBuffers(frameStore *store) {
+    store->previous = malloc(2 * store->numberOfCities * sizeof(int));
+    store->cached = malloc(2 * store->numberOfCities * sizeof(int));
+    store->block = malloc(frameEncodeMaxSize(2 * store->numberOfCities));
+    store->previousDate = -1;
+    store->cachedDate = -1;
+
+    return store->previous && store->cached && store->block ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * Reads the header of the data file and fills the store
+ * @param store store with opened data file
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the header is corrupted or it is not possible
+ *         to allocate memory
+ */
+static int readHeader(frameStore *store) {
+    char magic[4];
+    int version;
+
+    fseek(store->data, 0, SEEK_SET);
+    if (fread(magic, sizeof(char), 4, store->data) != 4 || memcmp(magic, FRAME_STORE_MAGIC, 4) != 0)
+        return EXIT_FAILURE;
+    if (fread(&version, sizeof(int), 1, store->data) != 1 || version != FRAME_STORE_VERSION)
+        return EXIT_FAILURE;
+    if (fread(&store->numberOfCities, sizeof(int), 1, store->data) != 1 || store->numberOfCities <= 0)
+        return EXIT_FAILURE;
+
+    store->cityIds = malloc(store->numberOfCities * sizeof(int));
+    if (!store->cityIds) return EXIT_FAILURE;
+
+    if (fread(store->cityIds, sizeof(int), store->numberOfCities, store->data) != store->numberOfCities)
+        return EXIT_FAILURE;
+
+    store->headerSize = 4 + 2 * sizeof(int) + store->numberOfCities * sizeof(int);
+    return allocateBuffers(store);
+}
+
+/**
+ * Creates new (empty) frame store, existing files on the paths are truncated
+ * @param dataPath path to the data file
+ * @param indexPath path to the index file
+ * @param cityIds ids of the cities (kod_obce), written once into the header
+ * @param numberOfCities must be greater than zero
+ * @return pointer to frameStore struct or NULL if parameters are invalid, files can't be
+ *         created or it is not possible to allocate memory
+ */
+frameStore *createFrameStore(const char *dataPath, const char *indexPath, const int *cityIds, int numberOfCities) {
+    frameStore *store;
+    int version = FRAME_STORE_VERSION;
+
+    if (!dataPath || !indexPath || !cityIds || numberOfCities <= 0) return NULL;
+
+    store = calloc(1, sizeof(frameStore));
+    if (!store) return NULL;
+
+    store->data = fopen(dataPath, "w+b");
+    store->index = fopen(indexPath, "w+b");
+    store->cityIds = malloc(numberOfCities * sizeof(int));
+    store->numberOfCities = numberOfCities;
+    if (!store->data || !store->index || !store->cityIds || allocateBuffers(store) == EXIT_FAILURE) {
+        freeFrameStore(&store);
+        return NULL;
+    }
+
+    memcpy(store->cityIds, cityIds, numberOfCities * sizeof(int));
+    store->headerSize = 4 + 2 * sizeof(int) + numberOfCities * sizeof(int);
+    store->writable = 1;
+
+    fwrite(FRAME_STORE_MAGIC, sizeof(char), 4, store->data);
+    fwrite(&version, sizeof(int), 1, store->data);
+    fwrite(&numberOfCities, sizeof(int), 1, store->data);
+    fwrite(cityIds, sizeof(int), numberOfCities, store->data);
+    if (fflush(store->data) == EOF) {
+        freeFrameStore(&store);
+        return NULL;
+    }
+
+    return store;
+}
+
+/**
+ * Opens already existing frame store
+ * @param dataPath path to the data file
+ * @param indexPath path to the index file
+ * @param writable 1 if frames will be appended, 0 for read only access
+ * @return pointer to frameStore struct or NULL if files don't exist, are corrupted or it
+ *         is not possible to allocate memory
+ */
+frameStore *openFrameStore(const char *dataPath, const char *indexPath, char writable) {
+    frameStore *store;
+
+    if (!dataPath || !indexPath) return NULL;
+
+    store = calloc(1, sizeof(frameStore));
+    if (!store) return NULL;
+
+    store->writable = writable;
+    store->data = fopen(dataPath, writable ? "r+b" : "rb");
+    store->index = fopen(indexPath, writable ? "r+b" : "rb");
+    if (!store->data || !store->index || readHeader(store) == EXIT_FAILURE) {
+        freeFrameStore(&store);
+        return NULL;
+    }
+
+    return store;
+}
+
+/**
+ * Returns number of days in the index (some of them may be empty if the store was resumed with a gap)
+ * @param store not null pointer to frameStore
+ * @return number of days or -1 if store is invalid
+ */
+int frameStoreFrames(frameStore *store) {
+    long size;
+    if (!store) return -1;
+
+    if (fseek(store->index, 0, SEEK_END) != 0) return -1;
+    size = ftell(store->index);
+    if (size < 0) return -1;
+
+    return (int) (size / sizeof(frameIndexEntry));
+}
+
+/**
+ * Reads index entry of the day, only one seek is needed
+ * @param store not null pointer to frameStore
+ * @param date day of the simulation
+ * @param entry where the entry will be stored
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the day is not in the store
+ */
+int frameStoreReadEntry(frameStore *store, int date, frameIndexEntry *entry) {
+    if (!store || !entry || date < 0 || date >= frameStoreFrames(store)) return EXIT_FAILURE;
+
+    if (fseek(store->index, (long) date * sizeof(frameIndexEntry), SEEK_SET) != 0) return EXIT_FAILURE;
+    if (fread(entry, sizeof(frameIndexEntry), 1, store->index) != 1) return EXIT_FAILURE;
+
+    return entry->length > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * Appends counters of the day at the end of the data file and publishes it in the index.
+ * Index entry is written only after the data are flushed, so readers never see half written frame.
+ * The frame is encoded against the previous day, unless the previous day was not appended by this
+ * store or the day is a multiple of FRAME_KEY_INTERVAL. If the day is not written completely, the next day
+ * is a key frame (it is not encoded against the missing day).
+ * If the date is lower than number of days in the store (simulation was resumed from older state)
+ * newer days are dropped from the index.
+ * @param store store opened as writable
+ * @param date day of the simulation, must be non-negative
+ * @param population population of all the cities (in order of store->cityIds)
+ * @param infected number of infected in all the cities (in order of store->cityIds)
+ * @return EXIT_SUCCESS or EXIT_FAILURE in case of invalid parameters or io error
+ */
+int frameStoreAppend(frameStore *store, int date, const int *population, const int *infected) {
+    frameIndexEntry entry;
+    frameIndexEntry emptyEntry = {0, 0, FRAME_ENCODING_NONE};
+    int frames, n;
+    char key;
+
+    if (!store || !store->writable || date < 0 || !population || !infected) return EXIT_FAILURE;
+
+    frames = frameStoreFrames(store);
+    if (frames < 0) return EXIT_FAILURE;
+
+    n = store->numberOfCities;
+    key = store->previousDate != date - 1 || date % FRAME_KEY_INTERVAL == 0;
+
+    //cached frame is used as scratch, the previous frame is needed for the encoding
+    memcpy(store->cached, population, n * sizeof(int));
+    memcpy(store->cached + n, infected, n * sizeof(int));
+    store->cachedDate = -1;
+    //until the day is in the store, the next day must not be encoded against it (it would be a key frame)
+    store->previousDate = -1;
+
+    if (fseek(store->data, 0, SEEK_END) != 0) return EXIT_FAILURE;
+    entry.offset = ftell(store->data);
+    entry.length = (int) frameEncode(store->cached, key ? NULL : store->previous, 2 * n, store->block);
+    entry.encoding = key ? FRAME_ENCODING_KEY : FRAME_ENCODING_DELTA;
+
+    if (fwrite(store->block, sizeof(unsigned char), entry.length, store->data) != (size_t) entry.length) return EXIT_FAILURE;
+    if (fflush(store->data) == EOF) return EXIT_FAILURE;
+
+    if (date < frames) {
+        if (ftruncate(fileno(store->index), (off_t) date * sizeof(frameIndexEntry)) != 0) return EXIT_FAILURE;
+        frames = date;
+    }
+
+    //days which were never simulated (store created later than the saved state) stay empty
+    if (fseek(store->index, (long) frames * sizeof(frameIndexEntry), SEEK_SET) != 0) return EXIT_FAILURE;
+    for (; frames < date; frames++) {
+        if (fwrite(&emptyEntry, sizeof(frameIndexEntry), 1, store->index) != 1) return EXIT_FAILURE;
+    }
+    if (fwrite(&entry, sizeof(frameIndexEntry), 1, store->index) != 1) return EXIT_FAILURE;
+    if (fflush(store->index) == EOF) return EXIT_FAILURE;
+
+    memcpy(store->previous, store->cached, 2 * n * sizeof(int));
+    store->previousDate = date;
+    store->cachedDate = date;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Returns size of the buffer which is always big enough for one encoded block
+ * @param store not null pointer to frameStore
+ * @return size of the buffer in bytes
+ */
+size_t frameStoreBlockMaxSize(frameStore *store) {
+    if (!store) return 0;
+
+    return frameEncodeMaxSize(2 * store->numberOfCities);
+}
+
+/**
+ * Reads encoded block of the day (as it is stored in the data file)
+ * @param store not null pointer to frameStore
+ * @param date day of the simulation
+ * @param entry where the index entry of the day will be stored
+ * @param buffer buffer of at least frameStoreBlockMaxSize bytes
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the day is not in the store or the store is corrupted
+ */
+int frameStoreReadBlock(frameStore *store, int date, frameIndexEntry *entry, unsigned char *buffer) {
+    if (!buffer || frameStoreReadEntry(store, date, entry) == EXIT_FAILURE) return EXIT_FAILURE;
+    if (entry->length > frameStoreBlockMaxSize(store)) return EXIT_FAILURE;
+
+    if (fseek(store->data, (long) entry->offset, SEEK_SET) != 0) return EXIT_FAILURE;
+    if (fread(buffer, sizeof(unsigned char), entry->length, store->data) != entry->length) return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Decodes frame of the day into store->cached. Decoding starts either from the cached day
+ * or from the closest key frame, so sequential reading decodes only one block per day.
+ * @param store not null pointer to frameStore
+ * @param date day of the simulation
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the day is not in the store or the store is corrupted
+ */
+static int decodeFrame(frameStore *store, int date) {
+    frameIndexEntry entry;
+    int start;
+
+    if (store->cachedDate == date) return EXIT_SUCCESS;
+
+    //find the first day which has to be decoded
+    for (start = date;; start--) {
+        if (frameStoreReadEntry(store, start, &entry) == EXIT_FAILURE) return EXIT_FAILURE;
+        if (entry.encoding == FRAME_ENCODING_KEY) break;
+        if (entry.encoding != FRAME_ENCODING_DELTA) return EXIT_FAILURE;
+        if (store->cachedDate == start - 1 && store->cachedDate >= 0) break;
+    }
+
+    for (; start <= date; start++) {
+        if (frameStoreReadBlock(store, start, &entry, store->block) == EXIT_FAILURE ||
+            frameDecode(store->block, entry.length, entry.encoding == FRAME_ENCODING_KEY ? NULL : store->cached,
+                        store->cached, 2 * store->numberOfCities) == EXIT_FAILURE) {
+            store->cachedDate = -1;
+            return EXIT_FAILURE;
+        }
+        store->cachedDate = start;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Reads counters of the day from the store
+ * @param store not null pointer to frameStore
+ * @param date day of the simulation
+ * @param population array of store->numberOfCities ints, where population will be stored
+ * @param infected array of store->numberOfCities ints, where infected will be stored
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the day is not in the store or the store is corrupted
+ */
+int frameStoreReadFrame(frameStore *store, int date, int *population, int *infected) {
+    if (!store || !population || !infected) return EXIT_FAILURE;
+    if (decodeFrame(store, date) == EXIT_FAILURE) return EXIT_FAILURE;
+
+    memcpy(population, store->cached, store->numberOfCities * sizeof(int));
+    memcpy(infected, store->cached + store->numberOfCities, store->numberOfCities * sizeof(int));
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Returns size of the buffer which is always big enough for frameStoreFormatCsv
+ * @param store not null pointer to frameStore
+ * @return size of the buffer in bytes (including null terminator)
+ */
+size_t frameStoreCsvSize(frameStore *store) {
+    if (!store) return 0;
+
+    return strlen(FRAME_CSV_HEADER) + (size_t) store->numberOfCities * FRAME_CSV_MAX_ROW + 1;
+}
+
+/**
+ * Writes decimal representation of the value followed by the separator (faster than sprintf)
+ * @param value value to be written
+ * @param separator char written after the value
+ * @param buffer where the value will be written
+ * @return number of written chars
+ */
+static size_t formatInt(int value, char separator, char *buffer) {
+    char digits[12];
+    unsigned int rest = value < 0 ? 0U - (unsigned int) value : (unsigned int) value;
+    size_t length = 0, i = 0;
+
+    do {
+        digits[i++] = (char) ('0' + rest % 10);
+        rest /= 10;
+    } while (rest);
+
+    if (value < 0) buffer[length++] = '-';
+    while (i) buffer[length++] = digits[--i];
+    buffer[length++] = separator;
+
+    return length;
+}
+
+/**
+ * Formats the frame in the same csv format as create_csv_from_country does
+ * @param store not null pointer to frameStore (source of the city ids)
+ * @param date day of the simulation
+ * @param population population of all the cities
+ * @param infected number of infected in all the cities
+ * @param buffer buffer of at least frameStoreCsvSize bytes
+ * @return length of the csv in the buffer (without null terminator)
+ */
+size_t frameStoreFormatCsv(frameStore *store, int date, const int *population, const int *infected, char *buffer) {
+    size_t length;
+    int i;
+
+    if (!store || !population || !infected || !buffer) return 0;
+
+    length = strlen(FRAME_CSV_HEADER);
+    memcpy(buffer, FRAME_CSV_HEADER, length);
+
+    for (i = 0; i < store->numberOfCities; i++) {
+        length += formatInt(store->cityIds[i], ',', buffer + length);
+        length += formatInt(population[i], ',', buffer + length);
+        length += formatInt(infected[i], ',', buffer + length);
+        length += formatInt(date, '\n', buffer + length);
+    }
+
+    return length;
+}
+
+/**
+ * Exports one day of the store into csv file
+ * @param store not null pointer to frameStore
+ * @param date day of the simulation
+ * @param filepath path to the output CSV file
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the day is not in the store or the file can't be written
+ */
+int frameStoreExportCsv(frameStore *store, int date, const char *filepath) {
+    FILE *fp;
+    int *population, *infected;
+    char *buffer;
+    size_t length;
+    int result = EXIT_FAILURE;
+
+    if (!store || !filepath) return EXIT_FAILURE;
+
+    population = malloc(store->numberOfCities * sizeof(int));
+    infected = malloc(store->numberOfCities * sizeof(int));
+    buffer = malloc(frameStoreCsvSize(store));
+
+    if (population && infected && buffer &&
+        frameStoreReadFrame(store, date, population, infected) == EXIT_SUCCESS &&
+        (fp = fopen(filepath, "w"))) {
+        length = frameStoreFormatCsv(store, date, population, infected, buffer);
+        if (fwrite(buffer, sizeof(char), length, fp) == length) result = EXIT_SUCCESS;
+        if (fclose(fp) == EOF) result = EXIT_FAILURE;
+    }
+
+    free(population);
+    free(infected);
+    free(buffer);
+    return result;
+}
+
+/**
+ * Closes the files and deallocates memory used by frameStore struct
+ * @param store pointer to pointer to frameStore
+ */
+void freeFrameStore(frameStore **store) {
+    if (!store || !*store) return;
+
+    if ((*store)->data) fclose((*store)->data);
+    if ((*store)->index) fclose((*store)->index);
+    free((*store)->cityIds);
+    free((*store)->previous);
+    free((*store)->cached);
+    free((*store)->block);
+    free(*store);
+    *store = NULL;
+}
@@ -0,0 +1,69 @@
+#ifndef FEM_LIKE_SPREADING_MODELLING_FRAMESTORE_H
+#define FEM_LIKE_SPREADING_MODELLING_FRAMESTORE_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#define FRAME_STORE_FILEPATH "./DATA/sim_frames/frames.dat"
+#define FRAME_INDEX_FILEPATH "./DATA/sim_frames/frames.idx"
+#define FRAME_STORE_MAGIC "FRST"
+#define FRAME_STORE_VERSION 2
+#define FRAME_CSV_HEADER "kod_obce,pocet_obyvatel,pocet_nakazenych,datum\n"
+/* longest possible csv row - four ints, three commas and a new line */
+#define FRAME_CSV_MAX_ROW 48
+
+/* every FRAME_KEY_INTERVAL days the frame is encoded without previous day, so reading any day
+   needs to decode at most FRAME_KEY_INTERVAL blocks */
+#define FRAME_KEY_INTERVAL 32
+
+/* empty entry - day which is not in the store */
+#define FRAME_ENCODING_NONE 0
+/* frame encoded against zeros (frameCodec.h) */
+#define FRAME_ENCODING_KEY 1
+/* frame encoded against the previous day (frameCodec.h) */
+#define FRAME_ENCODING_DELTA 2
+
+/**
+ * One entry of the index file, entry of the day d is stored at d * sizeof(frameIndexEntry)
+ */
+typedef struct {
+    long long offset;
+    int length;
+    int encoding;
+} frameIndexEntry;
+
+/**
+ * Append-only store of the simulation frames
+ * Data file contains header (magic, version, number of cities, city ids) followed by
+ * one encoded block per day (population column followed by infected column)
+ */
+typedef struct {
+    FILE *data;
+    FILE *index;
+    int numberOfCities;
+    int *cityIds;
+    long long headerSize;
+    char writable;
+    /* last appended frame, the next one is encoded against it */
+    int *previous;
+    int previousDate;
+    /* last decoded frame, sequential reading decodes only one block */
+    int *cached;
+    int cachedDate;
+    unsigned char *block;
+} frameStore;
+
+frameStore *createFrameStore(const char *dataPath, const char *indexPath, const int *cityIds, int numberOfCities);
+frameStore *openFrameStore(const char *dataPath, const char *indexPath, char writable);
+int frameStoreFrames(frameStore *store);
+int frameStoreReadEntry(frameStore *store, int date, frameIndexEntry *entry);
+int frameStoreAppend(frameStore *store, int date, const int *population, const int *infected);
+int frameStoreReadFrame(frameStore *store, int date, int *population, int *infected);
+size_t frameStoreBlockMaxSize(frameStore *store);
+int frameStoreReadBlock(frameStore *store, int date, frameIndexEntry *entry, unsigned char *buffer);
+size_t frameStoreFormatCsv(frameStore *store, int date, const int *population, const int *infected, char *buffer);
+size_t frameStoreCsvSize(frameStore *store);
+int frameStoreExportCsv(frameStore *store, int date, const char *filepath);
+void freeFrameStore(frameStore **store);
+
+#endif //FEM_LIKE_SPREADING_MODELLING_FRAMESTORE_H
@@ -29,7 +29,7 @@ hashTable *createHashTable(int size, int itemSize) {
     table->itemSize = itemSize;
     table->array = malloc(sizeof(arrayList *) * table->size);
     for (i = 0; i < table->size; i++) {
-        table->array[i] = createArrayList(500, table->itemSize);
+        table->array[i] = createArrayList(HASH_TABLE_LIST_SIZE, table->itemSize);
     }
 
     return table;
@@ -73,6 +73,23 @@ void *hashTableRemoveElement(int arrayIndex, int elementIndex, hashTable *table)
     return pointer;
 }
 
+/**
+ * Removes all the NULL pointers (elements cleared in place) from all the arrayLists of the hashTable
+ * @param table not null hashtable
+ * @return number of removed elements
+ */
+int hashTableCompact(hashTable *table) {
+    int i;
+    int removed = 0;
+    if (!table) return 0;
+
+    for (i = 0; i < table->size; i++) {
+        removed += arrayListCompact(table->array[i]);
+    }
+    table->filledItems -= removed;
+    return removed;
+}
+
 int expandArray(hashTable *table) {
     arrayList **newArrayLists;
     int i;
@@ -1,6 +1,8 @@
 #ifndef GRAPH_C_HASHTABLE_H
 #define GRAPH_C_HASHTABLE_H
 #define ABS(x) (((x) >= (0)) ? (x) : (-(x)))
+/* initial capacity of every arrayList of a new hashTable, the lists double when they are full */
+#define HASH_TABLE_LIST_SIZE 16
 
 #include "arrayList.h"
 
@@ -14,6 +16,7 @@ typedef struct {
 hashTable *createHashTable(int size, int itemSize);
 int hashTableAddElement(void *element, int id, hashTable *table);
 void *hashTableRemoveElement(int arrayIndex, int elementIndex, hashTable *table);
+int hashTableCompact(hashTable *table);
 int expandArray(hashTable *table);
 void freeHashTable(hashTable **table);
 
@@ -0,0 +1,198 @@
+/**
+ * This module contains functions to measure the durations of the phases of the simulation
+ * (wall-clock time from the monotonic clock). Every phase has a histogram with log-sized buckets,
+ * so the percentiles are computed from a fixed amount of memory for any number of samples.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "metrics.h"
+
+/* log2 of METRICS_SUB_BUCKETS */
+#define SUB_BUCKET_BITS 3
+
+metricHistogram METRICS[METRIC_COUNT];
+
+static const char *METRIC_NAMES[METRIC_COUNT] = {"movement", "return_home", "spread", "status_update",
+                                                 "frame_write", "checkpoint", "day", "command"};
+
+/**
+ * Returns the time of the monotonic clock
+ * @return nanoseconds from an unspecified point
+ */
+long long metricsNow(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long) now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * Returns the bucket of the duration
+ * @param nanoseconds duration
+ * @return index of the bucket
+ */
+static int bucketOf(long long nanoseconds) {
+    int exponent;
+    if (nanoseconds < METRICS_SUB_BUCKETS) return nanoseconds < 0 ? 0 : (int) nanoseconds;
+
+    exponent = 63 - __builtin_clzll((unsigned long long) nanoseconds);
+    return (exponent - SUB_BUCKET_BITS + 1) * METRICS_SUB_BUCKETS +
+           (int) ((nanoseconds >> (exponent - SUB_BUCKET_BITS)) & (METRICS_SUB_BUCKETS - 1));
+}
+
+/**
+ * Returns the middle of the bucket
+ * @param bucket index of the bucket
+ * @return duration in nanoseconds
+ */
+static long long bucketValue(int bucket) {
+    int shift;
+    if (bucket < METRICS_SUB_BUCKETS) return bucket;
+
+    shift = bucket / METRICS_SUB_BUCKETS - 1;
+    return ((long long) (METRICS_SUB_BUCKETS + bucket % METRICS_SUB_BUCKETS) << shift) + ((1LL << shift) >> 1);
+}
+
+/**
+ * Records one sample of the phase (can be called by any thread)
+ * @param metric phase (METRIC_*)
+ * @param nanoseconds duration of the phase
+ */
+void metricsRecord(int metric, long long nanoseconds) {
+    metricHistogram *histogram;
+    long long max;
+
+    if (metric < 0 || metric >= METRIC_COUNT) return;
+    histogram = &METRICS[metric];
+
+    atomic_fetch_add_explicit(&histogram->buckets[bucketOf(nanoseconds)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->total, nanoseconds, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->count, 1, memory_order_relaxed);
+
+    max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+    while (nanoseconds > max &&
+           !atomic_compare_exchange_weak_explicit(&histogram->max, &max, nanoseconds, memory_order_relaxed,
+                                                  memory_order_relaxed));
+}
+
+/**
+ * Starts the measurement of the phase - time and hardware counters of the calling thread (if opened)
+ * @param sample output sample
+ */
+void metricsBegin(metricSample *sample) {
+    int i;
+    if (PERF_COUNTERS_ENABLED)
+        perfCountersRead(sample->counters);
+    else
+        for (i = 0; i < PERF_COUNTER_COUNT; i++) sample->counters[i] = PERF_COUNTER_UNAVAILABLE;
+    sample->time = metricsNow();
+}
+
+/**
+ * Ends the measurement of the phase started by metricsBegin and records the sample
+ * (must be called by the thread which started it)
+ * @param metric phase (METRIC_*)
+ * @param sample sample from metricsBegin
+ * @return duration of the phase in nanoseconds
+ */
+long long metricsEnd(int metric, metricSample *sample) {
+    long long counters[PERF_COUNTER_COUNT];
+    long long duration = metricsNow() - sample->time;
+    int i;
+
+    metricsRecord(metric, duration);
+    if (!PERF_COUNTERS_ENABLED || metric < 0 || metric >= METRIC_COUNT ||
+        perfCountersRead(counters) == EXIT_FAILURE)
+        return duration;
+
+    for (i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if (sample->counters[i] == PERF_COUNTER_UNAVAILABLE || counters[i] == PERF_COUNTER_UNAVAILABLE) continue;
+        atomic_fetch_add_explicit(&METRICS[metric].counters[i], counters[i] - sample->counters[i], memory_order_relaxed);
+        atomic_fetch_add_explicit(&METRICS[metric].counterSamples[i], 1, memory_order_relaxed);
+    }
+    return duration;
+}
+
+/**
+ * Returns the percentile of the durations of the phase
+ * @param metric phase (METRIC_*)
+ * @param percentile 0 .. 1
+ * @return duration in nanoseconds (middle of the bucket, at most the longest sample), 0 if there is no sample
+ */
+long long metricsPercentile(int metric, double percentile) {
+    long long count = 0, seen = 0, target, max;
+    int i;
+
+    if (metric < 0 || metric >= METRIC_COUNT) return 0;
+    max = atomic_load_explicit(&METRICS[metric].max, memory_order_relaxed);
+
+    /* samples recorded while reading are counted only if they are in the buckets */
+    for (i = 0; i < METRICS_BUCKETS; i++)
+        count += atomic_load_explicit(&METRICS[metric].buckets[i], memory_order_relaxed);
+    if (!count) return 0;
+
+    target = (long long) (percentile * count + 0.5);
+    if (target < 1) target = 1;
+    for (i = 0; i < METRICS_BUCKETS; i++) {
+        seen += atomic_load_explicit(&METRICS[metric].buckets[i], memory_order_relaxed);
+        /* the middle of the last bucket may be over the longest sample */
+        if (seen >= target) return bucketValue(i) < max ? bucketValue(i) : max;
+    }
+    return max;
+}
+
+/**
+ * Returns the name of the phase (the first column of metricsFormat)
+ * @param metric phase (METRIC_*)
+ * @return name of the phase
+ */
+const char *metricsName(int metric) {
+    return METRIC_NAMES[metric];
+}
+
+/**
+ * Formats the metrics of all the phases as CSV (METRICS_HEADER and one row per phase, times in milliseconds)
+ * @param buffer output buffer, at least strlen(METRICS_HEADER) + METRIC_COUNT * METRICS_MAX_ROW + 1 chars
+ * @return length of the CSV
+ */
+size_t metricsFormat(char *buffer) {
+    char *position = buffer + sprintf(buffer, METRICS_HEADER);
+    long long count, total;
+    int i, j;
+
+    for (i = 0; i < METRIC_COUNT; i++) {
+        count = atomic_load_explicit(&METRICS[i].count, memory_order_relaxed);
+        total = atomic_load_explicit(&METRICS[i].total, memory_order_relaxed);
+        position += sprintf(position, "%s,%lld,%.3f,%.3f,%.3f,%.3f,%.3f", METRIC_NAMES[i], count, total / 1e6,
+                            count ? total / 1e6 / count : 0.0, metricsPercentile(i, 0.5) / 1e6,
+                            metricsPercentile(i, 0.99) / 1e6,
+                            atomic_load_explicit(&METRICS[i].max, memory_order_relaxed) / 1e6);
+        for (j = 0; j < PERF_COUNTER_COUNT; j++)
+            position += sprintf(position, ",%lld",
+                                atomic_load_explicit(&METRICS[i].counterSamples[j], memory_order_relaxed) ?
+                                atomic_load_explicit(&METRICS[i].counters[j], memory_order_relaxed) :
+                                PERF_COUNTER_UNAVAILABLE);
+        *position++ = '\n';
+    }
+    *position = '\0';
+    return position - buffer;
+}
+
+/**
+ * Removes all the samples (nothing may be recorded at the same time)
+ */
+void metricsReset(void) {
+    int i, j;
+    for (i = 0; i < METRIC_COUNT; i++) {
+        atomic_store(&METRICS[i].count, 0);
+        atomic_store(&METRICS[i].total, 0);
+        atomic_store(&METRICS[i].max, 0);
+        for (j = 0; j < METRICS_BUCKETS; j++)
+            atomic_store(&METRICS[i].buckets[j], 0);
+        for (j = 0; j < PERF_COUNTER_COUNT; j++) {
+            atomic_store(&METRICS[i].counters[j], 0);
+            atomic_store(&METRICS[i].counterSamples[j], 0);
+        }
+    }
+}
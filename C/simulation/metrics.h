@@ -0,0 +1,61 @@
+#ifndef FEM_LIKE_SPREADING_MODELLING_METRICS_H
+#define FEM_LIKE_SPREADING_MODELLING_METRICS_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include "perfCounters.h"
+
+/* measured phases, every call of the phase is one sample */
+#define METRIC_MOVEMENT 0
+#define METRIC_RETURN_HOME 1
+#define METRIC_SPREAD 2
+#define METRIC_STATUS_UPDATE 3
+#define METRIC_FRAME_WRITE 4
+#define METRIC_CHECKPOINT 5
+#define METRIC_DAY 6
+#define METRIC_COMMAND 7
+#define METRIC_COUNT 8
+
+/* every power of two of nanoseconds is split into METRICS_SUB_BUCKETS buckets (error of the percentiles is
+   at most 1 / METRICS_SUB_BUCKETS of the value) */
+#define METRICS_SUB_BUCKETS 8
+#define METRICS_BUCKETS (64 * METRICS_SUB_BUCKETS)
+/* hardware counters are totals over all the samples (-1 if not collected, see perfCounters.h) */
+#define METRICS_HEADER "phase,count,total_ms,mean_ms,p50_ms,p99_ms,max_ms,cycles,instructions,llc_misses,dtlb_misses\n"
+/* longest row of metricsFormat */
+#define METRICS_MAX_ROW 224
+
+/**
+ * Histogram of the durations of one phase with log-sized buckets
+ * Counters are atomic - samples are recorded by the simulation (and the server), read by the server
+ */
+typedef struct {
+    atomic_llong count;
+    atomic_llong total;
+    atomic_llong max;
+    atomic_llong buckets[METRICS_BUCKETS];
+    /* sums of the hardware counters and number of the samples they were collected for */
+    atomic_llong counters[PERF_COUNTER_COUNT];
+    atomic_llong counterSamples[PERF_COUNTER_COUNT];
+} metricHistogram;
+
+/**
+ * Start of one measured phase
+ */
+typedef struct {
+    long long time;
+    long long counters[PERF_COUNTER_COUNT];
+} metricSample;
+
+extern metricHistogram METRICS[METRIC_COUNT];
+
+long long metricsNow(void);
+void metricsRecord(int metric, long long nanoseconds);
+void metricsBegin(metricSample *sample);
+long long metricsEnd(int metric, metricSample *sample);
+long long metricsPercentile(int metric, double percentile);
+const char *metricsName(int metric);
+size_t metricsFormat(char *buffer);
+void metricsReset(void);
+
+#endif //FEM_LIKE_SPREADING_MODELLING_METRICS_H
@@ -0,0 +1,101 @@
+/**
+ * This module contains the parameters of the simulation - their names (as used by the sweeps), valid
+ * ranges (as described in parameters.cfg) and access to them by the index in parameters.cfg
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <float.h>
+#include <limits.h>
+#include "parameters.h"
+
+parameters PARAMETERS;
+
+/**
+ * Description of one parameter, value must be from interval (min, max> (or <min, max> if minIncluded)
+ */
+typedef struct {
+    const char *name;
+    size_t offset;
+    char isInteger;
+    char minIncluded;
+    double min;
+    double max;
+} parameterDescription;
+
+static const parameterDescription DESCRIPTIONS[PARAMETER_COUNT] = {
+        {"MOVE_STD_DEV",           offsetof(parameters, moveStdDev),          0, 0, 0, DBL_MAX},
+        {"MOVE_MEAN",              offsetof(parameters, moveMean),            0, 0, 0, DBL_MAX},
+        {"MEETING_FACTOR",         offsetof(parameters, meetingFactor),       0, 0, 0, 1},
+        {"INFECTION_TIME_MEAN",    offsetof(parameters, infectionTimeMean),   1, 0, 0, INT_MAX},
+        {"INFECTION_TIME_STD_DEV", offsetof(parameters, infectionTimeStdDev), 1, 0, 0, INT_MAX},
+        {"IMMUNITY_TIME_MEAN",     offsetof(parameters, immunityTimeMean),    1, 1, 0, INT_MAX},
+        {"IMMUNITY_TIME_STD_DEV",  offsetof(parameters, immunityTimeStdDev),  1, 0, 0, INT_MAX},
+        {"MOVING_CITIZENS",        offsetof(parameters, movingCitizens),      0, 0, 0, 1},
+        {"SPREAD_MEAN",            offsetof(parameters, spreadMean),          0, 0, 0, 1},
+        {"SPREAD_STD_DEV",         offsetof(parameters, spreadStdDev),        0, 0, 0, 1},
+        {"DEATH_THRESHOLD",        offsetof(parameters, deathThreshold),      0, 1, 0, 1},
+        {"GO_BACK_THRESHOLD_HIGH", offsetof(parameters, goBackThresholdHigh), 0, 1, 0, 1},
+        {"GO_BACK_THRESHOLD_LOW",  offsetof(parameters, goBackThresholdLow),  0, 1, 0, 1},
+        {"DORMANT_DAYS",           offsetof(parameters, dormantDays),         1, 1, 0, INT_MAX}
+};
+
+/**
+ * Finds the parameter by its name
+ * @param name name of the parameter, e.g. MEETING_FACTOR
+ * @return index of the parameter (order in parameters.cfg) or -1 if there is no such parameter
+ */
+int parameterIndex(const char *name) {
+    int i;
+    if (!name) return -1;
+    for (i = 0; i < PARAMETER_COUNT; i++)
+        if (!strcmp(DESCRIPTIONS[i].name, name)) return i;
+    return -1;
+}
+
+/**
+ * Returns the name of the parameter
+ * @param index index of the parameter
+ * @return name of the parameter or NULL if the index is invalid
+ */
+const char *parameterName(int index) {
+    if (index < 0 || index >= PARAMETER_COUNT) return NULL;
+    return DESCRIPTIONS[index].name;
+}
+
+/**
+ * Sets the value of the parameter if it is valid (integer parameters are truncated)
+ * @param params parameters
+ * @param index index of the parameter
+ * @param value new value
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the index or the value is invalid (params are not changed)
+ */
+int parametersSet(parameters *params, int index, double value) {
+    const parameterDescription *description;
+
+    if (!params || index < 0 || index >= PARAMETER_COUNT) return EXIT_FAILURE;
+    description = &DESCRIPTIONS[index];
+    if (!(value >= description->min && value <= description->max)) return EXIT_FAILURE;
+    if (description->isInteger) value = (int) value;
+    if (value == description->min && !description->minIncluded) return EXIT_FAILURE;
+
+    if (description->isInteger) *(int *) ((char *) params + description->offset) = (int) value;
+    else *(double *) ((char *) params + description->offset) = value;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Returns the value of the parameter
+ * @param params parameters
+ * @param index index of the parameter
+ * @return value of the parameter or 0 if the index is invalid
+ */
+double parametersGet(parameters *params, int index) {
+    const parameterDescription *description;
+
+    if (!params || index < 0 || index >= PARAMETER_COUNT) return 0;
+    description = &DESCRIPTIONS[index];
+    if (description->isInteger) return *(int *) ((char *) params + description->offset);
+    return *(double *) ((char *) params + description->offset);
+}
@@ -0,0 +1,40 @@
+#ifndef FEM_LIKE_SPREADING_MODELLING_PARAMETERS_H
+#define FEM_LIKE_SPREADING_MODELLING_PARAMETERS_H
+
+/* number of the parameters in parameters.cfg */
+#define PARAMETER_COUNT 14
+/* parameters which must be in parameters.cfg, the later ones were added later and have default values */
+#define PARAMETER_REQUIRED_COUNT 13
+#define DORMANT_DAYS_DEFAULT 14
+
+/**
+ * Parameters of one run of the simulation, in the order of parameters.cfg
+ * Every country has its own copy, so runs with different parameters can coexist in one process
+ */
+typedef struct {
+    double moveStdDev;
+    double moveMean;
+    double meetingFactor;
+    int infectionTimeMean;
+    int infectionTimeStdDev;
+    int immunityTimeMean;
+    int immunityTimeStdDev;
+    double movingCitizens;
+    double spreadMean;
+    double spreadStdDev;
+    double deathThreshold;
+    double goBackThresholdHigh;
+    double goBackThresholdLow;
+    /* days without infected after which the healthy residents at home are kept only as counts, 0 never */
+    int dormantDays;
+} parameters;
+
+/* parameters loaded by load_parameters, every new country starts with a copy of them */
+extern parameters PARAMETERS;
+
+int parameterIndex(const char *name);
+const char *parameterName(int index);
+int parametersSet(parameters *params, int index, double value);
+double parametersGet(parameters *params, int index);
+
+#endif //FEM_LIKE_SPREADING_MODELLING_PARAMETERS_H
@@ -0,0 +1,108 @@
+/**
+ * This module contains functions to read hardware performance counters (cycles, instructions,
+ * last level cache misses, dTLB misses) of the calling thread by perf_event_open (Linux only).
+ * All the counters of the thread are in one group, so they are read by one read. Counters which
+ * are not supported (virtual machines, perf_event_paranoid) are left out.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "perfCounters.h"
+
+char PERF_COUNTERS_ENABLED = 0;
+
+/* counters of the thread - file descriptors (-1 if not opened) and the index of the counter in the group */
+static _Thread_local int COUNTER_FDS[PERF_COUNTER_COUNT] = {-1, -1, -1, -1};
+static _Thread_local int COUNTER_INDICES[PERF_COUNTER_COUNT];
+static _Thread_local int GROUP_FD = -1;
+static _Thread_local int GROUP_SIZE = 0;
+
+/**
+ * Opens one counter of the calling thread
+ * @param type type of the event (PERF_TYPE_*)
+ * @param config event of the type
+ * @param group file descriptor of the leader of the group or -1 for the leader
+ * @return file descriptor or -1 if the counter is not supported
+ */
+static int openCounter(unsigned int type, unsigned long long config, int group) {
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = group < 0;
+    /* only the user space of the thread is allowed with the default perf_event_paranoid */
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+/**
+ * Opens the counters of the calling thread (counting starts immediately)
+ * @return number of the opened counters, 0 if no counter is supported
+ */
+int perfCountersOpen(void) {
+    const unsigned int types[PERF_COUNTER_COUNT] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+                                                    PERF_TYPE_HW_CACHE};
+    const unsigned long long configs[PERF_COUNTER_COUNT] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)};
+    int i;
+
+    if (GROUP_FD >= 0) return GROUP_SIZE;
+
+    for (i = 0; i < PERF_COUNTER_COUNT; i++) {
+        COUNTER_FDS[i] = openCounter(types[i], configs[i], GROUP_FD);
+        if (COUNTER_FDS[i] < 0) continue;
+
+        COUNTER_INDICES[i] = GROUP_SIZE++;
+        if (GROUP_FD < 0) GROUP_FD = COUNTER_FDS[i];
+    }
+    if (GROUP_FD < 0) return 0;
+
+    ioctl(GROUP_FD, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(GROUP_FD, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return GROUP_SIZE;
+}
+
+/**
+ * Reads the counters of the calling thread
+ * @param values output array (PERF_COUNTER_COUNT values, PERF_COUNTER_UNAVAILABLE for the counters
+ *               which are not opened)
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the thread has no counter
+ */
+int perfCountersRead(long long *values) {
+    unsigned long long group[1 + PERF_COUNTER_COUNT];
+    int i;
+
+    if (GROUP_FD < 0 || read(GROUP_FD, group, (1 + GROUP_SIZE) * sizeof(unsigned long long)) <= 0) {
+        for (i = 0; i < PERF_COUNTER_COUNT; i++) values[i] = PERF_COUNTER_UNAVAILABLE;
+        return EXIT_FAILURE;
+    }
+
+    /* the first value is the number of the counters of the group */
+    for (i = 0; i < PERF_COUNTER_COUNT; i++)
+        values[i] = COUNTER_FDS[i] < 0 ? PERF_COUNTER_UNAVAILABLE : (long long) group[1 + COUNTER_INDICES[i]];
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Closes the counters of the calling thread
+ */
+void perfCountersClose(void) {
+    int i;
+    for (i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if (COUNTER_FDS[i] >= 0) close(COUNTER_FDS[i]);
+        COUNTER_FDS[i] = -1;
+    }
+    GROUP_FD = -1;
+    GROUP_SIZE = 0;
+}
@@ -0,0 +1,20 @@
+#ifndef FEM_LIKE_SPREADING_MODELLING_PERFCOUNTERS_H
+#define FEM_LIKE_SPREADING_MODELLING_PERFCOUNTERS_H
+
+/* hardware counters collected for the phases of the simulation */
+#define PERF_COUNTER_CYCLES 0
+#define PERF_COUNTER_INSTRUCTIONS 1
+#define PERF_COUNTER_LLC_MISSES 2
+#define PERF_COUNTER_DTLB_MISSES 3
+#define PERF_COUNTER_COUNT 4
+/* value of the counter which is not supported (or counters are not opened by the thread) */
+#define PERF_COUNTER_UNAVAILABLE -1
+
+/* 1 if the threads should open the counters (-perf switch of the server), set before the threads are started */
+extern char PERF_COUNTERS_ENABLED;
+
+int perfCountersOpen(void);
+int perfCountersRead(long long *values);
+void perfCountersClose(void);
+
+#endif //FEM_LIKE_SPREADING_MODELLING_PERFCOUNTERS_H
@@ -2,12 +2,57 @@
 #include <stdlib.h>
 #include "random.h"
 
+/* generator of the calling thread (xorshift64*), NULL - rand() is used */
+static _Thread_local unsigned long long *RANDOM_STATE = NULL;
+
+/**
+ * Returns random integer from interval <0, RAND_MAX>, from the generator of the calling thread
+ * (randomUseState) or from rand() if the thread has no generator
+ * @return int
+ */
+int randomNext() {
+    unsigned long long x;
+
+    if (!RANDOM_STATE) return rand();
+
+    x = *RANDOM_STATE;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *RANDOM_STATE = x;
+    /* RAND_MAX + 1 is a power of two, the upper bits are the best ones */
+    return (int) (((x * 0x2545F4914F6CDD1DULL) >> 32) % ((unsigned long long) RAND_MAX + 1));
+}
+
+/**
+ * Initializes the state of a generator (splitmix64 of the seed, so close seeds give unrelated sequences)
+ * @param state state of the generator
+ * @param seed any value
+ */
+void randomSeed(unsigned long long *state, unsigned long long seed) {
+    unsigned long long z = seed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    /* zero state would generate only zeros */
+    *state = z ? z : 1;
+}
+
+/**
+ * Sets the generator of the calling thread, all the random values of the thread are taken from it
+ * (independent runs of the simulation in the threads of one process)
+ * @param state state initialized by randomSeed or NULL for rand()
+ */
+void randomUseState(unsigned long long *state) {
+    RANDOM_STATE = state;
+}
+
 /**
  * Returns random double from interval <-1, 1>
  * @return double
  */
 double randomDouble() {
-    return (double) rand() / RAND_MAX * 2 - 1;
+    return (double) randomNext() / RAND_MAX * 2 - 1;
 }
 
 /**
@@ -49,6 +94,52 @@ int randomGaussian(GaussRandom *randomPointer, double *doublePointer) {
 
 }
 
+/**
+ * Returns binomially distributed number of successes - exact (waiting times between the successes are geometrically
+ * distributed) if the expected number of the successes is smaller than BINOMIAL_EXACT_MEAN, from the normal
+ * approximation otherwise, so one number costs at most BINOMIAL_EXACT_MEAN random values
+ * @param trials number of the trials
+ * @param probability probability of the success of one trial
+ * @return number of the successes from interval <0, trials>
+ */
+int randomBinomial(int trials, double probability) {
+    double v1;
+    double v2;
+    double s;
+    double mean;
+    double logFailure;
+    double trial;
+    int successes;
+
+    if (trials <= 0 || probability <= 0) return 0;
+    if (probability >= 1) return trials;
+    //fewer successes are drawn faster
+    if (probability > 0.5) return trials - randomBinomial(trials, 1 - probability);
+
+    mean = trials * probability;
+    if (mean < BINOMIAL_EXACT_MEAN) {
+        logFailure = log(1 - probability);
+        successes = -1;
+        trial = 0;
+        do {
+            successes++;
+            //uniform value from interval (0, 1)
+            trial += ceil(log((randomNext() + 1.0) / (RAND_MAX + 2.0)) / logFailure);
+        } while (trial <= trials);
+        return successes;
+    }
+
+    do {
+        v1 = randomDouble();
+        v2 = randomDouble();
+        s = (v1 * v1) + (v2 * v2);
+    } while (s >= 1 || s == 0);
+    successes = (int) floor(mean + v1 * sqrt(-2 * log(s) / s) * sqrt(mean * (1 - probability)) + 0.5);
+    if (successes < 0) return 0;
+    if (successes > trials) return trials;
+    return successes;
+}
+
 /**
  * Returns normally distributed value with mean and standard deviation specified
  * by attributes of @param randomPointer
@@ -98,8 +189,8 @@ int nextNormalDistDoubleFaster(GaussRandom *randomPointer, double *doublePointer
     }
 
     do {
-        value1 = (double) rand() * stupidName - 1;
-        value2 = (double) rand() * stupidName - 1;
+        value1 = (double) randomNext() * stupidName - 1;
+        value2 = (double) randomNext() * stupidName - 1;
         s = (value1 * value1) + (value2 * value2);
     } while (s >= 1 || s == 0);
     multiplier = sqrt(-2 * log(s) / s) * randomPointer->stdDev;
@@ -5,7 +5,10 @@
 #ifndef FEM_LIKE_SPREADING_MODELLING_RANDOM_H
 #define FEM_LIKE_SPREADING_MODELLING_RANDOM_H
 
-#define stupidName 0.000061037018951994385
+/* scales randomNext() to <0, 2> (RAND_MAX is 32767 on Windows, 2^31 - 1 with glibc) */
+#define stupidName (2.0 / RAND_MAX)
+/* binomial numbers with a bigger mean are drawn from the normal approximation */
+#define BINOMIAL_EXACT_MEAN 30
 
 typedef  struct {
     char hasNextValue;
@@ -16,8 +19,16 @@ typedef  struct {
 
 double randomDouble();
 
+int randomNext();
+
+void randomSeed(unsigned long long *state, unsigned long long seed);
+
+void randomUseState(unsigned long long *state);
+
 int randomGaussian(GaussRandom  *randomPointer, double *doublePointer);
 
+int randomBinomial(int trials, double probability);
+
 int nextNormalDistDouble(GaussRandom  *randomPointer, double *doublePointer);
 
 int nextNormalDistDoubleFaster(GaussRandom  *randomPointer, double *doublePointer);
@@ -0,0 +1,193 @@
+/**
+ * This module contains the what-if scenarios of the running simulation - the server requests a scenario
+ * (fork_scenario command) with its own parameters, the simulation thread copies its state at the end of the day
+ * and the scenario continues from there in its own thread for the requested number of days. Days before the fork
+ * are not copied, the scenario shares them with the main simulation (its frame store and statistics contain only
+ * the days after the fork).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "scenario.h"
+#include "fileManager.h"
+
+/* requested scenarios, index is the id (0 is the main simulation), written only under SCENARIOS_LOCK */
+static scenario *_Atomic SCENARIOS[SCENARIO_MAX + 1];
+static int SCENARIO_COUNT = 0;
+static pthread_mutex_t SCENARIOS_LOCK = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Requests a new scenario, the simulation forks it at the end of the current day (scenarioForkRequested)
+ * @param name name of the scenario (longer names are truncated)
+ * @param params parameters of the scenario
+ * @param days number of the days simulated after the fork (greater than 0)
+ * @return id of the scenario or -1 if there are already SCENARIO_MAX scenarios or it is not possible to
+ *         allocate memory
+ */
+int scenarioRequest(const char *name, parameters *params, int days) {
+    scenario *theScenario;
+    int id;
+
+    if (!name || !params || days <= 0) return -1;
+    theScenario = calloc(1, sizeof(scenario));
+    if (!theScenario) return -1;
+    strncpy(theScenario->name, name, SCENARIO_NAME_LENGTH - 1);
+    theScenario->params = *params;
+    theScenario->days = days;
+    atomic_init(&theScenario->forkDay, -1);
+
+    pthread_mutex_lock(&SCENARIOS_LOCK);
+    if (SCENARIO_COUNT == SCENARIO_MAX) {
+        pthread_mutex_unlock(&SCENARIOS_LOCK);
+        free(theScenario);
+        return -1;
+    }
+    id = theScenario->id = ++SCENARIO_COUNT;
+    atomic_store(&SCENARIOS[id], theScenario);
+    pthread_mutex_unlock(&SCENARIOS_LOCK);
+    return id;
+}
+
+/**
+ * Frees the state of the thread of the scenario and its copy of the country (the frame store, the ring
+ * and the statistics are left to the readers)
+ * @param theScenario scenario
+ */
+static void freeScenarioState(scenario *theScenario) {
+    freeCountry(&theScenario->ctry);
+    freeRandom(&theScenario->moveRandom);
+    freeRandom(&theScenario->spreadRandom);
+    free(theScenario->population);
+    free(theScenario->infected);
+    theScenario->population = NULL;
+    theScenario->infected = NULL;
+}
+
+/**
+ * Loop of the thread of the scenario - simulates the days after the fork and publishes them (frame store,
+ * ring, statistics) like the main simulation, the thread ends after the last of the days of the scenario
+ * @param args scenario
+ * @return NULL
+ */
+static void *scenarioLoop(void *args) {
+    scenario *theScenario = args;
+    unsigned long long state;
+    int date, fork = atomic_load(&theScenario->forkDay);
+
+    /* every scenario has its own generator, rand() is left to the main simulation */
+    randomSeed(&state, (unsigned long long) time(NULL) * (SCENARIO_MAX + 1) + theScenario->id);
+    randomUseState(&state);
+
+    for (date = fork + 1; date <= fork + theScenario->days; date++) {
+        TRACE_BEGIN_VALUE("scenario_day", date);
+        simulateDay(theScenario->ctry, theScenario->moveRandom, theScenario->spreadRandom);
+        snapshotCountry(theScenario->ctry, theScenario->population, theScenario->infected);
+        frameStoreAppend(theScenario->store, date, theScenario->population, theScenario->infected);
+        frameRingPublish(theScenario->ring, date, theScenario->population, theScenario->infected);
+        statisticsAdd(theScenario->stats, date, theScenario->population, theScenario->infected,
+                      theScenario->ctry->newInfected, theScenario->ctry->recovered, theScenario->ctry->deaths);
+        notifyNewFrame();
+        TRACE_END("scenario_day");
+        if (TRACE_ENABLED) traceFlush();
+    }
+    printf("Scenario %d (%s) finished on day %d.\n", theScenario->id, theScenario->name, date - 1);
+    freeScenarioState(theScenario);
+    return NULL;
+}
+
+/**
+ * Forks the scenario from the country - copies the state and starts the thread of the scenario
+ * @param theScenario requested scenario
+ * @param theCountry country of the main simulation
+ * @param date last simulated day of the country
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+static int forkScenario(scenario *theScenario, country *theCountry, int date) {
+    char dataPath[SCENARIO_PATH_LENGTH], indexPath[SCENARIO_PATH_LENGTH];
+    int *cityIds, i;
+
+    theScenario->ctry = cloneCountry(theCountry);
+    if (!theScenario->ctry) return EXIT_FAILURE;
+    theScenario->ctry->params = theScenario->params;
+
+    cityIds = malloc(theCountry->numberOfCities * sizeof(int));
+    if (!cityIds) return EXIT_FAILURE;
+    for (i = 0; i < theCountry->numberOfCities; i++) cityIds[i] = theCountry->cities[i]->city_id;
+    sprintf(dataPath, SCENARIO_STORE_FORMAT, theScenario->id);
+    sprintf(indexPath, SCENARIO_INDEX_FORMAT, theScenario->id);
+    theScenario->store = createFrameStore(dataPath, indexPath, cityIds, theCountry->numberOfCities);
+    free(cityIds);
+
+    theScenario->ring = createFrameRing(theCountry->numberOfCities);
+    theScenario->stats = create_statistics_from_country(theCountry);
+    theScenario->moveRandom = createRandom(theScenario->params.moveMean, theScenario->params.moveStdDev);
+    theScenario->spreadRandom = createRandom(theScenario->params.spreadMean, theScenario->params.spreadStdDev);
+    theScenario->population = malloc(theCountry->numberOfCities * sizeof(int));
+    theScenario->infected = malloc(theCountry->numberOfCities * sizeof(int));
+    if (!theScenario->store || !theScenario->ring || !theScenario->stats || !theScenario->moveRandom ||
+        !theScenario->spreadRandom || !theScenario->population || !theScenario->infected)
+        return EXIT_FAILURE;
+
+    /* readers may use the store, the ring and the stats from now on (the scenario has only the shared days
+       and is marked as failed if the thread can't be started) */
+    atomic_store(&theScenario->forkDay, date);
+    if (pthread_create(&theScenario->thread, NULL, scenarioLoop, theScenario)) return EXIT_FAILURE;
+    pthread_detach(theScenario->thread);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Forks all the requested scenarios which were not forked yet, called by the main simulation between the days
+ * (scenarios which can't be forked are marked as failed)
+ * @param theCountry country of the main simulation
+ * @param date last simulated day of the country
+ */
+void scenarioForkRequested(country *theCountry, int date) {
+    scenario *theScenario;
+    int id, count;
+
+    if (!theCountry) return;
+    pthread_mutex_lock(&SCENARIOS_LOCK);
+    count = SCENARIO_COUNT;
+    pthread_mutex_unlock(&SCENARIOS_LOCK);
+
+    for (id = 1; id <= count; id++) {
+        theScenario = atomic_load(&SCENARIOS[id]);
+        if (atomic_load(&theScenario->forkDay) >= 0 || atomic_load(&theScenario->failed)) continue;
+
+        if (forkScenario(theScenario, theCountry, date) == EXIT_SUCCESS) {
+            printf("Forked scenario %d (%s) from day %d.\n", id, theScenario->name, date);
+            continue;
+        }
+        fprintf(stderr, "Error: Could not fork scenario %d (%s)\n", id, theScenario->name);
+        atomic_store(&theScenario->failed, 1);
+        freeScenarioState(theScenario);
+        if (atomic_load(&theScenario->forkDay) >= 0) continue;
+        freeFrameStore(&theScenario->store);
+        freeFrameRing(&theScenario->ring);
+        freeStatistics(&theScenario->stats);
+    }
+}
+
+/**
+ * Returns the scenario
+ * @param id id of the scenario
+ * @return pointer to the scenario (not forked yet if its forkDay is -1) or NULL if there is no such scenario
+ */
+scenario *scenarioGet(int id) {
+    if (id < 1 || id > SCENARIO_MAX) return NULL;
+    return atomic_load(&SCENARIOS[id]);
+}
+
+/**
+ * Returns the number of the requested scenarios
+ * @return number of the scenarios (ids are 1 .. count)
+ */
+int scenarioCount() {
+    int count;
+    pthread_mutex_lock(&SCENARIOS_LOCK);
+    count = SCENARIO_COUNT;
+    pthread_mutex_unlock(&SCENARIOS_LOCK);
+    return count;
+}
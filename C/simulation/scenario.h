@@ -0,0 +1,53 @@
+#ifndef FEM_LIKE_SPREADING_MODELLING_SCENARIO_H
+#define FEM_LIKE_SPREADING_MODELLING_SCENARIO_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "simulation.h"
+#include "frameStore.h"
+
+/* maximum number of the scenarios, ids are 1 .. SCENARIO_MAX (0 is the main simulation) */
+#define SCENARIO_MAX 8
+#define SCENARIO_NAME_LENGTH 32
+/* frames of the scenario (only the days after the fork, older days are the frames of the main simulation) */
+#define SCENARIO_STORE_FORMAT "./DATA/sim_frames/scenario%02d.dat"
+#define SCENARIO_INDEX_FORMAT "./DATA/sim_frames/scenario%02d.idx"
+#define SCENARIO_PATH_LENGTH 64
+/* days simulated by the scenario after its fork if no other number is requested, the thread of the scenario
+   ends after its last day (scenarios are not paced, every day of them takes the CPU from the main simulation) */
+#define SCENARIO_DEF_DAYS 365
+
+/**
+ * What-if branch of the running simulation - copy of the state of the main simulation at the end of forkDay,
+ * simulated by its own thread with its own parameters
+ * name and params are set when the scenario is requested, the rest by the simulation when it forks it
+ */
+typedef struct {
+    int id;
+    char name[SCENARIO_NAME_LENGTH];
+    parameters params;
+    /* number of the days simulated after the fork */
+    int days;
+    /* day of the main simulation the scenario continues from, -1 until the simulation forks it
+       (store, ring and stats are published before the day) */
+    atomic_int forkDay;
+    /* the scenario could not be forked (not enough memory) */
+    atomic_char failed;
+    country *ctry;
+    frameStore *store;
+    frameRing *ring;
+    statistics *stats;
+    /* state of the thread of the scenario, allocated by the fork */
+    GaussRandom *moveRandom;
+    GaussRandom *spreadRandom;
+    int *population;
+    int *infected;
+    pthread_t thread;
+} scenario;
+
+int scenarioRequest(const char *name, parameters *params, int days);
+void scenarioForkRequested(country *theCountry, int date);
+scenario *scenarioGet(int id);
+int scenarioCount();
+
+#endif //FEM_LIKE_SPREADING_MODELLING_SCENARIO_H
@@ -4,9 +4,15 @@
 #include <stdio.h>
 #include <time.h>
 #include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <assert.h>
+#include <unistd.h>
 #include "simulation.h"
 #include "random.h"
 #include "fileManager.h"
+#include "frameStore.h"
+#include "scenario.h"
 
 #ifndef M_PI
 #    define M_PI 3.14159265358979323846
@@ -14,19 +20,20 @@
 
 #define radians(degrees) (degrees) * (M_PI / 180.0)
 
-double MOVE_STD_DEV;
-double MOVE_MEAN;
-double MEETING_FACTOR;
-int INFECTION_TIME_MEAN;
-int INFECTION_TIME_STD_DEV;
-int IMMUNITY_TIME_MEAN;
-int IMMUNITY_TIME_STD_DEV;
-double MOVING_CITIZENS;
-double SPREAD_MEAN;
-double SPREAD_STD_DEV;
-double DEATH_THRESHOLD;
-double GO_BACK_THRESHOLD_HIGH;
-double GO_BACK_THRESHOLD_LOW;
+frameRing *_Atomic FRAME_RING = NULL;
+int FRAME_NOTIFY_FD = -1;
+statistics *_Atomic STATISTICS = NULL;
+spatialGrid *_Atomic SPATIAL_GRID = NULL;
+
+/**
+ * Wakes up the listener of FRAME_NOTIFY_FD (the server), a new day was published
+ */
+void notifyNewFrame() {
+    uint64_t one = 1;
+    if (FRAME_NOTIFY_FD < 0) return;
+    /* counter of the eventfd just grows if nobody reads it, the listener reads the latest day from the ring */
+    if (write(FRAME_NOTIFY_FD, &one, sizeof(one)) < 0) return;
+}
 
 /**
  * Simulates a day of the simulation (one step is one hour of "real time")
@@ -39,43 +46,101 @@ double GO_BACK_THRESHOLD_LOW;
  */
 void simulateDay(country *theCountry, GaussRandom *theGaussRandom, GaussRandom *theSpreadRandom) {
     int hour;
+    metricSample sample;
+    theCountry->newInfected = 0;
+    theCountry->recovered = 0;
+    theCountry->deaths = 0;
     for (hour = 0; hour < 24; hour++) {
+        TRACE_BEGIN_VALUE("hour", hour);
         simulationStep(theCountry, theGaussRandom, theSpreadRandom);
-        if ((hour + 1) % 8 == 0) goBackHome(theCountry, GO_BACK_THRESHOLD_HIGH);
-        else goBackHome(theCountry, GO_BACK_THRESHOLD_LOW);
+        TRACE_BEGIN("return_home");
+        metricsBegin(&sample);
+        if ((hour + 1) % 8 == 0) goBackHome(theCountry, theCountry->params.goBackThresholdHigh);
+        else goBackHome(theCountry, theCountry->params.goBackThresholdLow);
+        metricsEnd(METRIC_RETURN_HOME, &sample);
+        TRACE_END("return_home");
+        TRACE_END("hour");
+    }
+    TRACE_BEGIN("status_update");
+    metricsBegin(&sample);
+    if (updateCitizenStatuses(theCountry) == EXIT_FAILURE)
+        fprintf(stderr, "Error: statuses of the citizens could not be updated (out of memory)\n");
+    updateDormantCities(theCountry);
+    metricsEnd(METRIC_STATUS_UPDATE, &sample);
+    TRACE_END("status_update");
+}
+
+/**
+ * Kills the infected citizens of the city which die today - their number is drawn from the binomial distribution
+ * (deathThreshold is the probability of death of every infected citizen), then they are sampled from the infected
+ * citizens (partial Fisher-Yates shuffle of their positions), their positions in the lists are cleared, the lists
+ * have to be compacted by hashTableCompact
+ * @param theCountry country of the city
+ * @param theCity city of the citizens
+ * @param infected positions (in the lists of the city) of the citizens infected at the beginning of the day
+ * @param count number of the positions
+ * @return number of the dead citizens
+ */
+static int killInfected(country *theCountry, city *theCity, void ***infected, int count) {
+    int deaths, chosen, index;
+    void **position;
+    citizen *theCitizen;
+
+    deaths = randomBinomial(count, theCountry->params.deathThreshold);
+    for (chosen = 0; chosen < deaths; chosen++) {
+        index = chosen + (int) ((double) randomNext() / ((double) RAND_MAX + 1) * (count - chosen));
+        position = infected[index];
+        infected[index] = infected[chosen];
+
+        theCitizen = *position;
+        //citizen recovered today, but died first
+        if (theCitizen->status == RECOVERED) {
+            theCity->recovered--;
+            theCountry->recovered--;
+        } else theCity->infected--;
+        theCity->population--;
+        *position = NULL;
+        freeCitizen(&theCitizen);
     }
-    updateCitizenStatuses(theCountry);
+    theCountry->deaths += deaths;
+    return deaths;
 }
 
 /**
  * If the citizen is either infected or cured, their timeFrame gets incremented
- * Every infected citizen has a chance of dying (being removed from the hashTable)
+ * Every infected citizen has a chance of dying, the dead citizens of every city are chosen at once (killInfected)
+ * and removed from the hashTable of the city in one pass
  * If an infected citizen survived 14 days, he becomes cured
  * If cured citizen is recovered for more than 30 days, he becomes infect-able again
  *
  * @param theCountry initialized country
+ * @return EXIT_SUCCESS or EXIT_FAILURE if memory can't be allocated (the statuses of the rest of the cities
+ *         are not updated)
  */
-void updateCitizenStatuses(country *theCountry) {
-    double deathChance;
+int updateCitizenStatuses(country *theCountry) {
     int i, j, k;
+    int count, expected;
+    int capacity = 0;
+    char failed = 0;
     city *theCity;
     arrayList *theList;
     citizen *theCitizen;
+    void ***infected = NULL, ***bigger;
     GaussRandom *infectedRandom;
     GaussRandom *immunityRandom;
     double *randomDate;
 
-    if (!theCountry) return;
+    if (!theCountry) return EXIT_FAILURE;
 
-    infectedRandom = createRandom(INFECTION_TIME_MEAN, INFECTION_TIME_STD_DEV);
+    infectedRandom = createRandom(theCountry->params.infectionTimeMean, theCountry->params.infectionTimeStdDev);
 
-    if (!infectedRandom) return;
+    if (!infectedRandom) return EXIT_FAILURE;
 
-    immunityRandom = createRandom(IMMUNITY_TIME_MEAN, IMMUNITY_TIME_STD_DEV);
+    immunityRandom = createRandom(theCountry->params.immunityTimeMean, theCountry->params.immunityTimeStdDev);
 
     if (!immunityRandom) {
         freeRandom(&infectedRandom);
-        return;
+        return EXIT_FAILURE;
     }
 
     randomDate = malloc(sizeof(double));
@@ -83,59 +148,239 @@ void updateCitizenStatuses(country *theCountry) {
     if (!randomDate) {
         freeRandom(&infectedRandom);
         freeRandom(&immunityRandom);
-        return;
+        return EXIT_FAILURE;
     }
 
 
-    for (i = 0; i < theCountry->numberOfCities; i++) {
+    //only citizens of the cities with infected or recovered citizens change
+    for (i = nextActiveCity(theCountry, 0); i < theCountry->numberOfCities; i = nextActiveCity(theCountry, i + 1)) {
         theCity = theCountry->cities[i];
+        expected = theCity->infected;
+        count = 0;
 
-        for (j = 0; j < theCity->citizens->size; j++) {
+        for (j = 0; j < theCity->citizens->size && !failed; j++) {
             theList = theCity->citizens->array[j];
 
             for (k = 0; k < theList->filledItems; k++) {
                 theCitizen = arrayListGetPointer(theList, k);
-
-                // if citizen is either infected or cured, increment days infected (or cured)
-                if (theCitizen->status != NORMAL) {
-                    theCitizen->timeFrame++;
-
-                    // infected citizen
-                    if (theCitizen->status == INFECTED) {
-
-                        // if the citizen is infected, there is a chance he will die
-                        deathChance = (double) rand() / RAND_MAX;
-                        if (deathChance < DEATH_THRESHOLD) {
-                            hashTableRemoveElement(j, k, theCity->citizens);
-                            freeCitizen(&theCitizen);
-                            theCity->infected--;
-                            theCity->population--;
-                            continue;
-                        }
-
-                        nextNormalDistDouble(infectedRandom, randomDate);
-                        // if the citizen was infected for 14 days, he is cured now
-                        if (theCitizen->timeFrame >= *randomDate) {
-                            theCitizen->status = RECOVERED;
-                            theCity->infected--;
-                            theCitizen->timeFrame = 0;
-                            continue;
+                if (theCitizen->status == NORMAL) continue;
+
+                // citizen is either infected or cured, increment days infected (or cured)
+                theCitizen->timeFrame++;
+
+                // if the citizen was infected for 14 days, he is cured now (unless he dies today)
+                if (theCitizen->status == INFECTED) {
+                    // positions grow with the citizens found, the counter of the city only gives the first guess
+                    if (count == capacity) {
+                        capacity = count < expected ? expected : 2 * capacity + 16;
+                        bigger = realloc(infected, capacity * sizeof(void **));
+                        if (!bigger) {
+                            failed = 1;
+                            break;
                         }
+                        infected = bigger;
                     }
-
-                    // if the citizen is cured for 30 days, he can be re-infected again
-                    nextNormalDistDouble(immunityRandom, randomDate);
-                    if (theCitizen->status == RECOVERED && theCitizen->timeFrame >= *randomDate) {
-                        theCitizen->status = NORMAL;
+                    infected[count++] = &theList->data[k];
+                    nextNormalDistDouble(infectedRandom, randomDate);
+                    if (theCitizen->timeFrame >= *randomDate) {
+                        theCitizen->status = RECOVERED;
+                        theCity->infected--;
+                        theCity->recovered++;
+                        theCountry->recovered++;
                         theCitizen->timeFrame = 0;
                     }
+                    continue;
+                }
+
+                // if the citizen is cured for 30 days, he can be re-infected again
+                nextNormalDistDouble(immunityRandom, randomDate);
+                if (theCitizen->timeFrame >= *randomDate) {
+                    theCitizen->status = NORMAL;
+                    theCitizen->timeFrame = 0;
+                    theCity->recovered--;
                 }
             }
         }
+
+        if (failed) break;
+        // the counter of the city has to match its infected citizens
+        assert(count == expected);
+        // every infected citizen has a chance of dying, all the dead citizens are removed from the lists at once
+        if (killInfected(theCountry, theCity, infected, count) > 0) hashTableCompact(theCity->citizens);
     }
+    free(infected);
     freeRandom(&infectedRandom);
     freeRandom(&immunityRandom);
     free(randomDate);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ * Marks the city as a city with infected or recovered citizens, spread and status update go only through them
+ * @param theCountry country of the city
+ * @param cityIndex index of the city
+ */
+void activateCity(country *theCountry, int cityIndex) {
+    theCountry->activeCities[cityIndex / 64] |= 1ULL << (cityIndex % 64);
+}
+
+/**
+ * Finds the next city with infected or recovered citizens, bits of the cities without them are cleared on the way
+ * (every 64 cities without them are skipped at once)
+ * @param theCountry initialized country
+ * @param cityIndex index of the first city to be checked
+ * @return index of the city or theCountry->numberOfCities if there is no such city
+ */
+int nextActiveCity(country *theCountry, int cityIndex) {
+    int word, words = (theCountry->numberOfCities + 63) / 64;
+    unsigned long long bits;
+    city *theCity;
+
+    if (cityIndex >= theCountry->numberOfCities) return theCountry->numberOfCities;
+    word = cityIndex / 64;
+    bits = theCountry->activeCities[word] & (~0ULL << (cityIndex % 64));
+
+    for (;;) {
+        while (!bits) {
+            if (++word >= words) return theCountry->numberOfCities;
+            bits = theCountry->activeCities[word];
+        }
+        cityIndex = word * 64 + __builtin_ctzll(bits);
+        if (cityIndex >= theCountry->numberOfCities) return theCountry->numberOfCities;
+
+        theCity = theCountry->cities[cityIndex];
+        if (theCity->infected > 0 || theCity->recovered > 0) return cityIndex;
+        theCountry->activeCities[word] &= ~(1ULL << (cityIndex % 64));
+        bits &= bits - 1;
+    }
+}
+
+/**
+ * Checks if the healthy residents coming home to the city are kept only as counts
+ * @param theCountry country of the city
+ * @param theCity city
+ * @return 1 if the city is without infected for at least dormantDays days, 0 otherwise
+ */
+static int isCityQuiet(country *theCountry, city *theCity) {
+    return theCountry->params.dormantDays > 0 && theCity->quietDays >= theCountry->params.dormantDays;
+}
+
+/**
+ * Keeps the resident of the city only as a count (the caller removes the citizen from the hashTable and frees it,
+ * population of the city is not changed)
+ * @param theCity hometown of the citizen
+ * @param id id of the healthy citizen
+ * @return EXIT_SUCCESS or EXIT_FAILURE if it was not possible to allocate memory
+ */
+static int addDormant(city *theCity, int id) {
+    int capacity;
+    int *bigger;
+
+    if (theCity->dormantCount == theCity->dormantCapacity) {
+        capacity = theCity->dormantCapacity ? 2 * theCity->dormantCapacity : 16;
+        bigger = realloc(theCity->dormant, capacity * sizeof(int));
+        if (!bigger) return EXIT_FAILURE;
+        theCity->dormant = bigger;
+        theCity->dormantCapacity = capacity;
+    }
+    theCity->dormant[theCity->dormantCount++] = id;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Creates the citizens of all the residents of the city kept only as counts (healthy, at home)
+ * @param theCity city
+ * @param cityIndex index of the city in the country (hometown of the residents)
+ * @return EXIT_SUCCESS or EXIT_FAILURE if it was not possible to allocate memory
+ */
+int wakeCity(city *theCity, int cityIndex) {
+    citizen *theCitizen;
+
+    if (!theCity) return EXIT_FAILURE;
+
+    while (theCity->dormantCount > 0) {
+        theCitizen = createCitizen(theCity->dormant[theCity->dormantCount - 1], cityIndex);
+        if (!theCitizen) return EXIT_FAILURE;
+        hashTableAddElement(theCitizen, theCitizen->id, theCity->citizens);
+        theCity->dormantCount--;
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Counts the days without infected of every city, healthy residents at home in the cities without infected
+ * for dormantDays days are kept only as counts (they are not scanned every hour until somebody is
+ * infected in the city), called after updateCitizenStatuses
+ *
+ * @param theCountry initialized country
+ */
+void updateDormantCities(country *theCountry) {
+    int i, j, k;
+    city *theCity;
+    arrayList *theList;
+    citizen *theCitizen;
+
+    if (!theCountry) return;
+
+    for (i = 0; i < theCountry->numberOfCities; i++) {
+        theCity = theCountry->cities[i];
+        if (theCity->infected > 0) theCity->quietDays = 0;
+        else if (theCity->quietDays < INT_MAX) theCity->quietDays++;
+        //country which keeps all the citizens (e.g. a scenario of a country with the residents kept as counts)
+        if (!theCountry->params.dormantDays && wakeCity(theCity, i) == EXIT_FAILURE) return;
+        if (!isCityQuiet(theCountry, theCity)) continue;
+
+        for (j = 0; j < theCity->citizens->size; j++) {
+            theList = theCity->citizens->array[j];
+
+            for (k = 0; k < theList->filledItems; k++) {
+                theCitizen = arrayListGetPointer(theList, k);
+                if (theCitizen->status != NORMAL || theCitizen->homeTown != i) continue;
+
+                if (addDormant(theCity, theCitizen->id) == EXIT_FAILURE) return;
+                hashTableRemoveElement(j, k, theCity->citizens);
+                freeCitizen(&theCitizen);
+                k--;
+            }
+        }
+    }
+}
+
+/**
+ * Moves the travelling residents of the city kept only as counts - their number is drawn from the binomial
+ * distribution with the same share of moving citizens as in moveCitizens, they become citizens again and travel
+ * like the other citizens (they are kept as counts again when they come back home, see goBackHome)
+ * Distances from the city have to be computed and sorted (as for moveCitizens)
+ *
+ * @param theCountry initialized country
+ * @param cityIndex index of the city
+ * @param moveRandom gaussRandom struct with initialized mean and standard deviation
+ * @return EXIT_SUCCESS or EXIT_FAILURE if it is not possible to allocate memory
+ */
+int moveDormant(country *theCountry, int cityIndex, GaussRandom *moveRandom) {
+    city *theCity = theCountry->cities[cityIndex], *destination;
+    citizen *theCitizen;
+    double moveDistance;
+    int departing, index;
+
+    departing = randomBinomial(theCity->dormantCount, 1.0 / (int) (1.0 / theCountry->params.movingCitizens));
+    for (; departing > 0; departing--) {
+        theCitizen = createCitizen(theCity->dormant[theCity->dormantCount - 1], cityIndex);
+        if (!theCitizen || nextNormalDistDouble(moveRandom, &moveDistance) == EXIT_FAILURE) {
+            freeCitizen(&theCitizen);
+            return EXIT_FAILURE;
+        }
+        theCity->dormantCount--;
+        //the citizen doesn't move again in this step
+        theCountry->movedCitizens[theCitizen->id] = 1;
+
+        index = interpolationSearch(ABS(moveDistance), theCountry->numberOfCities, theCountry->distances);
+        destination = theCountry->cities[theCountry->distances[index]->id];
+        hashTableAddElement(theCitizen, theCitizen->id, destination->citizens);
+        theCity->population--;
+        destination->population++;
+    }
+    return EXIT_SUCCESS;
 }
 
 /** This function is one step of simulation where the citizens are moving between different cities
@@ -148,23 +393,37 @@ void updateCitizenStatuses(country *theCountry) {
 int simulationStep(country *theCountry, GaussRandom *theMoveRandom, GaussRandom *theSpreadRandom) {
     int i;
     city *theCity;
+    metricSample sample;
 
     if (!theCountry || !theMoveRandom || !theSpreadRandom) return EXIT_FAILURE;
 
+    TRACE_BEGIN("movement");
+    metricsBegin(&sample);
     memset(theCountry->movedCitizens, 0, theCountry->movedCitizensLength * sizeof(char));
     int startIndex = 0;
 
     //go through all cities
     for (i = 0; i < theCountry->numberOfCities; i++) {
         theCity = theCountry->cities[i];
+        if (!theCity->citizens->filledItems && !theCity->dormantCount) continue;
         computeDistances(i, theCountry);
         qsort(theCountry->distances, theCountry->numberOfCities, sizeof(cityDistance *), cmpCitiesByDistance);
 
         startIndex = moveCitizens(theCountry, theCity, theMoveRandom, startIndex);
-        if (startIndex == -1) return EXIT_FAILURE;
+        //residents kept as counts travel as well (after the citizens, so they are not moved twice)
+        if (startIndex == -1 || moveDormant(theCountry, i, theMoveRandom) == EXIT_FAILURE) {
+            TRACE_END("movement");
+            return EXIT_FAILURE;
+        }
     }
+    metricsEnd(METRIC_MOVEMENT, &sample);
+    TRACE_END("movement");
 
+    TRACE_BEGIN("spread");
+    metricsBegin(&sample);
     spreadPhenomenon(theCountry, theSpreadRandom);
+    metricsEnd(METRIC_SPREAD, &sample);
+    TRACE_END("spread");
 
     return EXIT_SUCCESS;
 }
@@ -191,10 +450,12 @@ int spreadPhenomenon(country *theCountry, GaussRandom *spreadRandom) {
     spreadChance = malloc(sizeof(double));
     if (!spreadChance) return EXIT_FAILURE;
 
-    for (i = 0; i < theCountry->numberOfCities; i++) {
+    //nobody is infected in the cities without infected citizens
+    for (i = nextActiveCity(theCountry, 0); i < theCountry->numberOfCities; i = nextActiveCity(theCountry, i + 1)) {
         theCity = theCountry->cities[i];
         populationDensity = (double) theCity->population / theCity->area;
         toInfect = 0;
+        if (theCity->infected > 0) theCity->quietDays = 0;
 
         //compute how many people will be infected in this city
         for (j = 0; j < theCity->infected; j++) {
@@ -203,10 +464,16 @@ int spreadPhenomenon(country *theCountry, GaussRandom *spreadRandom) {
                 nextNormalDistDouble(spreadRandom, spreadChance);
             } while (*spreadChance < 0 || *spreadChance > 1);
 
-            toInfect += (int)(*spreadChance * populationDensity * MEETING_FACTOR);
+            toInfect += (int)(*spreadChance * populationDensity * theCountry->params.meetingFactor);
         }
 
-        infectCitizensInCity(theCity, toInfect);
+        //residents kept as counts have to be citizens again before they can be infected
+        if (toInfect > 0 && wakeCity(theCity, i) == EXIT_FAILURE) {
+            free(spreadChance);
+            return EXIT_FAILURE;
+        }
+
+        infectCitizensInCity(theCountry, theCity, toInfect);
     }
 
     free(spreadChance);
@@ -215,10 +482,11 @@ int spreadPhenomenon(country *theCountry, GaussRandom *spreadRandom) {
 
 /**
  * Function performs infecting of citizens in selected city
+ * @param theCountry country of the city (counts newly infected citizens)
  * @param theCity where citizens will be infected
  * @param toInfect total number of citizens to be infected
  */
-void infectCitizensInCity(city *theCity, int toInfect) {
+void infectCitizensInCity(country *theCountry, city *theCity, int toInfect) {
     int i;
     int listIndex;
     int maxListIndex;
@@ -227,9 +495,9 @@ void infectCitizensInCity(city *theCity, int toInfect) {
     if (!theCity || toInfect < 0) return;
 
     for (i = 0; i < toInfect; i++) {
-        listIndex = (int) ((double) rand() / RAND_MAX) * (theCity->citizens->size - 1);
+        listIndex = (int) ((double) randomNext() / RAND_MAX) * (theCity->citizens->size - 1);
         maxListIndex = theCity->citizens->array[listIndex]->filledItems;
-        citizenIndex = (int) ((double) rand() / RAND_MAX) * (maxListIndex - 1);
+        citizenIndex = (int) ((double) randomNext() / RAND_MAX) * (maxListIndex - 1);
 
         theCitizen = arrayListGetPointer(theCity->citizens->array[listIndex], citizenIndex);
 
@@ -239,11 +507,12 @@ void infectCitizensInCity(city *theCity, int toInfect) {
         theCitizen->status = INFECTED;
         theCitizen->timeFrame = 0;
         theCity->infected++;
+        theCountry->newInfected++;
     }
 }
 
 /**
- * Function preforms moving some percentage (defined by MOVING_CITIZENS of citizens in the country,
+ * Function preforms moving some percentage (defined by movingCitizens in the parameters of the country) of citizens in the country,
  * citizens travel from some city to another randomly selected city
  *
  * @param theCountry initialized country
@@ -268,7 +537,7 @@ int moveCitizens(country *theCountry, city *theCity, GaussRandom *moveRandom, in
     moveDistance = malloc(sizeof(double));
     if (!moveDistance) return -1;
 
-    int moving = (int) (1.0 / MOVING_CITIZENS);
+    int moving = (int) (1.0 / theCountry->params.movingCitizens);
     k = startIndex;
 
     //go through all citizens in a city
@@ -296,11 +565,15 @@ int moveCitizens(country *theCountry, city *theCity, GaussRandom *moveRandom, in
             //todo
             index = theCountry->distances[index]->id;
 
-            //if citizen is infected, counters must be updated
+            //if citizen is infected or recovered, counters must be updated
             if (theCitizen->status == INFECTED) {
                 theCity->infected--;
                 theCountry->cities[index]->infected++;
+            } else if (theCitizen->status == RECOVERED) {
+                theCity->recovered--;
+                theCountry->cities[index]->recovered++;
             }
+            if (theCitizen->status != NORMAL) activateCity(theCountry, index);
 
             //move the citizen from one city to another
             hashTableRemoveElement(j, k, theCity->citizens);
@@ -331,6 +604,7 @@ int goBackHome(country *theCountry, double threshold) {
     int k;
     double returnChance;
     city *theCity;
+    city *home;
     arrayList *theList;
     citizen *theCitizen;
 
@@ -350,20 +624,28 @@ int goBackHome(country *theCountry, double threshold) {
                 if (i != theCitizen->homeTown) {
 
                     //value from <0,1) if smaller than threshold, citizen moves to his hometown
-                    returnChance = (double) rand() / RAND_MAX;
+                    returnChance = (double) randomNext() / RAND_MAX;
                     if (returnChance <= threshold) {
+                        home = theCountry->cities[theCitizen->homeTown];
 
-                        //if citizen is infected, counters must be updated
+                        //if citizen is infected or recovered, counters must be updated
                         if (theCitizen->status == INFECTED) {
                             theCity->infected--;
-                            theCountry->cities[theCitizen->homeTown]->infected++;
+                            home->infected++;
+                        } else if (theCitizen->status == RECOVERED) {
+                            theCity->recovered--;
+                            home->recovered++;
                         }
+                        if (theCitizen->status != NORMAL) activateCity(theCountry, theCitizen->homeTown);
 
-                        //move the citizen from actual city to his hometown
+                        //move the citizen from actual city to his hometown (only as a count if the hometown is quiet)
                         hashTableRemoveElement(j, k, theCity->citizens);
-                        hashTableAddElement(theCitizen, theCitizen->id, theCountry->cities[theCitizen->homeTown]->citizens);
+                        if (theCitizen->status == NORMAL && isCityQuiet(theCountry, home) &&
+                            addDormant(home, theCitizen->id) == EXIT_SUCCESS)
+                            freeCitizen(&theCitizen);
+                        else hashTableAddElement(theCitizen, theCitizen->id, home->citizens);
                         theCity->population--;
-                        theCountry->cities[theCitizen->homeTown]->population++;
+                        home->population++;
                         //one citizen was removed, we need to decrement k, because otherwise
                         // we will skip one item in arrayList
                         k--;
@@ -432,16 +714,136 @@ country *createCountry(int numberOfCities) {
     }
 
     theCountry->distances = calloc(numberOfCities, sizeof(city *));
+    //cities are not known yet, the bits of the cities without infected or recovered are cleared by the first scan
+    theCountry->activeCities = malloc((numberOfCities + 63) / 64 * sizeof(unsigned long long));
+    if (!theCountry->distances || !theCountry->activeCities) {
+        free(theCountry->cities);
+        free(theCountry->distances);
+        free(theCountry->activeCities);
+        free(theCountry);
+        return NULL;
+    }
+    memset(theCountry->activeCities, 0xff, (numberOfCities + 63) / 64 * sizeof(unsigned long long));
 
     for (i = 0; i < numberOfCities; i++) {
         theCountry->distances[i] = createCityDistance();
     }
 
     theCountry->numberOfCities = numberOfCities;
+    theCountry->movedCitizensLength = 0;
+    theCountry->movedCitizens = NULL;
+    theCountry->newInfected = 0;
+    theCountry->recovered = 0;
+    theCountry->deaths = 0;
+    theCountry->params = PARAMETERS;
 
     return theCountry;
 }
 
+/**
+ * Creates new country with the same cities as theCountry and with citizens created from the population and
+ * the infected of the cities (like the country loaded from the csv), citizens of theCountry are not copied
+ * @param theCountry country with the cities (citizens do not have to be created)
+ * @return pointer to the new country or NULL if it wasn't possible to allocate memory
+ */
+country *copyCountry(country *theCountry) {
+    country *copy;
+    city *theCity;
+    citizen *theCitizen;
+    int i, j, citizenIndex = 0;
+
+    if (!theCountry) return NULL;
+    copy = createCountry(theCountry->numberOfCities);
+    if (!copy) return NULL;
+    copy->params = theCountry->params;
+
+    for (i = 0; i < theCountry->numberOfCities; i++) {
+        theCity = theCountry->cities[i];
+        copy->cities[i] = createCity(theCity->city_id, theCity->area, theCity->population, theCity->infected,
+                                     theCity->lat, theCity->lon);
+        if (!copy->cities[i]) {
+            freeCountry(&copy);
+            return NULL;
+        }
+
+        //healthy citizens first, then the infected ones
+        for (j = 0; j < theCity->population; j++) {
+            theCitizen = createCitizen(citizenIndex, i);
+            if (!theCitizen) {
+                freeCountry(&copy);
+                return NULL;
+            }
+            if (j >= theCity->population - theCity->infected) theCitizen->status = INFECTED;
+            hashTableAddElement(theCitizen, citizenIndex, copy->cities[i]->citizens);
+            citizenIndex++;
+        }
+    }
+
+    copy->movedCitizensLength = citizenIndex;
+    copy->movedCitizens = malloc(citizenIndex * sizeof(char));
+    if (!copy->movedCitizens) freeCountry(&copy);
+    return copy;
+}
+
+/**
+ * Creates new country with the same cities, parameters and copies of all the citizens of theCountry (with their
+ * statuses, in the cities where they are now, residents kept as counts stay counts), the simulation of the copy continues independently of theCountry
+ * @param theCountry country with the citizens
+ * @return pointer to the new country or NULL if it wasn't possible to allocate memory
+ */
+country *cloneCountry(country *theCountry) {
+    country *clone;
+    city *theCity;
+    arrayList *theList;
+    citizen *theCitizen, *copy;
+    int i, j, k;
+
+    if (!theCountry) return NULL;
+    clone = createCountry(theCountry->numberOfCities);
+    if (!clone) return NULL;
+    clone->params = theCountry->params;
+
+    for (i = 0; i < theCountry->numberOfCities; i++) {
+        theCity = theCountry->cities[i];
+        //city may be empty now, but it must be created
+        clone->cities[i] = createCity(theCity->city_id, theCity->area, theCity->population > 0 ? theCity->population : 1,
+                                      theCity->infected, theCity->lat, theCity->lon);
+        if (!clone->cities[i]) {
+            freeCountry(&clone);
+            return NULL;
+        }
+        clone->cities[i]->population = theCity->population;
+        clone->cities[i]->recovered = theCity->recovered;
+        clone->cities[i]->quietDays = theCity->quietDays;
+        for (j = 0; j < theCity->dormantCount; j++) {
+            if (addDormant(clone->cities[i], theCity->dormant[j]) == EXIT_FAILURE) {
+                freeCountry(&clone);
+                return NULL;
+            }
+        }
+
+        for (j = 0; j < theCity->citizens->size; j++) {
+            theList = theCity->citizens->array[j];
+            for (k = 0; k < theList->filledItems; k++) {
+                theCitizen = arrayListGetPointer(theList, k);
+                copy = createCitizen(theCitizen->id, theCitizen->homeTown);
+                if (!copy) {
+                    freeCountry(&clone);
+                    return NULL;
+                }
+                copy->status = theCitizen->status;
+                copy->timeFrame = theCitizen->timeFrame;
+                hashTableAddElement(copy, copy->id, clone->cities[i]->citizens);
+            }
+        }
+    }
+
+    clone->movedCitizensLength = theCountry->movedCitizensLength;
+    clone->movedCitizens = malloc(clone->movedCitizensLength * sizeof(char));
+    if (!clone->movedCitizens) freeCountry(&clone);
+    return clone;
+}
+
 /**
  * Creates new city specified by parameters
  * @param city_id unique identifier, must be non-negative
@@ -457,7 +859,8 @@ city *createCity(int city_id, double area, int population, int infected, double
     theCity = calloc(1, sizeof(city));
     if (!theCity) return NULL;
 
-    theCity->citizens = createHashTable(population / 500, sizeof(citizen *));
+    /* one list per 500 citizens, most of the cities are villages with a single list */
+    theCity->citizens = createHashTable(population / 500 + 1, sizeof(citizen *));
     if (!theCity->citizens) {
         free(theCity);
         return NULL;
@@ -469,6 +872,7 @@ city *createCity(int city_id, double area, int population, int infected, double
     theCity->infected = infected;
     theCity->lat = lat;
     theCity->lon = lon;
+    theCity->quietDays = infected > 0 ? 0 : INT_MAX;
 
     return theCity;
 }
@@ -510,6 +914,7 @@ void freeCountry(country **theCountry) {
     free((*theCountry)->cities);
     free((*theCountry)->distances);
     free((*theCountry)->movedCitizens);
+    free((*theCountry)->activeCities);
     free(*theCountry);
     *theCountry = NULL;
 }
@@ -522,6 +927,7 @@ void freeCity(city **theCity) {
     if (!theCity || !*theCity) return;
 
     freeHashTable(&(*theCity)->citizens);
+    free((*theCity)->dormant);
     free(*theCity);
     *theCity = NULL;
 }
@@ -637,6 +1043,22 @@ int cmpCitiesByDistance(const void *a, const void *b) {
     return (*(cityDistance **) a)->distance < (*(cityDistance **) b)->distance ? -1 : 1;
 }
 
+/**
+ * Copies counters of all the cities into arrays (in order of theCountry->cities)
+ * @param theCountry initialized country
+ * @param population array of theCountry->numberOfCities ints
+ * @param infected array of theCountry->numberOfCities ints
+ */
+void snapshotCountry(country *theCountry, int *population, int *infected) {
+    int i;
+    if (!theCountry || !population || !infected) return;
+
+    for (i = 0; i < theCountry->numberOfCities; i++) {
+        population[i] = theCountry->cities[i]->population;
+        infected[i] = theCountry->cities[i]->infected;
+    }
+}
+
 /**
  * @brief Initializes mandatory structs and starts the simulation, looping indefinetely
  *        This function is possible to be passed as an argument to pthread_create()
@@ -647,17 +1069,29 @@ int cmpCitiesByDistance(const void *a, const void *b) {
 void *start_and_loop(void * args) {
     FILE *fp = NULL;
     country *ctry = NULL;
-    clock_t start, end;
+    frameStore *store = NULL;
+    frameRing *ring = NULL;
+    statistics *stats = NULL;
+    citySeries *series = NULL;
+    int day;
+    int *population = NULL, *infected = NULL;
+    metricSample sample, daySample;
+    long long start, end;
     int date = 0;
 
+    /* every country gets a copy of the parameters when it is created */
+    if (load_parameters(PARAMETERS_FILE) == EXIT_FAILURE) {
+        fprintf(stderr, "Error: Could not load parameters from parameters.cfg file\n");
+        return NULL;
+    }
     fp = fopen(SAVE_FILEPATH, "rb");
     if (fp) {
         fclose(fp);
         ctry = create_country_from_csv(SIMULATION_INI_CSV, 0);
-        start = clock();
+        start = metricsNow();
         date = load_state(&ctry) + 1;
-        end = clock();
-        printf("Loaded state from frame %d successfully in %f sec.\n", date - 1, ((double)(end-start))/CLOCKS_PER_SEC);
+        end = metricsNow();
+        printf("Loaded state from frame %d successfully in %f sec.\n", date - 1, (end - start) / 1e9);
     }
     else {
         ctry = create_country_from_csv(SIMULATION_INI_CSV, 1);
@@ -669,27 +1103,63 @@ void *start_and_loop(void * args) {
         fprintf(stderr, "Error: Could not create country from ini csv file\n");
         return NULL;
     }
-    if (load_parameters(PARAMETERS_FILE) == EXIT_FAILURE) {
-        fprintf(stderr, "Error: Could not load parameters from parameters.cfg file\n");
+    store = create_frame_store_from_country(ctry, FRAME_STORE_FILEPATH, FRAME_INDEX_FILEPATH, date > 0);
+    population = malloc(ctry->numberOfCities * sizeof(int));
+    infected = malloc(ctry->numberOfCities * sizeof(int));
+    if (!store || !population || !infected) {
+        fprintf(stderr, "Error: Could not open frame store %s\n", FRAME_STORE_FILEPATH);
         return NULL;
     }
-    GaussRandom *moveRandom = createRandom(MOVE_MEAN, MOVE_STD_DEV);
-    GaussRandom *spreadRandom = createRandom(SPREAD_MEAN, SPREAD_STD_DEV);
-
-    /* filename: frameXXXX.csv = 13+1 chars = 14 (+1 = null term.) */
-    char filename[40] = {0};
+    /* without the ring, all the frames are served from the store */
+    ring = createFrameRing(ctry->numberOfCities);
+    atomic_store(&FRAME_RING, ring);
+
+    /* aggregates of the days before resuming are computed from the store (counters of the days are not known) */
+    stats = create_statistics_from_country(ctry);
+    for (day = 0; stats && day < date; day++)
+        if (frameStoreReadFrame(store, day, population, infected) == EXIT_SUCCESS)
+            statisticsAdd(stats, day, population, infected, STATISTICS_UNKNOWN, STATISTICS_UNKNOWN, STATISTICS_UNKNOWN);
+    atomic_store(&STATISTICS, stats);
+    atomic_store(&SPATIAL_GRID, create_spatial_grid_from_country(ctry));
+
+    /* days appended to the frame store after the last written days of the series are transposed again */
+    series = create_city_series_from_country(ctry, date > 0);
+    for (day = series ? series->days : date; day < date; day++)
+        if (frameStoreReadFrame(store, day, population, infected) == EXIT_SUCCESS)
+            citySeriesAdd(series, day, population, infected);
+    /* hardware counters of the phases are collected for this thread (the phases run on it) */
+    if (PERF_COUNTERS_ENABLED && !perfCountersOpen())
+        printf("Warning: hardware counters are not available, only wall-clock time is measured.\n");
+    GaussRandom *moveRandom = createRandom(ctry->params.moveMean, ctry->params.moveStdDev);
+    GaussRandom *spreadRandom = createRandom(ctry->params.spreadMean, ctry->params.spreadStdDev);
 
     for(;; date++) {
-        start = clock();
+        TRACE_BEGIN_VALUE("day", date);
+        metricsBegin(&daySample);
 
-        sprintf(filename, CSV_NAME_FORMAT, date);
         simulateDay(ctry, moveRandom, spreadRandom);
-        create_csv_from_country(ctry, filename, date);
-
-        end = clock();
-        printf("Loop %i done in %f sec.\n",date, ((double)(end-start))/CLOCKS_PER_SEC);
-        save_state(ctry, date);
+        TRACE_BEGIN("frame_write");
+        metricsBegin(&sample);
+        snapshotCountry(ctry, population, infected);
+        frameStoreAppend(store, date, population, infected);
+        frameRingPublish(ring, date, population, infected);
+        statisticsAdd(stats, date, population, infected, ctry->newInfected, ctry->recovered, ctry->deaths);
+        citySeriesAdd(series, date, population, infected);
+        notifyNewFrame();
+        metricsEnd(METRIC_FRAME_WRITE, &sample);
+        TRACE_END("frame_write");
+        /* what-if scenarios requested during the day continue from its end */
+        scenarioForkRequested(ctry, date);
+
+        printf("Loop %i done in %f sec.\n", date, (metricsNow() - daySample.time) / 1e9);
+        TRACE_BEGIN("checkpoint");
+        metricsBegin(&sample);
+        save_state(ctry, date, SAVE_FILEPATH);
+        metricsEnd(METRIC_CHECKPOINT, &sample);
+        metricsEnd(METRIC_DAY, &daySample);
+        TRACE_END("checkpoint");
+        TRACE_END("day");
         printf("Saved current state successfully.\n");
+        if (TRACE_ENABLED) traceFlush();
     }
-}
-
+}
\ No newline at end of file
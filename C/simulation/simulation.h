@@ -3,6 +3,12 @@
 
 #include "hashTable.h"
 #include "random.h"
+#include "frameRing.h"
+#include "statistics.h"
+#include "spatialGrid.h"
+#include "metrics.h"
+#include "trace.h"
+#include "parameters.h"
 
 
 #define NORMAL 1
@@ -24,8 +30,16 @@ typedef struct {
     int city_id;
     int population;
     int infected;
+    /* recovered citizens in the city now */
+    int recovered;
     double area;
     hashTable *citizens;
+    /* ids of the residents kept only as counts (healthy, at home in a quiet city), they are part of the population */
+    int *dormant;
+    int dormantCount;
+    int dormantCapacity;
+    /* days without infected in the city, INT_MAX if the city had no infected from the start */
+    int quietDays;
 }city;
 
 typedef struct {
@@ -39,6 +53,15 @@ typedef struct {
     int numberOfCities;
     int movedCitizensLength;
     char *movedCitizens;
+    /* bit of every city which may have infected or recovered citizens, set when they come to the city,
+       cleared by nextActiveCity when they are gone (all the bits are set in a new country) */
+    unsigned long long *activeCities;
+    /* counters of the current day, updated whenever the status of a citizen changes */
+    int newInfected;
+    int recovered;
+    int deaths;
+    /* parameters of the run, a copy of PARAMETERS when the country is created */
+    parameters params;
 }country;
 
 
@@ -52,25 +75,43 @@ void freeCityDistance(cityDistance **theCityDistance);
 int interpolationSearch(double distance, int citiesSize, cityDistance **cityDistances);
 void computeDistances(int cityIndex, country *theCountry);
 void simulateDay(country *theCountry, GaussRandom *theGaussRandom, GaussRandom *theSpreadRandom);
-void updateCitizenStatuses(country *theCountry);
+int updateCitizenStatuses(country *theCountry);
+void updateDormantCities(country *theCountry);
+void activateCity(country *theCountry, int cityIndex);
+int nextActiveCity(country *theCountry, int cityIndex);
+int wakeCity(city *theCity, int cityIndex);
 
 int simulationStep(country *theCountry, GaussRandom *theMoveRandom, GaussRandom *theSpreadRandom);
 int goBackHome(country *theCountry, double threshold);
 int moveCitizens(country *theCountry, city *theCity, GaussRandom *moveRandom, int startIndex);
+int moveDormant(country *theCountry, int cityIndex, GaussRandom *moveRandom);
 
 int spreadPhenomenon(country *theCountry, GaussRandom *spreadRandom);
-void infectCitizensInCity(city *theCity, int toInfect);
+void infectCitizensInCity(country *theCountry, city *theCity, int toInfect);
 
 
 country *createCountry(int numberOfCities);
+country *copyCountry(country *theCountry);
+country *cloneCountry(country *theCountry);
 city *createCity(int city_id, double area, int population, int infected, double lat, double lon);
 
 citizen *createCitizen(int id, int homeTown);
 void freeCountry(country **theCountry);
 void freeCity(city **theCity);
 void freeCitizen(citizen **theCitizen);
+void snapshotCountry(country *theCountry, int *population, int *infected);
 
 
+/* the last frames of the running simulation, published by start_and_loop (NULL until the simulation starts) */
+extern frameRing *_Atomic FRAME_RING;
+/* eventfd (or pipe) the simulation writes into after every published day, -1 if nobody listens */
+extern int FRAME_NOTIFY_FD;
+/* aggregates of the days of the running simulation, published by start_and_loop (NULL until the simulation starts) */
+extern statistics *_Atomic STATISTICS;
+/* grid over the coordinates of the cities (in the order of the frames), published by start_and_loop */
+extern spatialGrid *_Atomic SPATIAL_GRID;
+
+void notifyNewFrame();
 void *start_and_loop(void * args);
 
 #endif //FEM_LIKE_SPREADING_MODELLING_SIMULATION_H
@@ -0,0 +1,224 @@
+/**
+ * This module contains functions to work with spatialGrid struct. SpatialGrid is a static index
+ * over the coordinates of the cities - cities in a bounding box are found without going through
+ * all the cities and at coarse level of detail the cities are aggregated into cells
+ * (the number of returned values depends on the visible area, not on the number of cities).
+ */
+
+#include <stdlib.h>
+#include "spatialGrid.h"
+
+/**
+ * Returns the finest cell of the coordinate (coordinates outside of the grid are in the border cells)
+ * @param value latitude or longitude
+ * @param min minimal value of the grid
+ * @param max maximal value of the grid
+ * @return row (latitude) or column (longitude) of the cell
+ */
+static int cellOf(double value, double min, double max) {
+    int cell;
+    if (max <= min) return 0;
+
+    cell = (int) ((value - min) / (max - min) * SPATIAL_GRID_SIZE);
+    if (cell < 0) return 0;
+    return cell >= SPATIAL_GRID_SIZE ? SPATIAL_GRID_SIZE - 1 : cell;
+}
+
+/**
+ * Creates the grid over the cities
+ * @param numberOfCities number of cities
+ * @param lat latitudes of the cities (indices as in the frames)
+ * @param lon longitudes of the cities
+ * @return pointer to the grid or NULL if the arguments are invalid or it is not possible to allocate memory
+ */
+spatialGrid *createSpatialGrid(int numberOfCities, const double *lat, const double *lon) {
+    spatialGrid *grid;
+    spatialCell *cell;
+    int *position;
+    int i, level, side, row, column, cells = 0;
+
+    if (numberOfCities <= 0 || !lat || !lon) return NULL;
+
+    grid = calloc(1, sizeof(spatialGrid));
+    if (!grid) return NULL;
+
+    for (level = 1; level <= SPATIAL_GRID_LEVELS; level++) {
+        side = SPATIAL_GRID_SIZE >> (level - 1);
+        grid->levelStart[level - 1] = cells;
+        cells += side * side;
+    }
+
+    grid->numberOfCities = numberOfCities;
+    grid->cities = malloc(numberOfCities * sizeof(int));
+    grid->lat = malloc(numberOfCities * sizeof(double));
+    grid->lon = malloc(numberOfCities * sizeof(double));
+    grid->cells = calloc(cells, sizeof(spatialCell));
+    position = malloc(numberOfCities * sizeof(int));
+    if (!grid->cities || !grid->lat || !grid->lon || !grid->cells || !position) {
+        free(position);
+        freeSpatialGrid(&grid);
+        return NULL;
+    }
+
+    grid->minLat = grid->maxLat = lat[0];
+    grid->minLon = grid->maxLon = lon[0];
+    for (i = 0; i < numberOfCities; i++) {
+        grid->lat[i] = lat[i];
+        grid->lon[i] = lon[i];
+        if (lat[i] < grid->minLat) grid->minLat = lat[i];
+        if (lat[i] > grid->maxLat) grid->maxLat = lat[i];
+        if (lon[i] < grid->minLon) grid->minLon = lon[i];
+        if (lon[i] > grid->maxLon) grid->maxLon = lon[i];
+    }
+
+    /* counting sort of the cities by the finest cell, coordinates of the coarser cells are summed on the way */
+    for (i = 0; i < numberOfCities; i++) {
+        row = cellOf(lat[i], grid->minLat, grid->maxLat);
+        column = cellOf(lon[i], grid->minLon, grid->maxLon);
+        position[i] = row * SPATIAL_GRID_SIZE + column;
+        grid->cellStart[position[i] + 1]++;
+
+        for (level = 1; level <= SPATIAL_GRID_LEVELS; level++) {
+            side = SPATIAL_GRID_SIZE >> (level - 1);
+            cell = &grid->cells[grid->levelStart[level - 1] + (row >> (level - 1)) * side + (column >> (level - 1))];
+            cell->lat += lat[i];
+            cell->lon += lon[i];
+            cell->cities++;
+        }
+    }
+    for (i = 0; i < SPATIAL_GRID_SIZE * SPATIAL_GRID_SIZE; i++)
+        grid->cellStart[i + 1] += grid->cellStart[i];
+    for (i = 0; i < numberOfCities; i++)
+        grid->cities[grid->cellStart[position[i]]++] = i;
+    /* cellStart was moved to the end of the cells while filling */
+    for (i = SPATIAL_GRID_SIZE * SPATIAL_GRID_SIZE; i > 0; i--)
+        grid->cellStart[i] = grid->cellStart[i - 1];
+    grid->cellStart[0] = 0;
+
+    for (i = 0; i < cells; i++) {
+        if (!grid->cells[i].cities) continue;
+        grid->cells[i].lat /= grid->cells[i].cities;
+        grid->cells[i].lon /= grid->cells[i].cities;
+    }
+
+    free(position);
+    return grid;
+}
+
+/**
+ * Finds the finest cells which intersect the bounding box
+ * @param grid grid
+ * @param lat1 latitude of one corner of the box
+ * @param lon1 longitude of one corner of the box
+ * @param lat2 latitude of the opposite corner of the box
+ * @param lon2 longitude of the opposite corner of the box
+ * @param rows first and last row of the cells
+ * @param columns first and last column of the cells
+ * @return 1 if the box intersects the grid, 0 otherwise
+ */
+static int boxCells(spatialGrid *grid, double *lat1, double *lon1, double *lat2, double *lon2, int *rows, int *columns) {
+    double swap;
+
+    if (*lat1 > *lat2) {
+        swap = *lat1;
+        *lat1 = *lat2;
+        *lat2 = swap;
+    }
+    if (*lon1 > *lon2) {
+        swap = *lon1;
+        *lon1 = *lon2;
+        *lon2 = swap;
+    }
+    if (*lat2 < grid->minLat || *lat1 > grid->maxLat || *lon2 < grid->minLon || *lon1 > grid->maxLon) return 0;
+
+    rows[0] = cellOf(*lat1, grid->minLat, grid->maxLat);
+    rows[1] = cellOf(*lat2, grid->minLat, grid->maxLat);
+    columns[0] = cellOf(*lon1, grid->minLon, grid->maxLon);
+    columns[1] = cellOf(*lon2, grid->minLon, grid->maxLon);
+    return 1;
+}
+
+/**
+ * Finds the cities in the bounding box (only the cities of the cells which intersect the box are tested)
+ * @param grid grid
+ * @param lat1 latitude of one corner of the box
+ * @param lon1 longitude of one corner of the box
+ * @param lat2 latitude of the opposite corner of the box
+ * @param lon2 longitude of the opposite corner of the box
+ * @param cities output array (at most numberOfCities indices of the cities)
+ * @return number of the cities in the box or -1 if the arguments are invalid
+ */
+int spatialGridCities(spatialGrid *grid, double lat1, double lon1, double lat2, double lon2, int *cities) {
+    int rows[2], columns[2];
+    int row, i, city, count = 0;
+
+    if (!grid || !cities) return -1;
+    if (!boxCells(grid, &lat1, &lon1, &lat2, &lon2, rows, columns)) return 0;
+
+    for (row = rows[0]; row <= rows[1]; row++)
+        for (i = grid->cellStart[row * SPATIAL_GRID_SIZE + columns[0]];
+             i < grid->cellStart[row * SPATIAL_GRID_SIZE + columns[1] + 1]; i++) {
+            city = grid->cities[i];
+            if (grid->lat[city] >= lat1 && grid->lat[city] <= lat2 && grid->lon[city] >= lon1 && grid->lon[city] <= lon2)
+                cities[count++] = city;
+        }
+    return count;
+}
+
+/**
+ * Aggregates the cities of the cells of the level of detail which intersect the bounding box
+ * (whole cells, empty cells are skipped)
+ * @param grid grid
+ * @param lat1 latitude of one corner of the box
+ * @param lon1 longitude of one corner of the box
+ * @param lat2 latitude of the opposite corner of the box
+ * @param lon2 longitude of the opposite corner of the box
+ * @param lod level of detail (1 .. SPATIAL_GRID_LEVELS)
+ * @param population population of all the cities
+ * @param infected infected of all the cities
+ * @param cells output array (at most numberOfCities cells)
+ * @return number of the cells or -1 if the arguments are invalid
+ */
+int spatialGridCells(spatialGrid *grid, double lat1, double lon1, double lat2, double lon2, int lod,
+                     const int *population, const int *infected, spatialCell *cells) {
+    spatialCell *cell;
+    int rows[2], columns[2];
+    int shift, side, row, column, fineRow, i, count = 0;
+
+    if (!grid || !population || !infected || !cells || lod < 1 || lod > SPATIAL_GRID_LEVELS) return -1;
+    if (!boxCells(grid, &lat1, &lon1, &lat2, &lon2, rows, columns)) return 0;
+
+    shift = lod - 1;
+    side = SPATIAL_GRID_SIZE >> shift;
+    for (row = rows[0] >> shift; row <= rows[1] >> shift; row++)
+        for (column = columns[0] >> shift; column <= columns[1] >> shift; column++) {
+            cell = &grid->cells[grid->levelStart[lod - 1] + row * side + column];
+            if (!cell->cities) continue;
+
+            cells[count] = *cell;
+            /* the cities of one row of the finest cells of the cell are contiguous */
+            for (fineRow = row << shift; fineRow < (row + 1) << shift; fineRow++)
+                for (i = grid->cellStart[fineRow * SPATIAL_GRID_SIZE + (column << shift)];
+                     i < grid->cellStart[fineRow * SPATIAL_GRID_SIZE + ((column + 1) << shift)]; i++) {
+                    cells[count].population += population[grid->cities[i]];
+                    cells[count].infected += infected[grid->cities[i]];
+                }
+            count++;
+        }
+    return count;
+}
+
+/**
+ * Frees the grid
+ * @param grid pointer to pointer to the grid
+ */
+void freeSpatialGrid(spatialGrid **grid) {
+    if (!grid || !*grid) return;
+
+    free((*grid)->cities);
+    free((*grid)->lat);
+    free((*grid)->lon);
+    free((*grid)->cells);
+    free(*grid);
+    *grid = NULL;
+}
@@ -0,0 +1,48 @@
+#ifndef FEM_LIKE_SPREADING_MODELLING_SPATIALGRID_H
+#define FEM_LIKE_SPREADING_MODELLING_SPATIALGRID_H
+
+/* number of the finest cells on one side of the grid (must be power of two) */
+#define SPATIAL_GRID_SIZE 64
+/* level of detail 0 are the cities, level l > 0 are cells of 2^(l - 1) x 2^(l - 1) finest cells,
+   the last level is one cell with all the cities */
+#define SPATIAL_GRID_LEVELS 7
+
+/**
+ * Aggregate of the cities of one cell (coordinates are the mean of the coordinates of its cities)
+ */
+typedef struct {
+    double lat;
+    double lon;
+    int cities;
+    long long population;
+    long long infected;
+} spatialCell;
+
+/**
+ * Static grid over the coordinates of the cities
+ * Cities are sorted by the finest cell (row major, rows by latitude), so the cities of a row of cells are
+ * contiguous. Number of the cities and their mean coordinates are precomputed for the cells of all the levels.
+ */
+typedef struct {
+    int numberOfCities;
+    double minLat;
+    double maxLat;
+    double minLon;
+    double maxLon;
+    /* cities of the finest cell c are cities[cellStart[c]] .. cities[cellStart[c + 1] - 1] */
+    int cellStart[SPATIAL_GRID_SIZE * SPATIAL_GRID_SIZE + 1];
+    int *cities;
+    double *lat;
+    double *lon;
+    /* cells of the level l (1 .. SPATIAL_GRID_LEVELS) start at levelStart[l - 1] (row major) */
+    int levelStart[SPATIAL_GRID_LEVELS];
+    spatialCell *cells;
+} spatialGrid;
+
+spatialGrid *createSpatialGrid(int numberOfCities, const double *lat, const double *lon);
+int spatialGridCities(spatialGrid *grid, double lat1, double lon1, double lat2, double lon2, int *cities);
+int spatialGridCells(spatialGrid *grid, double lat1, double lon1, double lat2, double lon2, int lod,
+                     const int *population, const int *infected, spatialCell *cells);
+void freeSpatialGrid(spatialGrid **grid);
+
+#endif //FEM_LIKE_SPREADING_MODELLING_SPATIALGRID_H
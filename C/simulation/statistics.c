@@ -0,0 +1,195 @@
+/**
+ * This module contains functions to work with statistics struct. Statistics are aggregates of every
+ * day of the simulation (totals, cities with the most infected, sums over the districts), so the summary
+ * views don't need to transfer whole frames. Days are appended by the simulation thread and read by the server
+ * without any lock - a day is published (atomic number of days) only after it is written.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "statistics.h"
+
+/**
+ * Creates empty statistics
+ * @param numberOfCities number of cities in every frame
+ * @param cityDistrict index of the district of every city (-1 if not known), can be NULL if numberOfDistricts is 0
+ * @param districtCodes codes of the districts
+ * @param numberOfDistricts number of districts
+ * @return pointer to the statistics or NULL if it is not possible to allocate memory or the arguments are invalid
+ */
+statistics *createStatistics(int numberOfCities, const int *cityDistrict,
+                             const char (*districtCodes)[DISTRICT_CODE_LENGTH], int numberOfDistricts) {
+    statistics *stats;
+
+    if (numberOfCities <= 0 || numberOfDistricts < 0 || (numberOfDistricts > 0 && (!cityDistrict || !districtCodes)))
+        return NULL;
+
+    stats = calloc(1, sizeof(statistics));
+    if (!stats) return NULL;
+
+    stats->numberOfCities = numberOfCities;
+    stats->numberOfDistricts = numberOfDistricts;
+    stats->cityDistrict = malloc(numberOfCities * sizeof(int));
+    stats->districtCodes = malloc((numberOfDistricts ? numberOfDistricts : 1) * DISTRICT_CODE_LENGTH);
+    if (!stats->cityDistrict || !stats->districtCodes) {
+        freeStatistics(&stats);
+        return NULL;
+    }
+
+    if (numberOfDistricts) {
+        memcpy(stats->cityDistrict, cityDistrict, numberOfCities * sizeof(int));
+        memcpy(stats->districtCodes, districtCodes, numberOfDistricts * DISTRICT_CODE_LENGTH);
+    } else
+        memset(stats->cityDistrict, -1, numberOfCities * sizeof(int));
+
+    atomic_init(&stats->days, 0);
+    return stats;
+}
+
+/**
+ * Inserts the city into the top cities of the day (sorted from the most infected)
+ * @param day statistics of the day
+ * @param city index of the city
+ * @param population population of the city
+ * @param infected infected of the city
+ */
+static void insertTopCity(dayStatistics *day, int city, int population, int infected) {
+    int i;
+
+    if (day->topCount == STATISTICS_TOP_K && infected <= day->topInfected[STATISTICS_TOP_K - 1]) return;
+
+    i = day->topCount < STATISTICS_TOP_K ? day->topCount++ : STATISTICS_TOP_K - 1;
+    for (; i > 0 && day->topInfected[i - 1] < infected; i--) {
+        day->topCities[i] = day->topCities[i - 1];
+        day->topPopulation[i] = day->topPopulation[i - 1];
+        day->topInfected[i] = day->topInfected[i - 1];
+    }
+    day->topCities[i] = city;
+    day->topPopulation[i] = population;
+    day->topInfected[i] = infected;
+}
+
+/**
+ * Returns the slot for the day, allocates its block if needed
+ * @param stats statistics
+ * @param date number of the day
+ * @return pointer to the slot (with district arrays set) or NULL if it is not possible to allocate memory
+ */
+static dayStatistics *getDaySlot(statistics *stats, int date) {
+    dayStatistics *day;
+    int block = date / STATISTICS_BLOCK_DAYS;
+    int districts = stats->numberOfDistricts;
+
+    if (block >= STATISTICS_MAX_BLOCKS) return NULL;
+    if (!stats->blocks[block]) {
+        stats->blocks[block] = malloc(STATISTICS_BLOCK_DAYS * sizeof(dayStatistics));
+        stats->districtValues[block] = malloc((size_t) STATISTICS_BLOCK_DAYS * 2 * (districts ? districts : 1) * sizeof(int));
+        if (!stats->blocks[block] || !stats->districtValues[block]) {
+            free(stats->blocks[block]);
+            free(stats->districtValues[block]);
+            stats->blocks[block] = NULL;
+            stats->districtValues[block] = NULL;
+            return NULL;
+        }
+    }
+
+    day = &stats->blocks[block][date % STATISTICS_BLOCK_DAYS];
+    day->districtPopulation = stats->districtValues[block] + (size_t) (date % STATISTICS_BLOCK_DAYS) * 2 * districts;
+    day->districtInfected = day->districtPopulation + districts;
+    return day;
+}
+
+/**
+ * Computes the aggregates of the frame (one pass over the cities) and publishes them
+ * Days skipped since the last published day (not in the frame store after resuming) are published as missing
+ * @param stats statistics
+ * @param date number of the day, must be after the last published day
+ * @param population population of all the cities
+ * @param infected infected of all the cities
+ * @param newInfected citizens infected during the day (or STATISTICS_UNKNOWN)
+ * @param recovered citizens recovered during the day (or STATISTICS_UNKNOWN)
+ * @param deaths citizens who died during the day (or STATISTICS_UNKNOWN)
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the day was already published or it is not possible to allocate memory
+ */
+int statisticsAdd(statistics *stats, int date, const int *population, const int *infected,
+                  int newInfected, int recovered, int deaths) {
+    dayStatistics *day;
+    int days, i, district;
+
+    if (!stats || !population || !infected) return EXIT_FAILURE;
+    days = atomic_load_explicit(&stats->days, memory_order_relaxed);
+    if (date < days) return EXIT_FAILURE;
+
+    for (; days < date; days++) {
+        day = getDaySlot(stats, days);
+        if (!day) return EXIT_FAILURE;
+        day->date = STATISTICS_UNKNOWN;
+    }
+
+    day = getDaySlot(stats, date);
+    if (!day) return EXIT_FAILURE;
+    day->date = date;
+    day->population = 0;
+    day->infected = 0;
+    day->newInfected = newInfected;
+    day->recovered = recovered;
+    day->deaths = deaths;
+    day->topCount = 0;
+    memset(day->districtPopulation, 0, 2 * stats->numberOfDistricts * sizeof(int));
+
+    for (i = 0; i < stats->numberOfCities; i++) {
+        day->population += population[i];
+        day->infected += infected[i];
+        insertTopCity(day, i, population[i], infected[i]);
+
+        district = stats->cityDistrict[i];
+        if (district < 0) continue;
+        day->districtPopulation[district] += population[i];
+        day->districtInfected[district] += infected[i];
+    }
+
+    /* readers see the day only after it is written */
+    atomic_store_explicit(&stats->days, date + 1, memory_order_release);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Returns the number of the published days
+ * @param stats statistics
+ * @return number of the days (days 0 .. number - 1 can be read), 0 if stats is NULL
+ */
+int statisticsDays(statistics *stats) {
+    if (!stats) return 0;
+    return atomic_load_explicit(&stats->days, memory_order_acquire);
+}
+
+/**
+ * Returns the aggregates of the day
+ * @param stats statistics
+ * @param date number of the day
+ * @return pointer to the aggregates (never changed) or NULL if the day was not published yet or is missing
+ */
+const dayStatistics *statisticsGet(statistics *stats, int date) {
+    const dayStatistics *day;
+    if (date < 0 || date >= statisticsDays(stats)) return NULL;
+    day = &stats->blocks[date / STATISTICS_BLOCK_DAYS][date % STATISTICS_BLOCK_DAYS];
+    return day->date == date ? day : NULL;
+}
+
+/**
+ * Frees the statistics, no reader may use them anymore
+ * @param stats pointer to pointer to the statistics
+ */
+void freeStatistics(statistics **stats) {
+    int i;
+    if (!stats || !*stats) return;
+
+    for (i = 0; i < STATISTICS_MAX_BLOCKS; i++) {
+        free((*stats)->blocks[i]);
+        free((*stats)->districtValues[i]);
+    }
+    free((*stats)->cityDistrict);
+    free((*stats)->districtCodes);
+    free(*stats);
+    *stats = NULL;
+}
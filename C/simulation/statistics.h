@@ -0,0 +1,61 @@
+#ifndef FEM_LIKE_SPREADING_MODELLING_STATISTICS_H
+#define FEM_LIKE_SPREADING_MODELLING_STATISTICS_H
+
+#include <stdatomic.h>
+
+#define DISTRICTS_FILEPATH "./DATA/pocty.csv"
+/* kod_okres, e.g. CZ0201 */
+#define DISTRICT_CODE_LENGTH 8
+/* number of the cities with the most infected kept for every day */
+#define STATISTICS_TOP_K 32
+/* days are stored in blocks, which never move (readers don't need any lock) */
+#define STATISTICS_BLOCK_DAYS 256
+#define STATISTICS_MAX_BLOCKS 4096
+/* value of the counter which is not known (days computed from the frame store after resuming) */
+#define STATISTICS_UNKNOWN -1
+
+/**
+ * Aggregates of one day of the simulation
+ * top* arrays contain topCount cities with the most infected (indices of the cities), sorted from the most infected
+ * district* arrays contain sums over the cities of the districts
+ */
+typedef struct {
+    int date;
+    long long population;
+    long long infected;
+    int newInfected;
+    int recovered;
+    int deaths;
+    int topCount;
+    int topCities[STATISTICS_TOP_K];
+    int topPopulation[STATISTICS_TOP_K];
+    int topInfected[STATISTICS_TOP_K];
+    int *districtPopulation;
+    int *districtInfected;
+} dayStatistics;
+
+/**
+ * Append-only table of the aggregates of all the days
+ * Days are written only by the simulation thread, published day is never changed
+ */
+typedef struct {
+    int numberOfCities;
+    int numberOfDistricts;
+    /* index of the district of every city, -1 if the district is not known */
+    int *cityDistrict;
+    char (*districtCodes)[DISTRICT_CODE_LENGTH];
+    dayStatistics *blocks[STATISTICS_MAX_BLOCKS];
+    int *districtValues[STATISTICS_MAX_BLOCKS];
+    /* days 0 .. days - 1 are published (days missing in the frame store have date STATISTICS_UNKNOWN) */
+    atomic_int days;
+} statistics;
+
+statistics *createStatistics(int numberOfCities, const int *cityDistrict,
+                             const char (*districtCodes)[DISTRICT_CODE_LENGTH], int numberOfDistricts);
+int statisticsAdd(statistics *stats, int date, const int *population, const int *infected,
+                  int newInfected, int recovered, int deaths);
+int statisticsDays(statistics *stats);
+const dayStatistics *statisticsGet(statistics *stats, int date);
+void freeStatistics(statistics **stats);
+
+#endif //FEM_LIKE_SPREADING_MODELLING_STATISTICS_H
@@ -0,0 +1,290 @@
+/**
+ * This module contains functions to sweep the parameters of the simulation - every combination of the values of
+ * the swept parameters is simulated from the same initial state (citizens are created from the cities of the
+ * geography, which is loaded only once) with the same seed and the outcomes are written as one table.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "sweep.h"
+
+#define NAME_LENGTH 64
+
+/**
+ * Creates the sweep without any dimension (a single run with the parameters of the geography)
+ * @param geography loaded cities, the sweep does not take the ownership (must outlive the sweep)
+ * @param days number of the simulated days of every run, must be greater than zero
+ * @param seed seed of the generator of every run
+ * @return pointer to sweep struct or NULL
+ */
+sweep *createSweep(country *geography, int days, unsigned long long seed) {
+    sweep *theSweep;
+
+    if (!geography || days <= 0) return NULL;
+    theSweep = calloc(1, sizeof(sweep));
+    if (!theSweep) return NULL;
+
+    theSweep->geography = geography;
+    theSweep->days = days;
+    theSweep->seed = seed;
+    theSweep->points = 1;
+    return theSweep;
+}
+
+/**
+ * Parses the values of the dimension
+ * @param definition either a range from:to:step (to is included) or a list of the values v1,v2,...
+ * @param count output number of the values
+ * @return array of the values or NULL if the definition is invalid
+ */
+static double *parseValues(const char *definition, int *count) {
+    double from, to, step, *values;
+    const char *current;
+    char *end;
+    int i;
+
+    if (strchr(definition, ':')) {
+        from = strtod(definition, &end);
+        if (end == definition || *end != ':') return NULL;
+        to = strtod(current = end + 1, &end);
+        if (end == current || *end != ':') return NULL;
+        step = strtod(current = end + 1, &end);
+        if (end == current || *end || !(step > 0) || !(to >= from)) return NULL;
+        if ((to - from) / step >= SWEEP_MAX_POINTS) return NULL;
+
+        *count = (int) ((to - from) / step + 1e-9) + 1;
+        values = malloc(*count * sizeof(double));
+        if (!values) return NULL;
+        for (i = 0; i < *count; i++) values[i] = from + i * step;
+        return values;
+    }
+
+    *count = 1;
+    for (current = definition; *current; current++)
+        if (*current == ',') (*count)++;
+    values = malloc(*count * sizeof(double));
+    if (!values) return NULL;
+    current = definition;
+    for (i = 0; i < *count; i++) {
+        values[i] = strtod(current, &end);
+        if (end == current || (*end && *end != ',')) {
+            free(values);
+            return NULL;
+        }
+        current = end + 1;
+    }
+    return values;
+}
+
+/**
+ * Adds the swept parameter, the runs are all the combinations of the values of the dimensions
+ * @param theSweep sweep which did not run yet
+ * @param definition NAME=from:to:step or NAME=v1,v2,... (NAME as in parameterIndex, e.g. MEETING_FACTOR=0.1:0.5:0.1)
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the definition is invalid, a value is out of the range of the parameter,
+ *         the parameter is already swept or there would be more than SWEEP_MAX_POINTS runs
+ */
+int sweepAddDimension(sweep *theSweep, const char *definition) {
+    char name[NAME_LENGTH];
+    const char *equals;
+    sweepDimension *dimension;
+    parameters check;
+    double *values;
+    int parameter, count, i;
+
+    if (!theSweep || !definition || theSweep->results) return EXIT_FAILURE;
+    equals = strchr(definition, '=');
+    if (!equals || equals - definition >= NAME_LENGTH) return EXIT_FAILURE;
+    memcpy(name, definition, equals - definition);
+    name[equals - definition] = '\0';
+
+    parameter = parameterIndex(name);
+    if (parameter < 0) return EXIT_FAILURE;
+    for (i = 0; i < theSweep->dimensions; i++)
+        if (theSweep->dimension[i].parameter == parameter) return EXIT_FAILURE;
+
+    values = parseValues(equals + 1, &count);
+    if (!values) return EXIT_FAILURE;
+    check = theSweep->geography->params;
+    for (i = 0; i < count; i++)
+        if (parametersSet(&check, parameter, values[i]) == EXIT_FAILURE) break;
+    if (i < count || (long long) theSweep->points * count > SWEEP_MAX_POINTS) {
+        free(values);
+        return EXIT_FAILURE;
+    }
+
+    dimension = &theSweep->dimension[theSweep->dimensions++];
+    dimension->parameter = parameter;
+    dimension->count = count;
+    dimension->values = values;
+    theSweep->points *= count;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Simulates one point of the sweep on the calling thread
+ * @param theSweep sweep
+ * @param result result of the point (with the parameters of the point)
+ * @param population buffer for the population of every city
+ * @param infected buffer for the infected of every city
+ */
+static void runPoint(sweep *theSweep, sweepResult *result, int *population, int *infected) {
+    country *theCountry;
+    GaussRandom *moveRandom, *spreadRandom;
+    unsigned long long state;
+    long long totalPopulation, totalInfected, start;
+    int day, i;
+
+    result->population = result->infected = result->peakInfected = -1;
+    result->newInfected = result->recovered = result->deaths = -1;
+    result->peakDay = -1;
+    totalPopulation = totalInfected = -1;
+
+    start = metricsNow();
+    theCountry = copyCountry(theSweep->geography);
+    moveRandom = createRandom(result->params.moveMean, result->params.moveStdDev);
+    spreadRandom = createRandom(result->params.spreadMean, result->params.spreadStdDev);
+    result->setupTime = metricsNow() - start;
+    start = metricsNow();
+    if (theCountry && moveRandom && spreadRandom) {
+        theCountry->params = result->params;
+        result->newInfected = result->recovered = result->deaths = 0;
+        randomSeed(&state, theSweep->seed);
+        randomUseState(&state);
+
+        for (day = 0; day < theSweep->days; day++) {
+            simulateDay(theCountry, moveRandom, spreadRandom);
+            snapshotCountry(theCountry, population, infected);
+
+            totalPopulation = totalInfected = 0;
+            for (i = 0; i < theCountry->numberOfCities; i++) {
+                totalPopulation += population[i];
+                totalInfected += infected[i];
+            }
+            if (totalInfected > result->peakInfected) {
+                result->peakInfected = totalInfected;
+                result->peakDay = day;
+            }
+            result->newInfected += theCountry->newInfected;
+            result->recovered += theCountry->recovered;
+            result->deaths += theCountry->deaths;
+        }
+        result->population = totalPopulation;
+        result->infected = totalInfected;
+        randomUseState(NULL);
+    }
+    result->runTime = metricsNow() - start;
+
+    freeCountry(&theCountry);
+    freeRandom(&moveRandom);
+    freeRandom(&spreadRandom);
+}
+
+/**
+ * Loop of one thread of the pool - simulates the points it takes until there are none left
+ * @param args sweep
+ * @return NULL
+ */
+static void *sweepWorker(void *args) {
+    sweep *theSweep = args;
+    int *population, *infected, point;
+
+    population = malloc(theSweep->geography->numberOfCities * sizeof(int));
+    infected = malloc(theSweep->geography->numberOfCities * sizeof(int));
+    if (population && infected)
+        while ((point = atomic_fetch_add(&theSweep->next, 1)) < theSweep->points) {
+            runPoint(theSweep, &theSweep->results[point], population, infected);
+            if (TRACE_ENABLED) traceFlush();
+        }
+
+    free(population);
+    free(infected);
+    return NULL;
+}
+
+/**
+ * Simulates all the points of the sweep (blocks until all of them are done)
+ * @param theSweep sweep which did not run yet
+ * @param threads number of the threads, must be greater than zero (fewer are used if there are fewer points or
+ *                the system does not allow to start all of them)
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the sweep can't run (failed points have -1 in their results)
+ */
+int sweepRun(sweep *theSweep, int threads) {
+    pthread_t *workers;
+    int point, rest, i, started = 0;
+    double value;
+
+    if (!theSweep || threads <= 0 || theSweep->results) return EXIT_FAILURE;
+    theSweep->results = malloc(theSweep->points * sizeof(sweepResult));
+    if (!theSweep->results) return EXIT_FAILURE;
+
+    /* the last dimension changes the fastest */
+    for (point = 0; point < theSweep->points; point++) {
+        theSweep->results[point].params = theSweep->geography->params;
+        rest = point;
+        for (i = theSweep->dimensions - 1; i >= 0; i--) {
+            value = theSweep->dimension[i].values[rest % theSweep->dimension[i].count];
+            parametersSet(&theSweep->results[point].params, theSweep->dimension[i].parameter, value);
+            rest /= theSweep->dimension[i].count;
+        }
+    }
+
+    if (threads > theSweep->points) threads = theSweep->points;
+    workers = malloc(threads * sizeof(pthread_t));
+    atomic_store(&theSweep->next, 0);
+    for (i = 0; workers && i < threads; i++) {
+        if (pthread_create(&workers[i], NULL, sweepWorker, theSweep)) break;
+        started++;
+    }
+    /* without any thread, the points are simulated by the caller */
+    if (!started) sweepWorker(theSweep);
+    for (i = 0; i < started; i++) pthread_join(workers[i], NULL);
+
+    free(workers);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Writes the results of the sweep as csv - one row per point with the values of the swept parameters followed
+ * by population, infected (of the last day), peak_infected, peak_day, new_infected, recovered, deaths and the
+ * wall-clock seconds of the setup (copy of the citizens) and of the days
+ * @param theSweep sweep which already ran
+ * @param file output file
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int sweepWriteResults(sweep *theSweep, FILE *file) {
+    sweepResult *result;
+    int point, i;
+
+    if (!theSweep || !file || !theSweep->results) return EXIT_FAILURE;
+
+    fputs("point", file);
+    for (i = 0; i < theSweep->dimensions; i++) fprintf(file, ",%s", parameterName(theSweep->dimension[i].parameter));
+    fputs(",population,infected,peak_infected,peak_day,new_infected,recovered,deaths,setup_seconds,run_seconds\n",
+          file);
+
+    for (point = 0; point < theSweep->points; point++) {
+        result = &theSweep->results[point];
+        fprintf(file, "%d", point);
+        for (i = 0; i < theSweep->dimensions; i++)
+            fprintf(file, ",%g", parametersGet(&result->params, theSweep->dimension[i].parameter));
+        fprintf(file, ",%lld,%lld,%lld,%d,%lld,%lld,%lld,%f,%f\n", result->population, result->infected,
+                result->peakInfected, result->peakDay, result->newInfected, result->recovered, result->deaths,
+                result->setupTime / 1e9, result->runTime / 1e9);
+    }
+    return ferror(file) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ * Deallocates the sweep (the geography is not freed)
+ * @param theSweep pointer to pointer to sweep
+ */
+void freeSweep(sweep **theSweep) {
+    int i;
+    if (!theSweep || !*theSweep) return;
+
+    for (i = 0; i < (*theSweep)->dimensions; i++) free((*theSweep)->dimension[i].values);
+    free((*theSweep)->results);
+    free(*theSweep);
+    *theSweep = NULL;
+}
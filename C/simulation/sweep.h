@@ -0,0 +1,60 @@
+#ifndef FEM_LIKE_SPREADING_MODELLING_SWEEP_H
+#define FEM_LIKE_SPREADING_MODELLING_SWEEP_H
+
+#include <stdio.h>
+#include <stdatomic.h>
+#include "simulation.h"
+
+/* maximum number of the runs of one sweep */
+#define SWEEP_MAX_POINTS 100000
+
+/**
+ * Values of one swept parameter
+ */
+typedef struct {
+    int parameter;
+    int count;
+    double *values;
+} sweepDimension;
+
+/**
+ * Outcome of one run (point) of the sweep, the counters are -1 if the run failed
+ */
+typedef struct {
+    parameters params;
+    long long population;
+    long long infected;
+    long long peakInfected;
+    int peakDay;
+    long long newInfected;
+    long long recovered;
+    long long deaths;
+    /* wall-clock time (ns) of copying the citizens from the geography and of simulating the days */
+    long long setupTime;
+    long long runTime;
+} sweepResult;
+
+/**
+ * Grid of the parameters (cartesian product of the dimensions), every point is one run of the simulation
+ * of the geography for the given number of days - all the runs start from the same citizens with the same
+ * seed, so they differ only by the parameters
+ * Runs are taken by a pool of threads, every thread has only one run in memory at once
+ */
+typedef struct {
+    country *geography;
+    int days;
+    unsigned long long seed;
+    int dimensions;
+    sweepDimension dimension[PARAMETER_COUNT];
+    int points;
+    sweepResult *results;
+    atomic_int next;
+} sweep;
+
+sweep *createSweep(country *geography, int days, unsigned long long seed);
+int sweepAddDimension(sweep *theSweep, const char *definition);
+int sweepRun(sweep *theSweep, int threads);
+int sweepWriteResults(sweep *theSweep, FILE *file);
+void freeSweep(sweep **theSweep);
+
+#endif //FEM_LIKE_SPREADING_MODELLING_SWEEP_H
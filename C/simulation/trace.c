@@ -0,0 +1,105 @@
+/**
+ * This module contains functions to record begin and end events of the simulation and the server
+ * into a trace file (Chrome trace-event JSON, can be opened by Perfetto or chrome://tracing).
+ * Every thread records into its own buffer without any lock, the buffer is written into the file
+ * when it is full or when the thread flushes it (once per day in the simulation).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "trace.h"
+#include "metrics.h"
+
+char TRACE_ENABLED = 0;
+
+static FILE *TRACE_FILE = NULL;
+static long long TRACE_WRITTEN = 0;
+static pthread_mutex_t TRACE_LOCK = PTHREAD_MUTEX_INITIALIZER;
+static _Thread_local traceBuffer *THREAD_BUFFER = NULL;
+
+/**
+ * Opens the trace file and enables tracing, must be called before the traced threads are started
+ * @param filepath path to the trace file (truncated)
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the file can't be created
+ */
+int traceOpen(const char *filepath) {
+    if (!filepath) return EXIT_FAILURE;
+
+    TRACE_FILE = fopen(filepath, "w");
+    if (!TRACE_FILE) return EXIT_FAILURE;
+
+    fputs("[\n", TRACE_FILE);
+    TRACE_WRITTEN = 0;
+    TRACE_ENABLED = 1;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Records the event into the buffer of the calling thread (allocated by the first event),
+ * full buffer is written into the file
+ * @param name name of the event, string literal
+ * @param phase 'B' (begin) or 'E' (end)
+ * @param value argument of the event (shown in the trace viewer) or TRACE_NO_VALUE
+ */
+void traceEvent(const char *name, char phase, int value) {
+    traceRecord *record;
+
+    if (!THREAD_BUFFER) {
+        THREAD_BUFFER = malloc(sizeof(traceBuffer));
+        if (!THREAD_BUFFER) return;
+        THREAD_BUFFER->threadId = (int) syscall(SYS_gettid);
+        THREAD_BUFFER->count = 0;
+    }
+    if (THREAD_BUFFER->count == TRACE_BUFFER_EVENTS) traceFlush();
+
+    record = &THREAD_BUFFER->records[THREAD_BUFFER->count++];
+    record->name = name;
+    record->phase = phase;
+    record->value = value;
+    record->timestamp = metricsNow();
+}
+
+/**
+ * Writes the events of the calling thread into the file
+ */
+void traceFlush(void) {
+    traceRecord *record;
+    int i;
+
+    if (!THREAD_BUFFER || !THREAD_BUFFER->count) return;
+
+    pthread_mutex_lock(&TRACE_LOCK);
+    for (i = 0; TRACE_FILE && i < THREAD_BUFFER->count; i++) {
+        record = &THREAD_BUFFER->records[i];
+        /* timestamps of the trace events are in microseconds */
+        fprintf(TRACE_FILE, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d",
+                TRACE_WRITTEN++ ? ",\n" : "", record->name, record->phase, record->timestamp / 1e3, (int) getpid(),
+                THREAD_BUFFER->threadId);
+        if (record->value != TRACE_NO_VALUE)
+            fprintf(TRACE_FILE, ",\"args\":{\"value\":%d}", record->value);
+        fputc('}', TRACE_FILE);
+    }
+    if (TRACE_FILE) fflush(TRACE_FILE);
+    pthread_mutex_unlock(&TRACE_LOCK);
+
+    THREAD_BUFFER->count = 0;
+}
+
+/**
+ * Writes the events of the calling thread and closes the file (events of the other threads
+ * which are not flushed yet are lost)
+ */
+void traceClose(void) {
+    traceFlush();
+
+    pthread_mutex_lock(&TRACE_LOCK);
+    if (TRACE_FILE) {
+        fputs("\n]\n", TRACE_FILE);
+        fclose(TRACE_FILE);
+        TRACE_FILE = NULL;
+    }
+    pthread_mutex_unlock(&TRACE_LOCK);
+}
@@ -0,0 +1,42 @@
+#ifndef FEM_LIKE_SPREADING_MODELLING_TRACE_H
+#define FEM_LIKE_SPREADING_MODELLING_TRACE_H
+
+/* events kept by one thread before they are written into the file */
+#define TRACE_BUFFER_EVENTS 16384
+/* value of the event without argument */
+#define TRACE_NO_VALUE -1
+
+/* 1 after traceOpen - set before the threads which trace are started, never changed while they run */
+extern char TRACE_ENABLED;
+
+/* events of the trace - names must be string literals (only the pointer is kept),
+   disabled tracing costs only the test of TRACE_ENABLED */
+#define TRACE_BEGIN(name) do { if (TRACE_ENABLED) traceEvent((name), 'B', TRACE_NO_VALUE); } while (0)
+#define TRACE_BEGIN_VALUE(name, value) do { if (TRACE_ENABLED) traceEvent((name), 'B', (value)); } while (0)
+#define TRACE_END(name) do { if (TRACE_ENABLED) traceEvent((name), 'E', TRACE_NO_VALUE); } while (0)
+
+/**
+ * One begin or end event of the trace
+ */
+typedef struct {
+    const char *name;
+    long long timestamp;
+    int value;
+    char phase;
+} traceRecord;
+
+/**
+ * Events of one thread, written into the file by the thread itself
+ */
+typedef struct {
+    int threadId;
+    int count;
+    traceRecord records[TRACE_BUFFER_EVENTS];
+} traceBuffer;
+
+int traceOpen(const char *filepath);
+void traceEvent(const char *name, char phase, int value);
+void traceFlush(void);
+void traceClose(void);
+
+#endif //FEM_LIKE_SPREADING_MODELLING_TRACE_H
@@ -1,4 +1,9 @@
 import socket
+import math
+import queue
+import struct
+import time
+import numpy as np
 import plotly.express as px
 import pandas as pd
 import platform
@@ -10,6 +15,27 @@ SOCKET_EXIT_CODE = b"I'LL BE BACK"
 __port = 4242
 __host_ip = "127.0.0.1"
 SOCKET_BUFFER_SIZE = 4194304
+NO_DATA = "no data\x04"
+# frames are transferred as deltas against the previous frame (send_data <n> delta)
+DELTA_TRANSFER = True
+# maximal number of frames requested by one send_range (the visualization catches up in one request)
+RANGE_LENGTH = 1000
+# responses are binary messages (binary command), frames are int32 arrays decoded without parsing
+BINARY_TRANSFER = True
+# binary mode: type (1 byte) and length of the payload (4 bytes), numbers are little-endian
+MSG_HEADER = struct.Struct("<BI")
+MSG_TYPE_TEXT = 1
+MSG_TYPE_FRAME = 2
+MSG_TYPE_ENCODED_FRAME = 3
+MSG_TYPE_CITIES = 4
+MSG_TYPE_END = 5
+# new frames are pushed by server (subscribe) instead of polling
+SUBSCRIBE = True
+# seconds to wait before the subscription is renewed after the connection was lost
+SUBSCRIBE_RETRY_DELAY = 1
+# bounding box queries (get_bbox) - zoom of the map from which single cities are shown, coarsest level of detail
+BBOX_CITY_ZOOM = 9
+BBOX_MAX_LOD = 7
 
 
 def create_and_connect_socket():
@@ -115,6 +141,252 @@ def socket_read(sock):
     return msg
 
 
+def __response_end(msg):
+    """
+    Finds the end of the first complete response in the received bytes
+    Frames with headers ('frame <n> <base> <length>\\n' or 'csv <n> <length>\\n' followed by <length> bytes,
+    responses to 'send_data <n> delta' and 'send_range') may contain \\x04, so their lengths are used
+    instead of searching
+    :param msg: Received bytes
+    :return: Index of the \\x04 which ends the first response or -1 if the response is not complete
+    """
+    if not msg.startswith(b"frame ") and not msg.startswith(b"csv "):
+        return msg.find(b"\x04")
+    position = 0
+    while msg.startswith(b"frame ", position) or msg.startswith(b"csv ", position):
+        header_end = msg.find(b"\n", position)
+        if header_end < 0:
+            return -1
+        position = header_end + 1 + int(msg[position:header_end].split()[-1])
+    return position if len(msg) > position else -1
+
+
+def socket_responses(sock):
+    """
+    Reads responses from server one by one, as long as the connection is open
+    :param sock: socket of client
+    :return: Generator of bytes responses (without \\x04)
+    """
+    msg = b""
+    while True:
+        end = __response_end(msg)
+        if end < 0:
+            chunk = sock.recv(SOCKET_BUFFER_SIZE)
+            if not chunk:
+                return
+            msg += chunk
+            continue
+        yield msg[:end]
+        msg = msg[end + 1:]
+
+
+def socket_read_responses(sock, count):
+    """
+    Reads responses to more commands sent at once (pipelined) from server
+    :param sock: socket of client
+    :param count: Number of expected responses
+    :return: List of bytes responses (without \\x04), shorter than count in case of error
+    """
+    responses = []
+    if count <= 0:
+        return responses
+    try:
+        for response in socket_responses(sock):
+            responses.append(response)
+            if len(responses) == count:
+                break
+    except socket.timeout:
+        print("Error: server timed out.")
+    except socket.error:
+        print("Error: could not read from server.")
+    except (ValueError, IndexError):
+        print("Error: corrupted frame header.")
+    return responses
+
+
+def socket_messages(sock):
+    """
+    Reads messages of the binary mode from server one by one, as long as the connection is open
+    :param sock: socket of client (switched to binary mode)
+    :return: Generator of tuples (type, payload)
+    """
+    buffer = bytearray()
+    position = 0
+    while True:
+        if len(buffer) - position >= MSG_HEADER.size:
+            msg_type, length = MSG_HEADER.unpack_from(buffer, position)
+            end = position + MSG_HEADER.size + length
+            if len(buffer) >= end:
+                yield msg_type, bytes(buffer[position + MSG_HEADER.size:end])
+                position = end
+                continue
+        if position:
+            del buffer[:position]
+            position = 0
+        chunk = sock.recv(SOCKET_BUFFER_SIZE)
+        if not chunk:
+            return
+        buffer += chunk
+
+
+def parse_frame_message(payload):
+    """
+    Decodes MSG_TYPE_FRAME message without any parsing
+    :param payload: Payload of the message
+    :return: Tuple (frame, values) - values are population of all the cities followed by infected of all the cities
+    """
+    frame_number, count = struct.unpack_from("<ii", payload)
+    return frame_number, np.frombuffer(payload, dtype="<i4", count=2 * count, offset=8)
+
+
+def parse_cities_message(payload):
+    """
+    Decodes MSG_TYPE_CITIES message
+    :param payload: Payload of the message
+    :return: Array of ids of the cities in the order of the frames
+    """
+    count, = struct.unpack_from("<i", payload)
+    return np.frombuffer(payload, dtype="<i4", count=count, offset=4)
+
+
+def connect_binary():
+    """
+    Connects to server and switches the connection to binary mode
+    :return: Socket to server or None if error
+    """
+    sock = create_and_connect_socket()
+    if sock is None:
+        return None
+    if not __sock_send(sock, b"binary\x04") or socket_read(sock) != b"binary\x04":
+        close_socket(sock)
+        return None
+    return sock
+
+
+__binary_connection = None
+__binary_messages = None
+
+
+def binary_request(bytes_messages):
+    """
+    Sends messages (pipelined) through the kept binary connection and reads the messages of the responses
+    (send_range is answered by more messages ended with MSG_TYPE_END, other commands by one message)
+    If the connection was lost, connects again and repeats the request once
+    :param bytes_messages: List of bytes messages without ending \\x04
+    :return: List of responses, every response is a list of tuples (type, payload)
+    """
+    global __binary_connection, __binary_messages
+    data = b"".join(message + b"\x04" for message in bytes_messages)
+    for _ in range(2):
+        if __binary_connection is None:
+            __binary_connection = connect_binary()
+            if __binary_connection is None:
+                return []
+            __binary_messages = socket_messages(__binary_connection)
+        responses = []
+        try:
+            if __sock_send(__binary_connection, data):
+                for message in bytes_messages:
+                    response = [next(__binary_messages)]
+                    if message.startswith(b"send_range") and response[0][0] != MSG_TYPE_TEXT:
+                        while response[-1][0] != MSG_TYPE_END:
+                            response.append(next(__binary_messages))
+                        response.pop()
+                    responses.append(response)
+                return responses
+        except (socket.error, StopIteration, struct.error):
+            print("Error: could not read from server.")
+        try:
+            close_socket(__binary_connection)
+        except socket.error:
+            pass
+        __binary_connection = None
+    return []
+
+
+def parse_frame(response):
+    """
+    Parses encoded frame (response to 'send_data <n> delta')
+    :param response: Response from server (without \\x04)
+    :return: Tuple (frame, base, data) or None if the response is not an encoded frame
+    """
+    frames = parse_frames(response)
+    if not frames or frames[0][1] is None:
+        return None
+    return frames[0]
+
+
+def parse_frames(response):
+    """
+    Parses frames with headers (response to 'send_range' or 'send_data <n> delta')
+    :param response: Response from server (without \\x04)
+    :return: List of tuples (frame, base, data), base is None for frames sent as CSV
+    """
+    frames = []
+    position = 0
+    while position < len(response):
+        header_end = response.find(b"\n", position)
+        header = response[position:header_end].split()
+        length = int(header[-1])
+        data = response[header_end + 1:header_end + 1 + length]
+        if header[0] == b"frame":
+            frames.append((int(header[1]), int(header[2]), data))
+        else:
+            frames.append((int(header[1]), None, data))
+        position = header_end + 1 + length
+    return frames
+
+
+__connection = None
+
+
+def get_connection():
+    """
+    Returns the connection to server kept open between the requests, connects if there is none
+    :return: Socket to server or None if error
+    """
+    global __connection
+    if __connection is None:
+        __connection = create_and_connect_socket()
+    return __connection
+
+
+def drop_connection():
+    """
+    Closes the kept connection (after error, next get_connection connects again)
+    :return: no return value
+    """
+    global __connection
+    if __connection is not None:
+        try:
+            close_socket(__connection)
+        except socket.error:
+            pass
+        __connection = None
+
+
+def request(bytes_messages, count=None):
+    """
+    Sends messages (pipelined) through the kept connection and reads the responses
+    If the connection was lost, connects again and repeats the request once
+    :param bytes_messages: List of bytes messages without ending \\x04
+    :param count: Number of responses to read, default is one per message
+    :return: List of bytes responses (without \\x04)
+    """
+    count = len(bytes_messages) if count is None else count
+    data = b"".join(message + b"\x04" for message in bytes_messages)
+    for _ in range(2):
+        sock = get_connection()
+        if sock is None:
+            return []
+        if __sock_send(sock, data):
+            responses = socket_read_responses(sock, count)
+            if len(responses) == count:
+                return responses
+        drop_connection()
+    return []
+
+
 def socket_send_and_read(bytes_message):
     """
     Sends message to server and reads response
@@ -131,6 +403,329 @@ def socket_send_and_read(bytes_message):
     return None
 
 
+def query(bytes_message):
+    """
+    Sends command with text (CSV) response through the kept connection
+    :param bytes_message: Bytes message without ending \\x04
+    :return: Response as string or None if error or no data
+    """
+    if BINARY_TRANSFER:
+        responses = binary_request([bytes_message])
+        response = responses[0][0][1] if responses and responses[0][0][0] == MSG_TYPE_TEXT else None
+    else:
+        responses = request([bytes_message])
+        response = responses[0] if responses else None
+    if response is None or response.startswith(NO_DATA[:-1].encode()):
+        return None
+    return response.decode()
+
+
+def __parse_csv_value(value):
+    """
+    Converts value of the CSV to int or float if it is a number
+    :param value: String value
+    :return: Int, float or the string
+    """
+    for number_type in (int, float):
+        try:
+            return number_type(value)
+        except ValueError:
+            pass
+    return value
+
+
+def __parse_csv_rows(text):
+    """
+    Parses CSV with numeric columns (other columns are kept as strings)
+    :param text: CSV with header
+    :return: List of dicts (column name -> value)
+    """
+    lines = text.strip().split("\n")
+    keys = lines[0].split(",")
+    return [{key: __parse_csv_value(value) for key, value in zip(keys, line.split(","))} for line in lines[1:]]
+
+
+def get_stats(day):
+    """
+    Gets aggregates of the day computed by the simulation (no frame is transferred)
+    :param day: Number of the day (frame of the simulation)
+    :return: Dict with keys datum, pocet_obyvatel, pocet_nakazenych, novych_nakazenych, uzdravenych, zemrelych
+             (-1 if not known) or None if the day doesn't exist
+    """
+    response = query(f"stats {day}".encode())
+    return __parse_csv_rows(response)[0] if response else None
+
+
+def get_district_stats(day):
+    """
+    Gets sums over the districts (kod_okres) of the day
+    :param day: Number of the day (frame of the simulation)
+    :return: List of dicts with keys kod_okres, pocet_obyvatel, pocet_nakazenych or None if the day doesn't exist
+    """
+    response = query(f"stats {day} districts".encode())
+    return __parse_csv_rows(response) if response else None
+
+
+def get_top_cities(day, k=10):
+    """
+    Gets k cities with the most infected in the day
+    :param day: Number of the day (frame of the simulation)
+    :param k: Number of the cities (at most 32)
+    :return: List of dicts with keys kod_obce, pocet_obyvatel, pocet_nakazenych or None if the day doesn't exist
+    """
+    response = query(f"topk {day} {k}".encode())
+    return __parse_csv_rows(response) if response else None
+
+
+def get_city_series(city_id, first=None, last=None):
+    """
+    Gets the history of one city (read by the server from the city-major copy of the frames)
+    :param city_id: kod_obce of the city
+    :param first: First day, default is the start of the simulation
+    :param last: Last day (included), default is the last day of the simulation
+    :return: List of dicts with keys datum, pocet_obyvatel, pocet_nakazenych or None if the city doesn't exist
+    """
+    message = f"series {city_id}"
+    if first is not None or last is not None:
+        message += f" {first or 0} {-1 if last is None else last}"
+    response = query(message.encode())
+    return __parse_csv_rows(response) if response else None
+
+
+def lod_for_zoom(zoom):
+    """
+    Chooses level of detail of the bounding box query for the zoom of the map
+    :param zoom: Zoom of the mapbox (BBOX_CITY_ZOOM and more shows the cities)
+    :return: Level of detail, 0 (cities) .. BBOX_MAX_LOD (one cell)
+    """
+    if zoom >= BBOX_CITY_ZOOM:
+        return 0
+    return min(BBOX_MAX_LOD, int(math.ceil(BBOX_CITY_ZOOM - zoom)))
+
+
+def get_bbox(day, lat1, lon1, lat2, lon2, lod=0):
+    """
+    Gets the cities in the bounding box, aggregated into cells of the server grid if lod > 0
+    :param day: Number of the day (frame of the simulation)
+    :param lat1: Latitude of one corner
+    :param lon1: Longitude of one corner
+    :param lat2: Latitude of the opposite corner
+    :param lon2: Longitude of the opposite corner
+    :param lod: Level of detail (see lod_for_zoom)
+    :return: List of dicts with keys kod_obce, pocet_obyvatel, pocet_nakazenych (lod 0) or latitude, longitude,
+             pocet_obci, pocet_obyvatel, pocet_nakazenych (cells) or None if the day doesn't exist
+    """
+    response = query(f"send_bbox {day} {lat1} {lon1} {lat2} {lon2} {lod}".encode())
+    return __parse_csv_rows(response) if response else None
+
+
+# FRAME DECODING
+
+
+__frame_ids = None
+__frame_values = None
+__frame_number = -1
+
+
+def __read_varint(data, position):
+    """
+    Reads varint (7 bits per byte, lowest bits first) from data
+    :param data: Bytes
+    :param position: Position of the varint
+    :return: Tuple (value, position after the varint)
+    """
+    value = 0
+    shift = 0
+    while True:
+        byte = data[position]
+        position += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, position
+        shift += 7
+
+
+def decode_frame(data, previous, count):
+    """
+    Decodes frame encoded by frameCodec.c (zigzag deltas, varints, runs of unchanged values)
+    :param data: Encoded bytes
+    :param previous: Values of the base frame or None for key frame
+    :param count: Number of values in the frame
+    :return: List of values (population of all the cities followed by infected of all the cities)
+    """
+    values = []
+    position = 0
+    while position < len(data):
+        if data[position] == 0:
+            run, position = __read_varint(data, position + 1)
+            values.extend(previous[len(values):len(values) + run] if previous else [0] * run)
+            continue
+        token, position = __read_varint(data, position)
+        base = previous[len(values)] if previous else 0
+        values.append((base + ((token >> 1) ^ -(token & 1)) + 2 ** 31) % 2 ** 32 - 2 ** 31)
+    if len(values) != count:
+        raise ValueError("Frame contains %d values instead of %d" % (len(values), count))
+    return values
+
+
+def __frame_to_csv(frame_number):
+    """
+    Formats the last downloaded frame in the same way as server does
+    :param frame_number: Number of the frame
+    :return: CSV string ending with \\x04
+    """
+    count = len(__frame_ids)
+    lines = ["kod_obce,pocet_obyvatel,pocet_nakazenych,datum"]
+    for i in range(count):
+        lines.append(f"{__frame_ids[i]},{__frame_values[i]},{__frame_values[count + i]},{frame_number}")
+    return "\n".join(lines) + "\n\x04"
+
+
+def __download_frames_binary(first_frame, last_frame):
+    """
+    Downloads frames from server in binary mode (int32 arrays, no parsing), ids of the cities are downloaded once
+    :param first_frame: Number of the first frame
+    :param last_frame: Number of the last frame
+    :return: List of CSV strings of the frames (same as response to 'send_data <n>')
+    """
+    global __frame_ids, __frame_values, __frame_number
+    messages = [f"send_range {first_frame} {last_frame}".encode()]
+    if __frame_ids is None:
+        messages.insert(0, b"cities")
+
+    frames = []
+    for response in binary_request(messages):
+        for msg_type, payload in response:
+            if msg_type == MSG_TYPE_CITIES:
+                __frame_ids = parse_cities_message(payload).tolist()
+            elif msg_type == MSG_TYPE_FRAME and __frame_ids is not None:
+                __frame_number, values = parse_frame_message(payload)
+                __frame_values = values.tolist()
+                frames.append(__frame_to_csv(__frame_number))
+    return frames
+
+
+def download_frames(first_frame, count=RANGE_LENGTH):
+    """
+    Downloads consecutive frames from server with one send_range request
+    If the previous frame was downloaded, only deltas are transferred,
+    otherwise the first frame is requested as CSV (it contains ids of the cities)
+    :param first_frame: Number of the first frame
+    :param count: Maximal number of frames
+    :return: List of CSV strings of the frames (same as response to 'send_data <n>'),
+             ends before the first frame which is not available
+    """
+    global __frame_ids, __frame_values, __frame_number
+    last_frame = first_frame + count - 1
+    has_previous = __frame_values is not None and __frame_number == first_frame - 1
+
+    if BINARY_TRANSFER:
+        return __download_frames_binary(first_frame, last_frame)
+
+    if not DELTA_TRANSFER:
+        messages = [f"send_range {first_frame} {last_frame}".encode()]
+    elif has_previous:
+        messages = [f"send_range {first_frame} {last_frame} 1 delta {first_frame - 1}".encode()]
+    else:
+        messages = [f"send_range {first_frame} {first_frame}".encode(),
+                    f"send_range {first_frame + 1} {last_frame} 1 delta {first_frame}".encode()]
+
+    frames = []
+    for response in request(messages):
+        if response.startswith(NO_DATA[:-1].encode()):
+            break
+        for frame_number, base, data in parse_frames(response):
+            if base is None:
+                rows = [line.split(",") for line in data.decode().split("\n")[1:] if "," in line]
+                __frame_ids = [row[0] for row in rows]
+                values = [int(row[1]) for row in rows] + [int(row[2]) for row in rows]
+            else:
+                values = decode_frame(data, __frame_values if base >= 0 else None, len(__frame_values))
+
+            __frame_values = values
+            __frame_number = frame_number
+            frames.append(__frame_to_csv(frame_number))
+    return frames
+
+
+def download_frame(frame_number):
+    """
+    Downloads frame from server, if the previous frame was downloaded, only delta is transferred
+    :param frame_number: Number of the frame
+    :return: CSV string of the frame (same as response to 'send_data <n>') or 'no data'
+    """
+    frames = download_frames(frame_number, 1)
+    return frames[0] if frames else NO_DATA
+
+
+def __receive_pushed_frame(frame_number, values, frames_queue):
+    """
+    Puts the frame pushed by server into the queue
+    If some frames were skipped (server pushes only the latest frame to a slow client)
+    or the frame couldn't be decoded, the missing frames are downloaded with send_range
+    :param frame_number: Number of the pushed frame
+    :param values: Values of the frame or None if it couldn't be decoded
+    :param frames_queue: Queue for CSV strings of the frames
+    :return: no return value
+    """
+    global __frame_values, __frame_number
+    if frame_number <= __frame_number:
+        return
+    if frame_number == __frame_number + 1 and values is not None and __frame_ids is not None:
+        __frame_values = values
+        __frame_number = frame_number
+        frames_queue.put(__frame_to_csv(frame_number))
+        return
+
+    while __frame_number < frame_number:
+        frames = download_frames(__frame_number + 1, min(RANGE_LENGTH, frame_number - __frame_number))
+        if not frames:
+            return
+        for csv_str in frames:
+            frames_queue.put(csv_str)
+
+
+def __receive_pushed_text(response, frames_queue):
+    """
+    Decodes the frame pushed by server in text mode (encoded against the previously pushed frame)
+    :param response: Pushed response (without \\x04)
+    :param frames_queue: Queue for CSV strings of the frames
+    :return: no return value
+    """
+    if not response.startswith(b"frame ") and not response.startswith(b"csv "):
+        return
+    for frame_number, base, data in parse_frames(response):
+        values = None
+        if __frame_values is not None and base is not None and base in (-1, __frame_number):
+            values = decode_frame(data, __frame_values if base >= 0 else None, len(__frame_values))
+        __receive_pushed_frame(frame_number, values, frames_queue)
+
+
+def subscribe_frames(frames_queue):
+    """
+    Subscribes to the new frames and puts them (CSV strings, same as response to 'send_data <n>') into the queue
+    in order, without gaps. Runs forever (in its own thread), the subscription is renewed if the connection is lost
+    :param frames_queue: Queue for CSV strings of the frames
+    :return: no return value
+    """
+    while True:
+        sock = connect_binary() if BINARY_TRANSFER else create_and_connect_socket()
+        if sock is not None:
+            try:
+                if BINARY_TRANSFER and __sock_send(sock, b"subscribe\x04"):
+                    for msg_type, payload in socket_messages(sock):
+                        if msg_type == MSG_TYPE_FRAME:
+                            frame_number, values = parse_frame_message(payload)
+                            __receive_pushed_frame(frame_number, values.tolist(), frames_queue)
+                elif not BINARY_TRANSFER and __sock_send(sock, b"subscribe delta\x04"):
+                    for response in socket_responses(sock):
+                        __receive_pushed_text(response, frames_queue)
+            except (socket.error, ValueError, IndexError, struct.error):
+                print("Error: subscription lost.")
+            sock.close()
+        time.sleep(SUBSCRIBE_RETRY_DELAY)
+
+
 # SETTERS
 
 
@@ -1,6 +1,8 @@
 import sys
 import os
 import signal
+import queue
+import threading
 from dash import dcc, html
 from dash_extensions.enrich import Input, Output, State, DashProxy, MultiplexerTransform
 import dash_bootstrap_components as dbc
@@ -14,6 +16,9 @@ if len(sys.argv) == 3:
 
 create_first_frame()
 
+# frames pushed by server (utils.subscribe_frames), the visualization only takes them from the queue
+received_frames = queue.Queue()
+
 app = DashProxy(
     name="visuals",
     prevent_initial_callbacks=True,
@@ -226,15 +231,20 @@ def download_data(update_input):
     :return: Figure with updated DataFrame
     """
     old_frame = utils.frame
-    csv_str = socket_send_and_read(f"send_data {old_frame}".encode()).decode()
-    update_data_csv(csv_str)
+    if utils.SUBSCRIBE:
+        while not received_frames.empty():
+            update_data_csv(received_frames.get())
+    else:
+        for csv_str in download_frames(old_frame):
+            update_data_csv(csv_str)
 
     new_frame = utils.frame
     marks = {i: f'{i}' for i in range(0, new_frame + 1, (10 * int(new_frame / 50)) if new_frame >= 50 else 1)}
     marks[new_frame] = f'{new_frame}'
 
     if old_frame == new_frame:
-        return new_frame, marks, 10000
+        # with subscription, waiting for new frames costs nothing on the server
+        return new_frame, marks, 500 if utils.SUBSCRIBE else 10000
     else:
         return new_frame, marks, 100
 
@@ -257,7 +267,15 @@ def update_figure(chosen_frame, curr_fig, z_value, radius_value):
     :return: Figure with updated dataframe
     """
 
-    return update_img(chosen_frame, curr_fig, z_coef=z_value, radius_coef=radius_value), \
+    fig = update_img(chosen_frame, curr_fig, z_coef=z_value, radius_coef=radius_value)
+    # totals computed by the simulation (frame n of the visualization is the day n - 1 of the simulation)
+    stats = get_stats(chosen_frame - 1) if chosen_frame > 0 else None
+    if stats is not None:
+        utils.total_infected = stats["pocet_nakazenych"]
+        if stats["novych_nakazenych"] >= 0:
+            utils.new_infected = stats["novych_nakazenych"]
+
+    return fig, \
         "Total number of infected: " + '{:,}'.format(utils.total_infected).replace(',', ' '), \
         "Newly infected: " + '{:,}'.format(utils.new_infected).replace(',', ' ')
 
@@ -389,4 +407,6 @@ def kill_simulation(kill_input):
 if __name__ == '__main__':
     if not socket_send(b"start"):
         print("Could not send 'start' to server")
+    if utils.SUBSCRIBE:
+        threading.Thread(target=subscribe_frames, args=(received_frames,), daemon=True).start()
     app.run_server(debug=False, use_reloader=False)
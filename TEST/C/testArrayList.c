@@ -1,3 +1,4 @@
+#include <stdlib.h>
 #include "Unity/src/unity.h"
 #include "../../C/simulation/arrayList.h"
 
@@ -109,6 +110,26 @@ void test_arrayListRemoveElement_should_not_remove_3(void) {
     TEST_ASSERT_NULL(pointer);
 }
 
+void test_arrayListCompact_should_remove_nulls(void) {
+    arrayList *al = createArrayList(2, sizeof(int));
+    int *items[5], i;
+    for (i = 0; i < 5; i++) {
+        items[i] = malloc(sizeof(int));
+        arrayListAdd(al, items[i]);
+    }
+    free(items[0]);
+    free(items[3]);
+    al->data[0] = NULL;
+    al->data[3] = NULL;
+    TEST_ASSERT_EQUAL(2, arrayListCompact(al));
+    TEST_ASSERT_EQUAL(3, al->filledItems);
+    TEST_ASSERT_EQUAL_PTR(items[1], arrayListGetPointer(al, 0));
+    TEST_ASSERT_EQUAL_PTR(items[2], arrayListGetPointer(al, 1));
+    TEST_ASSERT_EQUAL_PTR(items[4], arrayListGetPointer(al, 2));
+    TEST_ASSERT_NULL(arrayListGetPointer(al, 3));
+    freeArrayList(&al);
+}
+
 void test_freeArrayList(void) {
     arrayList *al = createArrayList(10, sizeof(int));
     freeArrayList(&al);
@@ -135,6 +156,7 @@ int main(void) {
     RUN_TEST(test_arrayListRemoveElement_should_not_remove_1);
     RUN_TEST(test_arrayListRemoveElement_should_not_remove_2);
     RUN_TEST(test_arrayListRemoveElement_should_not_remove_3);
+    RUN_TEST(test_arrayListCompact_should_remove_nulls);
     RUN_TEST(test_freeArrayList);
     return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "Unity/src/unity.h"
+#include "../../C/simulation/citySeries.h"
+
+#define TEST_SERIES "test_series.dat"
+#define CITIES 3
+
+void setUp(void) {}
+
+static void addDays(citySeries *series, int from, int to) {
+    int population[CITIES], infected[CITIES], date, i;
+    for (date = from; date <= to; date++) {
+        for (i = 0; i < CITIES; i++) {
+            population[i] = 1000 * i + date;
+            infected[i] = date;
+        }
+        TEST_ASSERT_EQUAL(EXIT_SUCCESS, citySeriesAdd(series, date, population, infected));
+    }
+}
+
+void test_createCitySeries_should_be_null(void) {
+    TEST_ASSERT_NULL(createCitySeries(TEST_SERIES, 0));
+    TEST_ASSERT_NULL(openCitySeries("non-existant.dat", 0));
+}
+
+void test_citySeriesAdd_should_read_back(void) {
+    int values[2 * CITY_SERIES_FLUSH_DAYS];
+    citySeries *series = createCitySeries(TEST_SERIES, CITIES);
+    citySeries *reader = openCitySeries(TEST_SERIES, 0);
+    TEST_ASSERT_NOT_NULL(series);
+    TEST_ASSERT_NOT_NULL(reader);
+
+    //buffered days are not written yet
+    addDays(series, 0, CITY_SERIES_FLUSH_DAYS - 2);
+    TEST_ASSERT_EQUAL(0, citySeriesDays(reader));
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, citySeriesRead(reader, 1, 0, 0, values));
+
+    addDays(series, CITY_SERIES_FLUSH_DAYS - 1, CITY_SERIES_FLUSH_DAYS + 2);
+    TEST_ASSERT_EQUAL(CITY_SERIES_FLUSH_DAYS, citySeriesDays(reader));
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, citySeriesRead(reader, 1, 0, CITY_SERIES_FLUSH_DAYS - 1, values));
+    TEST_ASSERT_EQUAL(1000, values[0]);
+    TEST_ASSERT_EQUAL(0, values[1]);
+    TEST_ASSERT_EQUAL(1000 + CITY_SERIES_FLUSH_DAYS - 1, values[2 * CITY_SERIES_FLUSH_DAYS - 2]);
+    TEST_ASSERT_EQUAL(CITY_SERIES_FLUSH_DAYS - 1, values[2 * CITY_SERIES_FLUSH_DAYS - 1]);
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, citySeriesRead(reader, 1, 0, CITY_SERIES_FLUSH_DAYS, values));
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, citySeriesRead(reader, CITIES, 0, 0, values));
+
+    //already added day
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, citySeriesAdd(series, 3, values, values));
+    freeCitySeries(&series);
+    freeCitySeries(&reader);
+    TEST_ASSERT_NULL(series);
+}
+
+void test_citySeriesRead_more_segments(void) {
+    int *values = malloc(2 * 3 * CITY_SERIES_SEGMENT_DAYS * sizeof(int));
+    int date;
+    citySeries *series = createCitySeries(TEST_SERIES, CITIES);
+
+    addDays(series, 0, 3 * CITY_SERIES_SEGMENT_DAYS - 1);
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, citySeriesRead(series, 2, 10, 3 * CITY_SERIES_SEGMENT_DAYS - 1, values));
+    for (date = 10; date < 3 * CITY_SERIES_SEGMENT_DAYS; date++) {
+        TEST_ASSERT_EQUAL(2000 + date, values[2 * (date - 10)]);
+        TEST_ASSERT_EQUAL(date, values[2 * (date - 10) + 1]);
+    }
+    freeCitySeries(&series);
+    free(values);
+}
+
+void test_citySeriesAdd_gap_and_resume(void) {
+    int values[2 * 2 * CITY_SERIES_FLUSH_DAYS];
+    citySeries *series = createCitySeries(TEST_SERIES, CITIES);
+
+    addDays(series, 0, 0);
+    addDays(series, 5, CITY_SERIES_FLUSH_DAYS + 1);
+    freeCitySeries(&series);
+
+    //days after the last written day are added again after resuming
+    series = openCitySeries(TEST_SERIES, 1);
+    TEST_ASSERT_NOT_NULL(series);
+    TEST_ASSERT_EQUAL(CITY_SERIES_FLUSH_DAYS, series->days);
+    addDays(series, CITY_SERIES_FLUSH_DAYS, 2 * CITY_SERIES_FLUSH_DAYS - 1);
+
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, citySeriesRead(series, 0, 0, 2 * CITY_SERIES_FLUSH_DAYS - 1, values));
+    TEST_ASSERT_EQUAL(0, values[0]);
+    TEST_ASSERT_EQUAL(CITY_SERIES_MISSING, values[2]);
+    TEST_ASSERT_EQUAL(CITY_SERIES_MISSING, values[9]);
+    TEST_ASSERT_EQUAL(5, values[10]);
+    TEST_ASSERT_EQUAL(2 * CITY_SERIES_FLUSH_DAYS - 1, values[4 * CITY_SERIES_FLUSH_DAYS - 1]);
+    freeCitySeries(&series);
+}
+
+void tearDown(void) {
+    remove(TEST_SERIES);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_createCitySeries_should_be_null);
+    RUN_TEST(test_citySeriesAdd_should_read_back);
+    RUN_TEST(test_citySeriesRead_more_segments);
+    RUN_TEST(test_citySeriesAdd_gap_and_resume);
+    return UNITY_END();
+}
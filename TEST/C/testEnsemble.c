@@ -0,0 +1,79 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "Unity/src/unity.h"
+#include "../../C/simulation/ensemble.h"
+#include "../../C/simulation/fileManager.h"
+
+#define REPLICATES 5
+#define DAYS 2
+
+country *geography;
+
+void setUp(void) {
+    FILE *fp = fopen("test.csv", "w");
+    fprintf(fp, "nazev_obce,kod_obce,latitude,longitude,vymera,pocet_obyvatel,pocet_nakazenych,datum\n");
+    fprintf(fp, "A,1,49.5,14.5,10.0,2000,50,0\nB,2,49.6,14.7,5.0,800,0,0\nC,3,50.0,15.0,20.0,1200,10,0\n");
+    fclose(fp);
+
+    load_parameters("../../parameters.cfg");
+    geography = create_country_from_csv("test.csv", 0);
+    remove("test.csv");
+}
+
+void test_ensembleQuantile(void) {
+    int values[] = {9, 1, 5, 3, 7, 2, 8, 4, 10, 6};
+    TEST_ASSERT_EQUAL(1, ensembleQuantile(values, 10, 0.05));
+    TEST_ASSERT_EQUAL(5, ensembleQuantile(values, 10, 0.5));
+    TEST_ASSERT_EQUAL(10, ensembleQuantile(values, 10, 0.95));
+    TEST_ASSERT_EQUAL(10, ensembleQuantile(values, 10, 1));
+}
+
+void test_ensemble_does_not_depend_on_threads(void) {
+    ensemble *single = createEnsemble(geography, REPLICATES, 1, 42);
+    ensemble *pool = createEnsemble(geography, REPLICATES, 3, 42);
+    int single_bands[3 * ENSEMBLE_BANDS], pool_bands[3 * ENSEMBLE_BANDS], day;
+
+    TEST_ASSERT_NOT_NULL(single);
+    TEST_ASSERT_NOT_NULL(pool);
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, ensembleRun(single, DAYS));
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, ensembleRun(pool, DAYS));
+    TEST_ASSERT_EQUAL(0, memcmp(single->infected, pool->infected, REPLICATES * 3 * sizeof(int)));
+    TEST_ASSERT_EQUAL(0, memcmp(single->population, pool->population, REPLICATES * 3 * sizeof(int)));
+    for (day = 0; day < DAYS; day++) {
+        TEST_ASSERT_EQUAL(EXIT_SUCCESS, ensembleBands(single, day, single_bands));
+        TEST_ASSERT_EQUAL(EXIT_SUCCESS, ensembleBands(pool, day, pool_bands));
+        TEST_ASSERT_EQUAL(0, memcmp(single_bands, pool_bands, sizeof(single_bands)));
+    }
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, ensembleRun(pool, DAYS));
+    freeEnsemble(&single);
+    freeEnsemble(&pool);
+    TEST_ASSERT_NULL(pool);
+}
+
+void test_ensembleBands_are_ordered(void) {
+    ensemble *theEnsemble = createEnsemble(geography, REPLICATES, 2, 7);
+    int bands[3 * ENSEMBLE_BANDS], city;
+
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, ensembleBands(theEnsemble, 0, bands));
+    ensembleRun(theEnsemble, DAYS);
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, ensembleBands(theEnsemble, DAYS, bands));
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, ensembleBands(theEnsemble, DAYS - 1, bands));
+    for (city = 0; city < 3; city++) {
+        TEST_ASSERT_TRUE(bands[city * ENSEMBLE_BANDS] <= bands[city * ENSEMBLE_BANDS + 1]);
+        TEST_ASSERT_TRUE(bands[city * ENSEMBLE_BANDS + 1] <= bands[city * ENSEMBLE_BANDS + 2]);
+    }
+    freeEnsemble(&theEnsemble);
+}
+
+void tearDown(void) {
+    freeCountry(&geography);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_ensembleQuantile);
+    RUN_TEST(test_ensemble_does_not_depend_on_threads);
+    RUN_TEST(test_ensembleBands_are_ordered);
+    return UNITY_END();
+}
@@ -1,3 +1,4 @@
+#include <stdlib.h>
 #include "Unity/src/unity.h"
 #include "../../C/simulation/fileManager.h"
 
@@ -19,6 +20,31 @@ void test_create_country_from_csv_should_not_create_2(void) {
     TEST_ASSERT_NULL(c);
 }
 
+void test_create_country_from_csv_ending_with_new_line(void) {
+    FILE *fp = fopen("test.csv", "w");
+    fprintf(fp, "nazev_obce,kod_obce,latitude,longitude,vymera,pocet_obyvatel,pocet_nakazenych,datum\n");
+    fprintf(fp, "A,1,49.5,14.5,10.0,100,2,0\n\nB,2,50.0,15.0,5.0,40,0,0\n");
+    fclose(fp);
+
+    country *c = create_country_from_csv("test.csv", 1);
+    TEST_ASSERT_NOT_NULL(c);
+    TEST_ASSERT_EQUAL(2, c->numberOfCities);
+    TEST_ASSERT_EQUAL(2, c->cities[1]->city_id);
+    TEST_ASSERT_EQUAL(140, c->movedCitizensLength);
+    freeCountry(&c);
+    remove("test.csv");
+}
+
+void test_create_country_from_csv_without_population(void) {
+    FILE *fp = fopen("test.csv", "w");
+    fprintf(fp, "nazev_obce,kod_obce,latitude,longitude,vymera,pocet_obyvatel,pocet_nakazenych,datum\n");
+    fprintf(fp, "A,1,49.5,14.5,10.0,0,0,0\n");
+    fclose(fp);
+
+    TEST_ASSERT_NULL(create_country_from_csv("test.csv", 1));
+    remove("test.csv");
+}
+
 void test_create_csv_from_country_should_create(void) {
     country *c = create_country_from_csv("../../DATA/initial.csv", 1);
     create_csv_from_country(c, "test.csv", 0);
@@ -36,6 +62,27 @@ void test_create_csv_from_country_should_not_create(void) {
     fclose(fp);
 }
 
+void test_load_parameters_without_optional_parameters(void) {
+    const double values[PARAMETER_REQUIRED_COUNT] = {20, 60, 0.2, 14, 4, 60, 15, 0.1, 0.45, 0.14, 0.6, 0.95, 0.1};
+    int i;
+    FILE *fp = fopen("test.cfg", "w");
+    fprintf(fp, "#parameters.cfg from the time before dormant days\n");
+    for (i = 0; i < PARAMETER_REQUIRED_COUNT; i++) fprintf(fp, "parameter %d: %g\n", i, values[i]);
+    fclose(fp);
+
+    PARAMETERS.dormantDays = 7;
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, load_parameters("test.cfg"));
+    TEST_ASSERT_EQUAL(DORMANT_DAYS_DEFAULT, PARAMETERS.dormantDays);
+    TEST_ASSERT_EQUAL(14, PARAMETERS.infectionTimeMean);
+
+    //optional parameter must still be valid if it is there
+    fp = fopen("test.cfg", "a");
+    fprintf(fp, "dormant days: -1\n");
+    fclose(fp);
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, load_parameters("test.cfg"));
+    remove("test.cfg");
+}
+
 void tearDown(void) {}
 
 int main(void) {
@@ -43,7 +90,10 @@ int main(void) {
     RUN_TEST(test_create_country_from_csv_should_create);
     RUN_TEST(test_create_country_from_csv_should_not_create_1);
     RUN_TEST(test_create_country_from_csv_should_not_create_2);
+    RUN_TEST(test_create_country_from_csv_ending_with_new_line);
+    RUN_TEST(test_create_country_from_csv_without_population);
     RUN_TEST(test_create_csv_from_country_should_create);
     RUN_TEST(test_create_csv_from_country_should_not_create);
+    RUN_TEST(test_load_parameters_without_optional_parameters);
     return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include <stdlib.h>
+#include "Unity/src/unity.h"
+#include "../../C/simulation/frameCodec.h"
+
+#define COUNT 1000
+
+void setUp(void) {}
+
+void test_frameEncode_round_trip_key_frame(void) {
+    int values[COUNT], decoded[COUNT], i;
+    unsigned char buffer[COUNT * VARINT_MAX_BYTES];
+    for (i = 0; i < COUNT; i++) values[i] = i % 7 == 0 ? 0 : rand() - RAND_MAX / 2;
+    values[1] = 2147483647;
+    values[2] = -2147483647 - 1;
+
+    size_t length = frameEncode(values, NULL, COUNT, buffer);
+    TEST_ASSERT_TRUE(length <= frameEncodeMaxSize(COUNT));
+    TEST_ASSERT_EQUAL(0, frameDecode(buffer, length, NULL, decoded, COUNT));
+    TEST_ASSERT_EQUAL_INT_ARRAY(values, decoded, COUNT);
+}
+
+void test_frameEncode_round_trip_delta_frame(void) {
+    int previous[COUNT], values[COUNT], decoded[COUNT], i;
+    unsigned char buffer[COUNT * VARINT_MAX_BYTES];
+    for (i = 0; i < COUNT; i++) {
+        previous[i] = rand();
+        values[i] = i % 10 == 0 ? previous[i] + rand() % 100 - 50 : previous[i];
+    }
+
+    size_t length = frameEncode(values, previous, COUNT, buffer);
+    TEST_ASSERT_TRUE(length < COUNT);
+    TEST_ASSERT_EQUAL(0, frameDecode(buffer, length, previous, decoded, COUNT));
+    TEST_ASSERT_EQUAL_INT_ARRAY(values, decoded, COUNT);
+    //decoding in place
+    TEST_ASSERT_EQUAL(0, frameDecode(buffer, length, previous, previous, COUNT));
+    TEST_ASSERT_EQUAL_INT_ARRAY(values, previous, COUNT);
+}
+
+void test_frameEncode_unchanged_frame_should_be_one_run(void) {
+    int values[COUNT] = {0};
+    unsigned char buffer[COUNT * VARINT_MAX_BYTES];
+    size_t length = frameEncode(values, values, COUNT, buffer);
+    TEST_ASSERT_EQUAL(3, length);
+    TEST_ASSERT_EQUAL(ZERO_RUN_TOKEN, buffer[0]);
+}
+
+void test_frameDecode_should_not_decode_1(void) {
+    int values[COUNT] = {0}, decoded[COUNT];
+    unsigned char buffer[COUNT * VARINT_MAX_BYTES];
+    size_t length = frameEncode(values, NULL, COUNT, buffer);
+    TEST_ASSERT_EQUAL(1, frameDecode(buffer, length, NULL, decoded, COUNT - 1));
+    TEST_ASSERT_EQUAL(1, frameDecode(buffer, length, NULL, decoded, COUNT + 1));
+}
+
+void test_frameDecode_should_not_decode_2(void) {
+    int decoded[2];
+    unsigned char truncated[] = {0x81};
+    TEST_ASSERT_EQUAL(1, frameDecode(truncated, 1, NULL, decoded, 2));
+    TEST_ASSERT_EQUAL(1, frameDecode(NULL, 1, NULL, decoded, 2));
+}
+
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_frameEncode_round_trip_key_frame);
+    RUN_TEST(test_frameEncode_round_trip_delta_frame);
+    RUN_TEST(test_frameEncode_unchanged_frame_should_be_one_run);
+    RUN_TEST(test_frameDecode_should_not_decode_1);
+    RUN_TEST(test_frameDecode_should_not_decode_2);
+    return UNITY_END();
+}
@@ -0,0 +1,105 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "Unity/src/unity.h"
+#include "../../C/simulation/frameRing.h"
+
+#define CITIES 100
+#define DAYS 20000
+
+void setUp(void) {}
+
+static void fillFrame(int date, int *population, int *infected) {
+    int i;
+    for (i = 0; i < CITIES; i++) {
+        population[i] = date * 1000 + i;
+        infected[i] = date;
+    }
+}
+
+void test_frameRing_read_published(void) {
+    int population[CITIES], infected[CITIES], readPopulation[CITIES], readInfected[CITIES];
+    frameRing *ring = createFrameRing(CITIES);
+    TEST_ASSERT_NOT_NULL(ring);
+    TEST_ASSERT_EQUAL(-1, frameRingLatest(ring));
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, frameRingRead(ring, 0, readPopulation, readInfected));
+
+    fillFrame(0, population, infected);
+    frameRingPublish(ring, 0, population, infected);
+    fillFrame(1, population, infected);
+    frameRingPublish(ring, 1, population, infected);
+
+    TEST_ASSERT_EQUAL(1, frameRingLatest(ring));
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, frameRingRead(ring, 1, readPopulation, readInfected));
+    TEST_ASSERT_EQUAL_INT_ARRAY(population, readPopulation, CITIES);
+    TEST_ASSERT_EQUAL_INT_ARRAY(infected, readInfected, CITIES);
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, frameRingRead(ring, 0, readPopulation, readInfected));
+    TEST_ASSERT_EQUAL(0, readInfected[0]);
+    //not published yet
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, frameRingRead(ring, 2, readPopulation, readInfected));
+    freeFrameRing(&ring);
+    TEST_ASSERT_NULL(ring);
+}
+
+void test_frameRing_old_days_are_overwritten(void) {
+    int population[CITIES], infected[CITIES], date;
+    frameRing *ring = createFrameRing(CITIES);
+
+    for (date = 0; date < FRAME_RING_CAPACITY + 10; date++) {
+        fillFrame(date, population, infected);
+        frameRingPublish(ring, date, population, infected);
+    }
+    //days 10 .. FRAME_RING_CAPACITY + 9 are kept
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, frameRingRead(ring, 9, population, infected));
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, frameRingRead(ring, 10, population, infected));
+    TEST_ASSERT_EQUAL(10, infected[CITIES - 1]);
+    freeFrameRing(&ring);
+}
+
+static void *publishDays(void *arg) {
+    frameRing *ring = arg;
+    int population[CITIES], infected[CITIES], date;
+    for (date = 0; date < DAYS; date++) {
+        fillFrame(date, population, infected);
+        frameRingPublish(ring, date, population, infected);
+    }
+    return NULL;
+}
+
+void test_frameRing_reader_never_sees_torn_frame(void) {
+    int population[CITIES], infected[CITIES], expectedPopulation[CITIES], expectedInfected[CITIES];
+    int latest, date, torn = 0;
+    frameRing *ring = createFrameRing(CITIES);
+    pthread_t writer;
+
+    pthread_create(&writer, NULL, publishDays, ring);
+    do {
+        latest = frameRingLatest(ring);
+        for (date = latest; date >= 0 && date > latest - FRAME_RING_CAPACITY; date -= 7) {
+            if (frameRingRead(ring, date, population, infected) == EXIT_FAILURE) continue;
+            fillFrame(date, expectedPopulation, expectedInfected);
+            if (memcmp(population, expectedPopulation, sizeof(population)) ||
+                memcmp(infected, expectedInfected, sizeof(infected)))
+                torn++;
+        }
+    } while (latest < DAYS - 1);
+    pthread_join(writer, NULL);
+
+    TEST_ASSERT_EQUAL(0, torn);
+    freeFrameRing(&ring);
+}
+
+void test_createFrameRing_should_not_create(void) {
+    TEST_ASSERT_NULL(createFrameRing(0));
+}
+
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_frameRing_read_published);
+    RUN_TEST(test_frameRing_old_days_are_overwritten);
+    RUN_TEST(test_frameRing_reader_never_sees_torn_frame);
+    RUN_TEST(test_createFrameRing_should_not_create);
+    return UNITY_END();
+}
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <string.h>
+#include "Unity/src/unity.h"
+#include "../../C/simulation/frameStore.h"
+
+#define TEST_DATA "test_frames.dat"
+#define TEST_INDEX "test_frames.idx"
+
+int cityIds[3] = {554782, 529303, 530000};
+int population[3] = {100, 200, 300};
+int infected[3] = {1, 2, 3};
+
+void setUp(void) {}
+
+void test_createFrameStore_should_not_be_null(void) {
+    frameStore *store = createFrameStore(TEST_DATA, TEST_INDEX, cityIds, 3);
+    TEST_ASSERT_NOT_NULL(store);
+    TEST_ASSERT_EQUAL(0, frameStoreFrames(store));
+    freeFrameStore(&store);
+}
+
+void test_createFrameStore_should_be_null(void) {
+    frameStore *store = createFrameStore(TEST_DATA, TEST_INDEX, cityIds, 0);
+    TEST_ASSERT_NULL(store);
+}
+
+void test_openFrameStore_should_be_null(void) {
+    frameStore *store = openFrameStore("non-existant.dat", "non-existant.idx", 0);
+    TEST_ASSERT_NULL(store);
+}
+
+void test_frameStoreAppend_should_read_back(void) {
+    int readPopulation[3], readInfected[3];
+    frameStore *store = createFrameStore(TEST_DATA, TEST_INDEX, cityIds, 3);
+    frameStore *reader = openFrameStore(TEST_DATA, TEST_INDEX, 0);
+    TEST_ASSERT_EQUAL(0, frameStoreAppend(store, 0, population, infected));
+    TEST_ASSERT_EQUAL(0, frameStoreAppend(store, 1, infected, population));
+
+    TEST_ASSERT_EQUAL(2, frameStoreFrames(reader));
+    TEST_ASSERT_EQUAL_INT_ARRAY(cityIds, reader->cityIds, 3);
+    TEST_ASSERT_EQUAL(0, frameStoreReadFrame(reader, 1, readPopulation, readInfected));
+    TEST_ASSERT_EQUAL_INT_ARRAY(infected, readPopulation, 3);
+    TEST_ASSERT_EQUAL_INT_ARRAY(population, readInfected, 3);
+    TEST_ASSERT_EQUAL(0, frameStoreReadFrame(reader, 0, readPopulation, readInfected));
+    TEST_ASSERT_EQUAL_INT_ARRAY(population, readPopulation, 3);
+    TEST_ASSERT_EQUAL_INT_ARRAY(infected, readInfected, 3);
+    freeFrameStore(&store);
+    freeFrameStore(&reader);
+}
+
+void test_frameStoreAppend_should_drop_newer_days(void) {
+    int readPopulation[3], readInfected[3];
+    frameStore *store = createFrameStore(TEST_DATA, TEST_INDEX, cityIds, 3);
+    frameStoreAppend(store, 0, population, infected);
+    frameStoreAppend(store, 1, population, infected);
+    frameStoreAppend(store, 2, population, infected);
+    frameStoreAppend(store, 1, infected, infected);
+    TEST_ASSERT_EQUAL(2, frameStoreFrames(store));
+    frameStoreReadFrame(store, 1, readPopulation, readInfected);
+    TEST_ASSERT_EQUAL_INT_ARRAY(infected, readPopulation, 3);
+    freeFrameStore(&store);
+}
+
+void test_frameStoreAppend_after_failed_write_should_write_key_frame(void) {
+    int readPopulation[3], readInfected[3];
+    FILE *data;
+    frameIndexEntry entry;
+    frameStore *store = createFrameStore(TEST_DATA, TEST_INDEX, cityIds, 3);
+    frameStoreAppend(store, 0, population, infected);
+
+    //data of day 1 can't be written
+    data = store->data;
+    store->data = fopen(TEST_DATA, "rb");
+    TEST_ASSERT_EQUAL(1, frameStoreAppend(store, 1, infected, infected));
+    fclose(store->data);
+    store->data = data;
+
+    TEST_ASSERT_EQUAL(0, frameStoreAppend(store, 2, infected, population));
+    TEST_ASSERT_EQUAL(0, frameStoreReadEntry(store, 2, &entry));
+    TEST_ASSERT_EQUAL(FRAME_ENCODING_KEY, entry.encoding);
+    TEST_ASSERT_EQUAL(1, frameStoreReadFrame(store, 1, readPopulation, readInfected));
+    TEST_ASSERT_EQUAL(0, frameStoreReadFrame(store, 2, readPopulation, readInfected));
+    TEST_ASSERT_EQUAL_INT_ARRAY(infected, readPopulation, 3);
+    TEST_ASSERT_EQUAL_INT_ARRAY(population, readInfected, 3);
+    freeFrameStore(&store);
+}
+
+void test_frameStoreReadFrame_should_seek_any_day(void) {
+    int days[100][2][3], readPopulation[3], readInfected[3], day, i;
+    frameStore *store = createFrameStore(TEST_DATA, TEST_INDEX, cityIds, 3);
+    frameStore *reader = openFrameStore(TEST_DATA, TEST_INDEX, 0);
+    for (day = 0; day < 100; day++) {
+        for (i = 0; i < 3; i++) {
+            days[day][0][i] = population[i] + day % 5;
+            days[day][1][i] = day % 3 ? infected[i] : day;
+        }
+        frameStoreAppend(store, day, days[day][0], days[day][1]);
+    }
+
+    for (i = 0; i < 100; i++) {
+        day = (i * 37) % 100;
+        TEST_ASSERT_EQUAL(0, frameStoreReadFrame(reader, day, readPopulation, readInfected));
+        TEST_ASSERT_EQUAL_INT_ARRAY(days[day][0], readPopulation, 3);
+        TEST_ASSERT_EQUAL_INT_ARRAY(days[day][1], readInfected, 3);
+    }
+    freeFrameStore(&store);
+    freeFrameStore(&reader);
+}
+
+void test_frameStoreReadFrame_should_not_read(void) {
+    int readPopulation[3], readInfected[3];
+    frameStore *store = createFrameStore(TEST_DATA, TEST_INDEX, cityIds, 3);
+    frameStoreAppend(store, 2, population, infected);
+    TEST_ASSERT_EQUAL(1, frameStoreReadFrame(store, 0, readPopulation, readInfected));
+    TEST_ASSERT_EQUAL(1, frameStoreReadFrame(store, 3, readPopulation, readInfected));
+    TEST_ASSERT_EQUAL(0, frameStoreReadFrame(store, 2, readPopulation, readInfected));
+    freeFrameStore(&store);
+}
+
+void test_frameStoreFormatCsv(void) {
+    frameStore *store = createFrameStore(TEST_DATA, TEST_INDEX, cityIds, 3);
+    char buffer[512];
+    size_t length = frameStoreFormatCsv(store, 7, population, infected, buffer);
+    buffer[length] = '\0';
+    TEST_ASSERT_EQUAL(0, strcmp(buffer, "kod_obce,pocet_obyvatel,pocet_nakazenych,datum\n"
+                                        "554782,100,1,7\n529303,200,2,7\n530000,300,3,7\n"));
+    freeFrameStore(&store);
+}
+
+void tearDown(void) {
+    remove(TEST_DATA);
+    remove(TEST_INDEX);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_createFrameStore_should_not_be_null);
+    RUN_TEST(test_createFrameStore_should_be_null);
+    RUN_TEST(test_openFrameStore_should_be_null);
+    RUN_TEST(test_frameStoreAppend_should_read_back);
+    RUN_TEST(test_frameStoreAppend_should_drop_newer_days);
+    RUN_TEST(test_frameStoreAppend_after_failed_write_should_write_key_frame);
+    RUN_TEST(test_frameStoreReadFrame_should_seek_any_day);
+    RUN_TEST(test_frameStoreReadFrame_should_not_read);
+    RUN_TEST(test_frameStoreFormatCsv);
+    return UNITY_END();
+}
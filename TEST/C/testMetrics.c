@@ -0,0 +1,61 @@
+#include <stdlib.h>
+#include <string.h>
+#include "Unity/src/unity.h"
+#include "../../C/simulation/metrics.h"
+
+void setUp(void) {
+    metricsReset();
+}
+
+void test_metricsNow_is_monotonic(void) {
+    long long first = metricsNow();
+    TEST_ASSERT_TRUE(metricsNow() >= first);
+}
+
+void test_metricsPercentile_within_bucket_error(void) {
+    long long p50, p99;
+    int i;
+
+    //1 .. 1000 microseconds
+    for (i = 1; i <= 1000; i++)
+        metricsRecord(METRIC_SPREAD, i * 1000LL);
+
+    p50 = metricsPercentile(METRIC_SPREAD, 0.5);
+    p99 = metricsPercentile(METRIC_SPREAD, 0.99);
+    TEST_ASSERT_TRUE(p50 >= 500000 * (1 - 1.0 / METRICS_SUB_BUCKETS) && p50 <= 500000 * (1 + 1.0 / METRICS_SUB_BUCKETS));
+    TEST_ASSERT_TRUE(p99 >= 990000 * (1 - 1.0 / METRICS_SUB_BUCKETS) && p99 <= 1000000);
+    TEST_ASSERT_EQUAL(1000000, metricsPercentile(METRIC_SPREAD, 1));
+    TEST_ASSERT_EQUAL(1000, atomic_load(&METRICS[METRIC_SPREAD].count));
+    TEST_ASSERT_EQUAL(1000000, atomic_load(&METRICS[METRIC_SPREAD].max));
+    TEST_ASSERT_EQUAL(0, metricsPercentile(METRIC_MOVEMENT, 0.5));
+}
+
+void test_metricsPercentile_small_values_are_exact(void) {
+    metricsRecord(METRIC_DAY, 3);
+    metricsRecord(METRIC_DAY, 5);
+    metricsRecord(METRIC_DAY, 7);
+    TEST_ASSERT_EQUAL(5, metricsPercentile(METRIC_DAY, 0.5));
+}
+
+void test_metricsFormat(void) {
+    char buffer[sizeof(METRICS_HEADER) + METRIC_COUNT * METRICS_MAX_ROW];
+    size_t length;
+
+    metricsRecord(METRIC_CHECKPOINT, 2000000);
+    length = metricsFormat(buffer);
+    TEST_ASSERT_EQUAL(strlen(buffer), length);
+    TEST_ASSERT_EQUAL(0, strncmp(buffer, METRICS_HEADER, strlen(METRICS_HEADER)));
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "checkpoint,1,2.000,2.000,2.000,2.000,2.000,-1,-1,-1,-1\n"));
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "movement,0,0.000,0.000,0.000,0.000,0.000,-1,-1,-1,-1\n"));
+}
+
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_metricsNow_is_monotonic);
+    RUN_TEST(test_metricsPercentile_within_bucket_error);
+    RUN_TEST(test_metricsPercentile_small_values_are_exact);
+    RUN_TEST(test_metricsFormat);
+    return UNITY_END();
+}
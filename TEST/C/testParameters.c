@@ -0,0 +1,54 @@
+#include <stdlib.h>
+#include <math.h>
+#include "Unity/src/unity.h"
+#include "../../C/simulation/parameters.h"
+
+parameters params;
+
+void setUp(void) {
+    params.meetingFactor = 0.2;
+    params.infectionTimeMean = 14;
+}
+
+void test_parameterIndex_follows_parameters_cfg(void) {
+    TEST_ASSERT_EQUAL(0, parameterIndex("MOVE_STD_DEV"));
+    TEST_ASSERT_EQUAL(2, parameterIndex("MEETING_FACTOR"));
+    TEST_ASSERT_EQUAL(12, parameterIndex("GO_BACK_THRESHOLD_LOW"));
+    TEST_ASSERT_EQUAL(-1, parameterIndex("meeting_factor"));
+    TEST_ASSERT_EQUAL(-1, parameterIndex(NULL));
+    TEST_ASSERT_EQUAL_STRING("DEATH_THRESHOLD", parameterName(parameterIndex("DEATH_THRESHOLD")));
+    TEST_ASSERT_NULL(parameterName(PARAMETER_COUNT));
+}
+
+void test_parametersSet_should_set_valid_values(void) {
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, parametersSet(&params, parameterIndex("MEETING_FACTOR"), 1));
+    TEST_ASSERT_TRUE(fabs(1 - params.meetingFactor) < 1e-9);
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, parametersSet(&params, parameterIndex("INFECTION_TIME_MEAN"), 7.9));
+    TEST_ASSERT_EQUAL(7, params.infectionTimeMean);
+    TEST_ASSERT_TRUE(fabs(7 - parametersGet(&params, parameterIndex("INFECTION_TIME_MEAN"))) < 1e-9);
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, parametersSet(&params, parameterIndex("DEATH_THRESHOLD"), 0));
+    TEST_ASSERT_TRUE(fabs(0 - params.deathThreshold) < 1e-9);
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, parametersSet(&params, parameterIndex("DORMANT_DAYS"), 0));
+    TEST_ASSERT_EQUAL(0, params.dormantDays);
+}
+
+void test_parametersSet_should_reject_invalid_values(void) {
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, parametersSet(&params, parameterIndex("MEETING_FACTOR"), 0));
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, parametersSet(&params, parameterIndex("MEETING_FACTOR"), 1.5));
+    TEST_ASSERT_TRUE(fabs(0.2 - params.meetingFactor) < 1e-9);
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, parametersSet(&params, parameterIndex("INFECTION_TIME_MEAN"), 0.5));
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, parametersSet(&params, parameterIndex("INFECTION_TIME_MEAN"), 1e300));
+    TEST_ASSERT_EQUAL(14, params.infectionTimeMean);
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, parametersSet(&params, -1, 0.5));
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, parametersSet(NULL, 0, 0.5));
+}
+
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_parameterIndex_follows_parameters_cfg);
+    RUN_TEST(test_parametersSet_should_set_valid_values);
+    RUN_TEST(test_parametersSet_should_reject_invalid_values);
+    return UNITY_END();
+}
@@ -0,0 +1,62 @@
+#include <stdlib.h>
+#include <string.h>
+#include "Unity/src/unity.h"
+#include "../../C/simulation/metrics.h"
+
+void setUp(void) {
+    metricsReset();
+}
+
+void test_perfCountersRead_without_counters(void) {
+    long long values[PERF_COUNTER_COUNT];
+    int i;
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, perfCountersRead(values));
+    for (i = 0; i < PERF_COUNTER_COUNT; i++)
+        TEST_ASSERT_EQUAL(PERF_COUNTER_UNAVAILABLE, values[i]);
+}
+
+void test_perfCounters_count_work(void) {
+    long long before[PERF_COUNTER_COUNT], after[PERF_COUNTER_COUNT];
+    volatile long long sum = 0;
+    int i;
+
+    //hardware counters are not available on every machine (virtual machines)
+    if (!perfCountersOpen()) {
+        TEST_ASSERT_EQUAL(EXIT_FAILURE, perfCountersRead(before));
+        return;
+    }
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, perfCountersRead(before));
+    for (i = 0; i < 1000000; i++) sum += i;
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, perfCountersRead(after));
+
+    for (i = 0; i < PERF_COUNTER_COUNT; i++)
+        if (before[i] != PERF_COUNTER_UNAVAILABLE)
+            TEST_ASSERT_TRUE(after[i] >= before[i]);
+    if (before[PERF_COUNTER_INSTRUCTIONS] != PERF_COUNTER_UNAVAILABLE)
+        TEST_ASSERT_TRUE(after[PERF_COUNTER_INSTRUCTIONS] - before[PERF_COUNTER_INSTRUCTIONS] > 1000000);
+    perfCountersClose();
+}
+
+void test_metricsEnd_without_counters_reports_unavailable(void) {
+    char buffer[sizeof(METRICS_HEADER) + METRIC_COUNT * METRICS_MAX_ROW];
+    metricSample sample;
+
+    PERF_COUNTERS_ENABLED = 0;
+    metricsBegin(&sample);
+    metricsEnd(METRIC_STATUS_UPDATE, &sample);
+    TEST_ASSERT_EQUAL(1, atomic_load(&METRICS[METRIC_STATUS_UPDATE].count));
+
+    metricsFormat(buffer);
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "status_update,1,"));
+    TEST_ASSERT_NOT_NULL(strstr(buffer, ",-1,-1,-1,-1\n"));
+}
+
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_perfCountersRead_without_counters);
+    RUN_TEST(test_perfCounters_count_work);
+    RUN_TEST(test_metricsEnd_without_counters_reports_unavailable);
+    return UNITY_END();
+}
@@ -1,3 +1,4 @@
+#include <stdlib.h>
 #include "Unity/src/unity.h"
 #include "../../C/simulation/random.h"
 
@@ -87,6 +88,50 @@ void test_freeRandom(void) {
     TEST_ASSERT_NULL(rand);
 }
 
+void test_randomUseState_repeats_sequence(void) {
+    unsigned long long state;
+    int first[100], i;
+
+    randomSeed(&state, 7);
+    randomUseState(&state);
+    for (i = 0; i < 100; i++) {
+        first[i] = randomNext();
+        TEST_ASSERT_TRUE(first[i] >= 0 && first[i] <= RAND_MAX);
+    }
+
+    randomSeed(&state, 7);
+    for (i = 0; i < 100; i++) TEST_ASSERT_EQUAL(first[i], randomNext());
+    randomUseState(NULL);
+}
+
+void test_randomBinomial_should_follow_the_mean(void) {
+    unsigned long long state;
+    long long sum;
+    int i, value;
+
+    TEST_ASSERT_EQUAL(0, randomBinomial(0, 0.5));
+    TEST_ASSERT_EQUAL(0, randomBinomial(10, 0));
+    TEST_ASSERT_EQUAL(10, randomBinomial(10, 1));
+
+    randomSeed(&state, 3);
+    randomUseState(&state);
+    //exact draws
+    for (i = 0, sum = 0; i < 10000; i++) {
+        value = randomBinomial(100, 0.1);
+        TEST_ASSERT_TRUE(value >= 0 && value <= 100);
+        sum += value;
+    }
+    TEST_ASSERT_TRUE(sum > 9.8 * 10000 && sum < 10.2 * 10000);
+    //normal approximation of the failures
+    for (i = 0, sum = 0; i < 10000; i++) {
+        value = randomBinomial(1000, 0.6);
+        TEST_ASSERT_TRUE(value >= 0 && value <= 1000);
+        sum += value;
+    }
+    TEST_ASSERT_TRUE(sum > 599.0 * 10000 && sum < 601.0 * 10000);
+    randomUseState(NULL);
+}
+
 void tearDown(void) {}
 
 int main(void) {
@@ -103,5 +148,7 @@ int main(void) {
     RUN_TEST(test_nextNormalDistDoubleFaster_should_not_work_1);
     RUN_TEST(test_nextNormalDistDoubleFaster_should_not_work_2);
     RUN_TEST(test_freeRandom);
+    RUN_TEST(test_randomUseState_repeats_sequence);
+    RUN_TEST(test_randomBinomial_should_follow_the_mean);
     return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,40 @@
+#include <stdlib.h>
+#include "Unity/src/unity.h"
+#include "../../C/simulation/scenario.h"
+
+void setUp(void) {}
+
+void test_scenarioRequest_should_assign_ids(void) {
+    parameters params = {0};
+    scenario *theScenario;
+    int i;
+
+    params.meetingFactor = 0.01;
+    TEST_ASSERT_EQUAL(-1, scenarioRequest(NULL, &params, SCENARIO_DEF_DAYS));
+    TEST_ASSERT_EQUAL(-1, scenarioRequest("lockdown", NULL, SCENARIO_DEF_DAYS));
+    TEST_ASSERT_EQUAL(-1, scenarioRequest("lockdown", &params, 0));
+    TEST_ASSERT_EQUAL(1, scenarioRequest("a_very_long_name_of_the_lockdown_scenario", &params, 30));
+    TEST_ASSERT_EQUAL(1, scenarioCount());
+
+    theScenario = scenarioGet(1);
+    TEST_ASSERT_NOT_NULL(theScenario);
+    TEST_ASSERT_EQUAL(SCENARIO_NAME_LENGTH - 1, strlen(theScenario->name));
+    TEST_ASSERT_TRUE(theScenario->params.meetingFactor == 0.01);
+    TEST_ASSERT_EQUAL(30, theScenario->days);
+    TEST_ASSERT_EQUAL(-1, atomic_load(&theScenario->forkDay));
+    TEST_ASSERT_NULL(scenarioGet(0));
+    TEST_ASSERT_NULL(scenarioGet(2));
+
+    for (i = 2; i <= SCENARIO_MAX; i++) TEST_ASSERT_EQUAL(i, scenarioRequest("other", &params, SCENARIO_DEF_DAYS));
+    TEST_ASSERT_EQUAL(-1, scenarioRequest("one_too_many", &params, SCENARIO_DEF_DAYS));
+    TEST_ASSERT_EQUAL(SCENARIO_MAX, scenarioCount());
+    TEST_ASSERT_NULL(scenarioGet(SCENARIO_MAX + 1));
+}
+
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_scenarioRequest_should_assign_ids);
+    return UNITY_END();
+}
@@ -71,6 +71,171 @@ void test_freeCityDistance(void) {
     TEST_ASSERT_NULL(ctdst);
 }
 
+void test_cloneCountry_should_copy_citizens(void) {
+    country *ctry = createCountry(2), *clone;
+    citizen *prsn;
+    int i;
+
+    ctry->cities[0] = createCity(1, 1, 3, 1, 0, 0);
+    ctry->cities[1] = createCity(2, 1, 1, 0, 0, 0);
+    for (i = 0; i < 4; i++) {
+        prsn = createCitizen(i, i == 3);
+        prsn->status = i == 2 ? INFECTED : NORMAL;
+        prsn->timeFrame = (char) i;
+        hashTableAddElement(prsn, i, ctry->cities[i == 3]->citizens);
+    }
+    ctry->movedCitizensLength = 4;
+    ctry->movedCitizens = malloc(4);
+    ctry->params.meetingFactor = 0.5;
+
+    clone = cloneCountry(ctry);
+    TEST_ASSERT_NOT_NULL(clone);
+    TEST_ASSERT_EQUAL(4, clone->movedCitizensLength);
+    TEST_ASSERT_TRUE(clone->params.meetingFactor == 0.5);
+    TEST_ASSERT_EQUAL(3, clone->cities[0]->citizens->filledItems);
+    TEST_ASSERT_EQUAL(1, clone->cities[0]->infected);
+    //small city has only one list of the citizens
+    prsn = arrayListGetPointer(clone->cities[0]->citizens->array[0], 2);
+    TEST_ASSERT_TRUE(prsn != arrayListGetPointer(ctry->cities[0]->citizens->array[0], 2));
+    TEST_ASSERT_EQUAL(2, prsn->id);
+    TEST_ASSERT_EQUAL(INFECTED, prsn->status);
+    TEST_ASSERT_EQUAL(2, prsn->timeFrame);
+
+    //the copy is independent
+    prsn->status = RECOVERED;
+    prsn = arrayListGetPointer(ctry->cities[0]->citizens->array[0], 2);
+    TEST_ASSERT_EQUAL(INFECTED, prsn->status);
+    freeCountry(&clone);
+    freeCountry(&ctry);
+}
+
+void test_dormant_residents_should_be_kept_as_counts(void) {
+    country *ctry = createCountry(2);
+    citizen *prsn;
+    int i, locations[5] = {0, 0, 0, 1, 1}, homes[5] = {0, 0, 1, 1, 0};
+
+    ctry->cities[0] = createCity(1, 1, 3, 0, 0, 0);
+    ctry->cities[1] = createCity(2, 1, 2, 1, 0, 0);
+    for (i = 0; i < 5; i++) {
+        prsn = createCitizen(i, homes[i]);
+        prsn->status = i == 1 ? RECOVERED : i == 3 ? INFECTED : NORMAL;
+        hashTableAddElement(prsn, i, ctry->cities[locations[i]]->citizens);
+    }
+    ctry->params.dormantDays = 1;
+
+    //only the healthy resident at home in the city without infected
+    updateDormantCities(ctry);
+    TEST_ASSERT_EQUAL(1, ctry->cities[0]->dormantCount);
+    TEST_ASSERT_EQUAL(0, ctry->cities[0]->dormant[0]);
+    TEST_ASSERT_EQUAL(2, ctry->cities[0]->citizens->filledItems);
+    TEST_ASSERT_EQUAL(3, ctry->cities[0]->population);
+    TEST_ASSERT_EQUAL(0, ctry->cities[1]->dormantCount);
+    TEST_ASSERT_EQUAL(0, ctry->cities[1]->quietDays);
+
+    //healthy citizen coming home to the quiet city becomes a count, to the other one stays a citizen
+    goBackHome(ctry, 1);
+    TEST_ASSERT_EQUAL(2, ctry->cities[0]->dormantCount);
+    TEST_ASSERT_EQUAL(1, ctry->cities[0]->citizens->filledItems);
+    TEST_ASSERT_EQUAL(3, ctry->cities[0]->population);
+    TEST_ASSERT_EQUAL(2, ctry->cities[1]->citizens->filledItems);
+    TEST_ASSERT_EQUAL(2, ctry->cities[1]->population);
+
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, wakeCity(ctry->cities[0], 0));
+    TEST_ASSERT_EQUAL(0, ctry->cities[0]->dormantCount);
+    TEST_ASSERT_EQUAL(3, ctry->cities[0]->citizens->filledItems);
+    prsn = arrayListGetPointer(ctry->cities[0]->citizens->array[0], 2);
+    TEST_ASSERT_EQUAL(0, prsn->homeTown);
+    TEST_ASSERT_EQUAL(NORMAL, prsn->status);
+    freeCountry(&ctry);
+}
+
+void test_moveDormant_should_move_residents_kept_as_counts(void) {
+    country *ctry = createCountry(2);
+    GaussRandom *moveRandom = createRandom(1, 1);
+    citizen *prsn;
+    int i;
+
+    ctry->cities[0] = createCity(1, 1, 3, 0, 0, 0);
+    ctry->cities[1] = createCity(2, 1, 1, 0, 0, 0.1);
+    ctry->cities[0]->dormant = malloc(3 * sizeof(int));
+    for (i = 0; i < 3; i++) ctry->cities[0]->dormant[i] = i;
+    ctry->cities[0]->dormantCount = ctry->cities[0]->dormantCapacity = 3;
+    ctry->movedCitizensLength = 3;
+    ctry->movedCitizens = calloc(3, 1);
+    //every citizen moves
+    ctry->params.movingCitizens = 1;
+    computeDistances(0, ctry);
+    qsort(ctry->distances, 2, sizeof(cityDistance *), cmpCitiesByDistance);
+
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, moveDormant(ctry, 0, moveRandom));
+    TEST_ASSERT_EQUAL(0, ctry->cities[0]->dormantCount);
+    TEST_ASSERT_EQUAL(0, ctry->cities[0]->population);
+    TEST_ASSERT_EQUAL(3, ctry->cities[1]->citizens->filledItems);
+    TEST_ASSERT_EQUAL(4, ctry->cities[1]->population);
+    prsn = arrayListGetPointer(ctry->cities[1]->citizens->array[0], 0);
+    TEST_ASSERT_EQUAL(0, prsn->homeTown);
+    TEST_ASSERT_EQUAL(NORMAL, prsn->status);
+    TEST_ASSERT_EQUAL(1, ctry->movedCitizens[prsn->id]);
+    freeRandom(&moveRandom);
+    freeCountry(&ctry);
+}
+
+void test_nextActiveCity_should_skip_cities_without_infected(void) {
+    country *ctry = createCountry(70);
+    int i;
+
+    for (i = 0; i < 70; i++) ctry->cities[i] = createCity(i, 1, 1, i == 3, 0, 0);
+    ctry->cities[66]->recovered = 1;
+
+    TEST_ASSERT_EQUAL(3, nextActiveCity(ctry, 0));
+    TEST_ASSERT_EQUAL(66, nextActiveCity(ctry, 4));
+    TEST_ASSERT_EQUAL(70, nextActiveCity(ctry, 67));
+    TEST_ASSERT_EQUAL(70, nextActiveCity(ctry, 70));
+    //bits of the cities without infected or recovered were cleared
+    TEST_ASSERT_TRUE(ctry->activeCities[0] == 1ULL << 3);
+
+    ctry->cities[5]->infected = 1;
+    TEST_ASSERT_EQUAL(66, nextActiveCity(ctry, 4));
+    activateCity(ctry, 5);
+    TEST_ASSERT_EQUAL(5, nextActiveCity(ctry, 4));
+    freeCountry(&ctry);
+}
+
+void test_updateCitizenStatuses_should_remove_dead_citizens(void) {
+    country *ctry = createCountry(1);
+    citizen *prsn;
+    int i;
+
+    ctry->cities[0] = createCity(1, 1, 6, 3, 0, 0);
+    for (i = 0; i < 6; i++) {
+        prsn = createCitizen(i, 0);
+        prsn->status = i % 2 ? INFECTED : NORMAL;
+        hashTableAddElement(prsn, i, ctry->cities[0]->citizens);
+    }
+    ctry->params.infectionTimeMean = 100;
+    ctry->params.immunityTimeMean = 100;
+
+    ctry->params.deathThreshold = 0;
+    updateCitizenStatuses(ctry);
+    TEST_ASSERT_EQUAL(0, ctry->deaths);
+    TEST_ASSERT_EQUAL(3, ctry->cities[0]->infected);
+    prsn = arrayListGetPointer(ctry->cities[0]->citizens->array[0], 1);
+    TEST_ASSERT_EQUAL(1, prsn->timeFrame);
+
+    ctry->params.deathThreshold = 1;
+    updateCitizenStatuses(ctry);
+    TEST_ASSERT_EQUAL(3, ctry->deaths);
+    TEST_ASSERT_EQUAL(0, ctry->cities[0]->infected);
+    TEST_ASSERT_EQUAL(3, ctry->cities[0]->population);
+    TEST_ASSERT_EQUAL(3, ctry->cities[0]->citizens->filledItems);
+    //healthy citizens stay in their order
+    for (i = 0; i < 3; i++) {
+        prsn = arrayListGetPointer(ctry->cities[0]->citizens->array[0], i);
+        TEST_ASSERT_EQUAL(2 * i, prsn->id);
+    }
+    freeCountry(&ctry);
+}
+
 void tearDown(void) {}
 
 int main(void) {
@@ -86,5 +251,10 @@ int main(void) {
     RUN_TEST(test_freeCountry);
     RUN_TEST(test_createCityDistance);
     RUN_TEST(test_freeCityDistance);
+    RUN_TEST(test_cloneCountry_should_copy_citizens);
+    RUN_TEST(test_dormant_residents_should_be_kept_as_counts);
+    RUN_TEST(test_moveDormant_should_move_residents_kept_as_counts);
+    RUN_TEST(test_nextActiveCity_should_skip_cities_without_infected);
+    RUN_TEST(test_updateCitizenStatuses_should_remove_dead_citizens);
     return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include <stdlib.h>
+#include <math.h>
+#include "Unity/src/unity.h"
+#include "../../C/simulation/spatialGrid.h"
+
+#define CITIES 400
+
+double lat[CITIES], lon[CITIES];
+int population[CITIES], infected[CITIES];
+
+void setUp(void) {
+    int i;
+    //cities on 20 x 20 regular grid, latitude 49.00 .. 49.95, longitude 14.00 .. 14.95
+    for (i = 0; i < CITIES; i++) {
+        lat[i] = 49 + (i / 20) * 0.05;
+        lon[i] = 14 + (i % 20) * 0.05;
+        population[i] = 100;
+        infected[i] = i;
+    }
+}
+
+void test_spatialGridCities_in_box(void) {
+    int cities[CITIES], count, i;
+    spatialGrid *grid = createSpatialGrid(CITIES, lat, lon);
+    TEST_ASSERT_NOT_NULL(grid);
+
+    //rows 2 .. 4 and columns 10 .. 11
+    count = spatialGridCities(grid, 49.09, 14.49, 49.21, 14.56, cities);
+    TEST_ASSERT_EQUAL(6, count);
+    for (i = 0; i < count; i++) {
+        TEST_ASSERT_TRUE(cities[i] / 20 >= 2 && cities[i] / 20 <= 4);
+        TEST_ASSERT_TRUE(cities[i] % 20 >= 10 && cities[i] % 20 <= 11);
+    }
+
+    //corners in any order
+    TEST_ASSERT_EQUAL(6, spatialGridCities(grid, 49.21, 14.56, 49.09, 14.49, cities));
+    TEST_ASSERT_EQUAL(CITIES, spatialGridCities(grid, 40, 10, 60, 20, cities));
+    TEST_ASSERT_EQUAL(0, spatialGridCities(grid, 50.5, 14, 51, 15, cities));
+    freeSpatialGrid(&grid);
+    TEST_ASSERT_NULL(grid);
+}
+
+void test_spatialGridCells_levels(void) {
+    spatialCell cells[CITIES];
+    long long infectedSum = 0;
+    int count, i, cities = 0;
+    spatialGrid *grid = createSpatialGrid(CITIES, lat, lon);
+
+    //the coarsest level - one cell with all the cities
+    count = spatialGridCells(grid, 40, 10, 60, 20, SPATIAL_GRID_LEVELS, population, infected, cells);
+    TEST_ASSERT_EQUAL(1, count);
+    TEST_ASSERT_EQUAL(CITIES, cells[0].cities);
+    TEST_ASSERT_EQUAL(100 * CITIES, cells[0].population);
+    TEST_ASSERT_EQUAL(CITIES * (CITIES - 1) / 2, cells[0].infected);
+    TEST_ASSERT_TRUE(fabs(cells[0].lat - 49.475) < 0.001);
+    TEST_ASSERT_TRUE(fabs(cells[0].lon - 14.475) < 0.001);
+
+    //every city is in exactly one cell of the level
+    count = spatialGridCells(grid, 40, 10, 60, 20, 3, population, infected, cells);
+    TEST_ASSERT_TRUE(count > 1);
+    for (i = 0; i < count; i++) {
+        cities += cells[i].cities;
+        infectedSum += cells[i].infected;
+    }
+    TEST_ASSERT_EQUAL(CITIES, cities);
+    TEST_ASSERT_EQUAL(CITIES * (CITIES - 1) / 2, infectedSum);
+
+    //smaller box - fewer cells
+    TEST_ASSERT_TRUE(spatialGridCells(grid, 49, 14, 49.1, 14.1, 3, population, infected, cells) < count);
+    TEST_ASSERT_EQUAL(-1, spatialGridCells(grid, 40, 10, 60, 20, 0, population, infected, cells));
+    freeSpatialGrid(&grid);
+}
+
+void test_createSpatialGrid_should_not_create(void) {
+    TEST_ASSERT_NULL(createSpatialGrid(0, lat, lon));
+    TEST_ASSERT_NULL(createSpatialGrid(CITIES, NULL, lon));
+}
+
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_spatialGridCities_in_box);
+    RUN_TEST(test_spatialGridCells_levels);
+    RUN_TEST(test_createSpatialGrid_should_not_create);
+    return UNITY_END();
+}
@@ -0,0 +1,103 @@
+#include <stdlib.h>
+#include <string.h>
+#include "Unity/src/unity.h"
+#include "../../C/simulation/statistics.h"
+
+#define CITIES 50
+
+const char CODES[2][DISTRICT_CODE_LENGTH] = {"CZ0201", "CZ0202"};
+
+void setUp(void) {}
+
+static statistics *createTestStatistics(void) {
+    int districts[CITIES], i;
+    //first half of the cities in the first district, the last city without district
+    for (i = 0; i < CITIES; i++) districts[i] = i < CITIES / 2 ? 0 : 1;
+    districts[CITIES - 1] = -1;
+    return createStatistics(CITIES, districts, CODES, 2);
+}
+
+void test_statisticsAdd_aggregates(void) {
+    int population[CITIES], infected[CITIES], i;
+    const dayStatistics *day;
+    statistics *stats = createTestStatistics();
+    TEST_ASSERT_NOT_NULL(stats);
+
+    for (i = 0; i < CITIES; i++) {
+        population[i] = 100;
+        infected[i] = i;
+    }
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, statisticsAdd(stats, 0, population, infected, 5, 6, 7));
+    TEST_ASSERT_EQUAL(1, statisticsDays(stats));
+
+    day = statisticsGet(stats, 0);
+    TEST_ASSERT_NOT_NULL(day);
+    TEST_ASSERT_EQUAL(100 * CITIES, day->population);
+    TEST_ASSERT_EQUAL(CITIES * (CITIES - 1) / 2, day->infected);
+    TEST_ASSERT_EQUAL(5, day->newInfected);
+    TEST_ASSERT_EQUAL(6, day->recovered);
+    TEST_ASSERT_EQUAL(7, day->deaths);
+
+    TEST_ASSERT_EQUAL(STATISTICS_TOP_K, day->topCount);
+    for (i = 0; i < STATISTICS_TOP_K; i++) {
+        TEST_ASSERT_EQUAL(CITIES - 1 - i, day->topCities[i]);
+        TEST_ASSERT_EQUAL(CITIES - 1 - i, day->topInfected[i]);
+    }
+
+    TEST_ASSERT_EQUAL(100 * (CITIES / 2), day->districtPopulation[0]);
+    TEST_ASSERT_EQUAL(100 * (CITIES / 2 - 1), day->districtPopulation[1]);
+    TEST_ASSERT_EQUAL((CITIES / 2) * (CITIES / 2 - 1) / 2, day->districtInfected[0]);
+    freeStatistics(&stats);
+    TEST_ASSERT_NULL(stats);
+}
+
+void test_statisticsAdd_days_in_order(void) {
+    int population[CITIES] = {0}, infected[CITIES] = {0};
+    statistics *stats = createTestStatistics();
+
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, statisticsAdd(stats, 0, population, infected, 0, 0, 0));
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, statisticsAdd(stats, 0, population, infected, 0, 0, 0));
+    //skipped days are missing
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, statisticsAdd(stats, 3, population, infected, 0, 0, 0));
+    TEST_ASSERT_EQUAL(4, statisticsDays(stats));
+    TEST_ASSERT_NULL(statisticsGet(stats, 1));
+    TEST_ASSERT_NULL(statisticsGet(stats, 2));
+    TEST_ASSERT_NOT_NULL(statisticsGet(stats, 3));
+    TEST_ASSERT_NULL(statisticsGet(stats, 4));
+    freeStatistics(&stats);
+}
+
+void test_statisticsAdd_more_blocks(void) {
+    int population[CITIES] = {0}, infected[CITIES] = {0}, date;
+    statistics *stats = createTestStatistics();
+
+    for (date = 0; date < 3 * STATISTICS_BLOCK_DAYS; date++) {
+        infected[0] = date;
+        TEST_ASSERT_EQUAL(EXIT_SUCCESS, statisticsAdd(stats, date, population, infected, date, 0, 0));
+    }
+    TEST_ASSERT_EQUAL(STATISTICS_BLOCK_DAYS + 1, statisticsGet(stats, STATISTICS_BLOCK_DAYS + 1)->infected);
+    TEST_ASSERT_EQUAL(2 * STATISTICS_BLOCK_DAYS, statisticsGet(stats, 2 * STATISTICS_BLOCK_DAYS)->newInfected);
+    freeStatistics(&stats);
+}
+
+void test_createStatistics_should_not_create(void) {
+    int districts[CITIES] = {0};
+    statistics *stats;
+    TEST_ASSERT_NULL(createStatistics(0, districts, CODES, 2));
+    TEST_ASSERT_NULL(createStatistics(CITIES, NULL, CODES, 2));
+    //no districts are allowed
+    stats = createStatistics(CITIES, NULL, NULL, 0);
+    TEST_ASSERT_NOT_NULL(stats);
+    freeStatistics(&stats);
+}
+
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_statisticsAdd_aggregates);
+    RUN_TEST(test_statisticsAdd_days_in_order);
+    RUN_TEST(test_statisticsAdd_more_blocks);
+    RUN_TEST(test_createStatistics_should_not_create);
+    return UNITY_END();
+}
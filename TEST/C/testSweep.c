@@ -0,0 +1,112 @@
+#include <stdlib.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "Unity/src/unity.h"
+#include "../../C/simulation/sweep.h"
+#include "../../C/simulation/fileManager.h"
+
+#define DAYS 2
+
+country *geography;
+
+void setUp(void) {
+    FILE *fp = fopen("test.csv", "w");
+    fprintf(fp, "nazev_obce,kod_obce,latitude,longitude,vymera,pocet_obyvatel,pocet_nakazenych,datum\n");
+    fprintf(fp, "A,1,49.5,14.5,10.0,2000,50,0\nB,2,49.6,14.7,5.0,800,0,0\nC,3,50.0,15.0,20.0,1200,10,0\n");
+    fclose(fp);
+
+    load_parameters("../../parameters.cfg");
+    geography = create_country_from_csv("test.csv", 0);
+    remove("test.csv");
+}
+
+void test_sweepAddDimension_should_count_points(void) {
+    sweep *theSweep = createSweep(geography, DAYS, 1);
+
+    TEST_ASSERT_NOT_NULL(theSweep);
+    TEST_ASSERT_EQUAL(1, theSweep->points);
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, sweepAddDimension(theSweep, "MEETING_FACTOR=0.1:0.5:0.1"));
+    TEST_ASSERT_EQUAL(5, theSweep->points);
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, sweepAddDimension(theSweep, "DEATH_THRESHOLD=0,0.5"));
+    TEST_ASSERT_EQUAL(10, theSweep->points);
+    TEST_ASSERT_TRUE(fabs(0.5 - theSweep->dimension[0].values[4]) < 1e-9);
+    freeSweep(&theSweep);
+    TEST_ASSERT_NULL(theSweep);
+}
+
+void test_sweepAddDimension_should_reject_invalid(void) {
+    sweep *theSweep = createSweep(geography, DAYS, 1);
+
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, sweepAddDimension(theSweep, "UNKNOWN=1"));
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, sweepAddDimension(theSweep, "MEETING_FACTOR"));
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, sweepAddDimension(theSweep, "MEETING_FACTOR=0:1:0.5"));
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, sweepAddDimension(theSweep, "MEETING_FACTOR=0.5:0.1:0.1"));
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, sweepAddDimension(theSweep, "MEETING_FACTOR=0.1,,0.2"));
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, sweepAddDimension(theSweep, "MEETING_FACTOR=0.1,0.2"));
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, sweepAddDimension(theSweep, "MEETING_FACTOR=0.3"));
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, sweepAddDimension(theSweep, "MOVE_MEAN=1:1000000:1"));
+    TEST_ASSERT_EQUAL(2, theSweep->points);
+    freeSweep(&theSweep);
+}
+
+void test_sweepRun_does_not_depend_on_threads(void) {
+    sweep *single = createSweep(geography, DAYS, 3);
+    sweep *pool = createSweep(geography, DAYS, 3);
+    int point;
+
+    sweepAddDimension(single, "MEETING_FACTOR=0.1,0.9");
+    sweepAddDimension(single, "DEATH_THRESHOLD=0:0.5:0.25");
+    sweepAddDimension(pool, "MEETING_FACTOR=0.1,0.9");
+    sweepAddDimension(pool, "DEATH_THRESHOLD=0:0.5:0.25");
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, sweepRun(single, 1));
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, sweepRun(pool, 4));
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, sweepRun(pool, 4));
+
+    for (point = 0; point < 6; point++) {
+        TEST_ASSERT_TRUE(single->results[point].infected >= 0);
+        TEST_ASSERT_EQUAL(single->results[point].infected, pool->results[point].infected);
+        TEST_ASSERT_EQUAL(single->results[point].peakInfected, pool->results[point].peakInfected);
+        TEST_ASSERT_EQUAL(single->results[point].newInfected, pool->results[point].newInfected);
+        TEST_ASSERT_EQUAL(single->results[point].deaths, pool->results[point].deaths);
+    }
+    /* the last dimension changes the fastest */
+    TEST_ASSERT_TRUE(fabs(0.1 - pool->results[2].params.meetingFactor) < 1e-9);
+    TEST_ASSERT_TRUE(fabs(0.5 - pool->results[2].params.deathThreshold) < 1e-9);
+    TEST_ASSERT_TRUE(fabs(0.9 - pool->results[3].params.meetingFactor) < 1e-9);
+    TEST_ASSERT_EQUAL(0, pool->results[3].deaths);
+    TEST_ASSERT_TRUE(fabs(geography->params.spreadMean - pool->results[3].params.spreadMean) < 1e-9);
+    freeSweep(&single);
+    freeSweep(&pool);
+}
+
+void test_sweepWriteResults(void) {
+    sweep *theSweep = createSweep(geography, DAYS, 3);
+    char line[256];
+    FILE *fp = tmpfile();
+
+    sweepAddDimension(theSweep, "MEETING_FACTOR=0.25");
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, sweepWriteResults(theSweep, fp));
+    sweepRun(theSweep, 2);
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, sweepWriteResults(theSweep, fp));
+    rewind(fp);
+    fgets(line, sizeof(line), fp);
+    TEST_ASSERT_EQUAL_STRING("point,MEETING_FACTOR,population,infected,peak_infected,peak_day,new_infected,recovered,deaths,setup_seconds,run_seconds\n", line);
+    fgets(line, sizeof(line), fp);
+    TEST_ASSERT_EQUAL(0, strncmp(line, "0,0.25,", 7));
+    fclose(fp);
+    freeSweep(&theSweep);
+}
+
+void tearDown(void) {
+    freeCountry(&geography);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_sweepAddDimension_should_count_points);
+    RUN_TEST(test_sweepAddDimension_should_reject_invalid);
+    RUN_TEST(test_sweepRun_does_not_depend_on_threads);
+    RUN_TEST(test_sweepWriteResults);
+    return UNITY_END();
+}
@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "Unity/src/unity.h"
+#include "../../C/simulation/trace.h"
+
+#define TEST_TRACE "test_trace.json"
+#define EVENTS (TRACE_BUFFER_EVENTS + 100)
+
+void setUp(void) {}
+
+static int countInFile(const char *text) {
+    char line[256];
+    int count = 0;
+    FILE *file = fopen(TEST_TRACE, "r");
+    if (!file) return -1;
+    while (fgets(line, sizeof(line), file))
+        if (strstr(line, text)) count++;
+    fclose(file);
+    return count;
+}
+
+static void *traceDays(void *arg) {
+    int i;
+    for (i = 0; i < EVENTS / 2; i++) {
+        TRACE_BEGIN_VALUE("day", i);
+        TRACE_END("day");
+    }
+    traceFlush();
+    return NULL;
+}
+
+void test_trace_disabled_records_nothing(void) {
+    TEST_ASSERT_EQUAL(0, TRACE_ENABLED);
+    TRACE_BEGIN("day");
+    TRACE_END("day");
+    TEST_ASSERT_EQUAL(-1, countInFile("\"day\""));
+}
+
+void test_trace_writes_events_of_all_threads(void) {
+    pthread_t thread;
+    TEST_ASSERT_EQUAL(EXIT_SUCCESS, traceOpen(TEST_TRACE));
+    TEST_ASSERT_EQUAL(1, TRACE_ENABLED);
+
+    pthread_create(&thread, NULL, traceDays, NULL);
+    pthread_join(thread, NULL);
+    TRACE_BEGIN("command");
+    TRACE_END("command");
+    traceClose();
+
+    TEST_ASSERT_EQUAL(EVENTS / 2, countInFile("\"name\":\"day\",\"ph\":\"B\""));
+    TEST_ASSERT_EQUAL(EVENTS / 2, countInFile("\"name\":\"day\",\"ph\":\"E\""));
+    TEST_ASSERT_EQUAL(1, countInFile("\"args\":{\"value\":7}"));
+    TEST_ASSERT_EQUAL(2, countInFile("\"name\":\"command\""));
+    TEST_ASSERT_EQUAL(1, countInFile("]"));
+}
+
+void test_traceOpen_should_fail(void) {
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, traceOpen("non-existant/trace.json"));
+}
+
+void tearDown(void) {
+    remove(TEST_TRACE);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_trace_disabled_records_nothing);
+    RUN_TEST(test_trace_writes_events_of_all_threads);
+    RUN_TEST(test_traceOpen_should_fail);
+    return UNITY_END();
+}